@@ -57,10 +57,10 @@ string AudioCfgInfo::ConfigBlock::toString() const {
 AudioCfgInfo::AudioCfgInfo(void)
     : minNumAudioFrames(0x00),
       maxNumAudioFrames(0xFF),
-      currentNumAudioFrames(0x00, minNumAudioFrames, maxNumAudioFrames),
+      currentNumAudioFrames(0x00, minNumAudioFrames(), maxNumAudioFrames()),
       minAllowedSyncFactor(0x00),
       maxAllowedSyncFactor(0xFF),
-      currentSyncFactor(0x01, minAllowedSyncFactor, maxAllowedSyncFactor),
+      currentSyncFactor(0x01, minAllowedSyncFactor(), maxAllowedSyncFactor()),
       currentActiveConfig(0x00),
       configBlocks() {}
 
@@ -92,15 +92,18 @@ void AudioCfgInfo::parse(BytesIter &beginIter, BytesIter &endIter) {
   if (version == versionNumber()) {
     minNumAudioFrames = roByte(nextMidiByte(beginIter, endIter));
     maxNumAudioFrames = roByte(nextMidiByte(beginIter, endIter));
-    currentNumAudioFrames = rwByte(nextMidiByte(beginIter, endIter),
-                                   minNumAudioFrames, maxNumAudioFrames);
+    currentNumAudioFrames =
+        rangedByte(nextMidiByte(beginIter, endIter), minNumAudioFrames(),
+                   maxNumAudioFrames());
     minAllowedSyncFactor = roByte(nextMidiByte(beginIter, endIter));
     maxAllowedSyncFactor = roByte(nextMidiByte(beginIter, endIter));
-    currentSyncFactor = rwByte(nextMidiByte(beginIter, endIter),
-                               minAllowedSyncFactor, maxAllowedSyncFactor);
+    currentSyncFactor =
+        rangedByte(nextMidiByte(beginIter, endIter), minAllowedSyncFactor(),
+                   maxAllowedSyncFactor());
     currentActiveConfig = rwByte(nextMidiByte(beginIter, endIter));
 
     auto tempNumConfigBlocks = nextMidiByte(beginIter, endIter);
+    configBlocks.clear();
     for (auto i = 0; i < tempNumConfigBlocks; ++i) {
       configBlocks.push_back(
           AudioCfgInfo::ConfigBlock::parseConfigBlock(beginIter, endIter));
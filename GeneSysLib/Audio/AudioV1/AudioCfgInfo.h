@@ -47,11 +47,11 @@ struct AudioCfgInfo {
   Byte versionNumber() const;
   roByte minNumAudioFrames;
   roByte maxNumAudioFrames;
-  rwByte currentNumAudioFrames;
+  rangedByte currentNumAudioFrames;
 
   roByte minAllowedSyncFactor;
   roByte maxAllowedSyncFactor;
-  rwByte currentSyncFactor;
+  rangedByte currentSyncFactor;
 
   rwByte currentActiveConfig;
 
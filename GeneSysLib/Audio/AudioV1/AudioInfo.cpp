@@ -8,9 +8,19 @@
 #include "stdafx.h"
 #include "AudioInfo.h"
 #include "Generator.h"
+#include "WireSchema.h"
 
 namespace GeneSysLib {
 
+struct AudioInfo::Layout
+    : Wire::Schema<Wire::Version<0x01>,
+                   WIRE_FIELD(MidiWord, AudioInfo, numberOfAudioPorts),
+                   WIRE_FIELD(Byte, AudioInfo, numberOfUSBDeviceJacks),
+                   WIRE_FIELD(Byte, AudioInfo, numberOfUSBHostJacks),
+                   WIRE_FIELD(Byte, AudioInfo, numberOfPortsPerUSBHostJack),
+                   WIRE_FIELD(Byte, AudioInfo, numberOfPortsPerEthernetJack)> {
+};
+
 CmdEnum AudioInfo::retCommand() { return Command::RetAudioInfo; }
 
 AudioInfo::AudioInfo(void)
@@ -27,27 +37,13 @@ const commandDataKey_t AudioInfo::key() const {
 
 Bytes AudioInfo::generate() const {
   Bytes result;
-
-  result += versionNumber();
-  appendMidiWord(result, numberOfAudioPorts());
-  result += numberOfUSBDeviceJacks();
-  result += numberOfUSBHostJacks();
-  result += numberOfPortsPerUSBHostJack();
-  result += numberOfPortsPerEthernetJack();
-
+  Layout::generate(*this, result);
   return result;
 }
 
 void AudioInfo::parse(BytesIter &begin, BytesIter &end) {
-  const auto &version = nextMidiByte(begin, end);
   // only handle version 1
-  if (version == versionNumber()) {
-    numberOfAudioPorts = roWord(nextMidiWord(begin, end));
-    numberOfUSBDeviceJacks = roByte(nextMidiByte(begin, end));
-    numberOfUSBHostJacks = roByte(nextMidiByte(begin, end));
-    numberOfPortsPerUSBHostJack = roByte(nextMidiByte(begin, end));
-    numberOfPortsPerEthernetJack = roByte(nextMidiByte(begin, end));
-  }
+  Layout::parse(*this, begin, end);
 }
 
 Byte AudioInfo::versionNumber() const { return 0x01; }
@@ -33,6 +33,9 @@ struct AudioInfo {
   roByte numberOfEthernetJacks;
   roByte numberOfPortsPerUSBHostJack;
   roByte numberOfPortsPerEthernetJack;
+
+ private:
+  struct Layout;
 };  // struct AudioInfo
 
 typedef SysexCommand<Command::GetAudioInfo, EmptyCommandData>
@@ -8,21 +8,30 @@
 #include "stdafx.h"
 #include "AudioPortPatchbay.h"
 #include "Generator.h"
+#include "WireSchema.h"
 #include <iterator>
-#ifndef Q_MOC_RUN
-#include <boost/range.hpp>
-#include <boost/range/algorithm_ext.hpp>
-#endif
 #include <algorithm>
 #include <limits>
 
-using boost::range::push_back;
-
 using namespace boost;
 using namespace std;
 
 namespace GeneSysLib {
 
+namespace {
+
+typedef Wire::Schema<
+    WIRE_FIELD(Byte, AudioPortPatchbay::ConfigBlock, inputChannelNumber),
+    WIRE_FIELD(Byte, AudioPortPatchbay::ConfigBlock, outputChannelNumber),
+    WIRE_FIELD(MidiWord, AudioPortPatchbay::ConfigBlock, portIDOfOutput)>
+    ConfigBlockLayout;
+
+}  // namespace
+
+struct AudioPortPatchbay::Layout
+    : Wire::Schema<Wire::Version<0x01>,
+                   WIRE_FIELD(MidiWord, AudioPortPatchbay, portID)> {};
+
 commandDataKey_t AudioPortPatchbay::minKey() {
   return generateKey(Command::RetAudioPortPatchbay);
 }
@@ -45,20 +54,13 @@ CmdEnum AudioPortPatchbay::setCommand() {
 
 Bytes AudioPortPatchbay::ConfigBlock::generate() const {
   Bytes result;
-
-  result += inputChannelNumber();
-  result += outputChannelNumber();
-
-  appendMidiWord(result, portIDOfOutput());
-
+  ConfigBlockLayout::generate(*this, result);
   return result;
 }
 
 void AudioPortPatchbay::ConfigBlock::parse(BytesIter &beginIter,
                                            BytesIter &endIter) {
-  inputChannelNumber = roByte(nextMidiByte(beginIter, endIter));
-  outputChannelNumber = rwByte(nextMidiByte(beginIter, endIter));
-  portIDOfOutput = rwWord(nextMidiWord(beginIter, endIter));
+  ConfigBlockLayout::parse(*this, beginIter, endIter);
 }
 
 AudioPortPatchbay::AudioPortPatchbay(void) : configBlocks() {}
@@ -70,31 +72,19 @@ const commandDataKey_t AudioPortPatchbay::key() const {
 Bytes AudioPortPatchbay::generate() const {
   Bytes result;
 
-  result += versionNumber() & 0x7F;
-  appendMidiWord(result, portID());
+  Layout::generate(*this, result,
+                   1 + configBlocks.size() * ConfigBlockLayout::size);
   result += configBlocks.size() & 0x7F;
-
-  for (const auto &config : configBlocks) {
-    push_back(result, config.generate());
-  }
+  Wire::generateBlocks<ConfigBlockLayout>(configBlocks, result);
 
   return result;
 }
 
 void AudioPortPatchbay::parse(BytesIter &beginIter, BytesIter &endIter) {
-  auto version = nextMidiByte(beginIter, endIter);
-
-  if (version == versionNumber()) {
-    portID = roWord(nextMidiWord(beginIter, endIter));
-
+  if (Layout::parse(*this, beginIter, endIter)) {
     Byte numBlocks = nextMidiByte(beginIter, endIter);
-
-    configBlocks.clear();
-    for (auto i = 0; i < numBlocks; ++i) {
-      ConfigBlock config;
-      config.parse(beginIter, endIter);
-      configBlocks.push_back(config);
-    }
+    Wire::parseBlocks<ConfigBlockLayout>(configBlocks, numBlocks, beginIter,
+                                         endIter);
   }
 }
 
@@ -67,6 +67,8 @@ struct AudioPortPatchbay {
   FlatAudioPortPatchbay flatPatchbay(Byte inChannelNumber) const;
 
  private:
+  struct Layout;
+
   std::vector<ConfigBlock> configBlocks;
 };  // struct AudioPortPatchbay
 
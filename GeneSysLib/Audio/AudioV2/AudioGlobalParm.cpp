@@ -63,10 +63,10 @@ AudioGlobalParm::AudioGlobalParm(void)
     : numAudioPorts(),
       minAudioFrames(),
       maxAudioFrames(),
-      currentAudioFrames(minAudioFrames, maxAudioFrames),
+      currentAudioFrames(minAudioFrames(), maxAudioFrames()),
       minSyncFactor(),
       maxSyncFactor(),
-      currentSyncFactor(minSyncFactor, maxSyncFactor),
+      currentSyncFactor(minSyncFactor(), maxSyncFactor()),
       currentActiveConfig(),
       m_configBlocks() {}
 
@@ -101,12 +101,12 @@ void AudioGlobalParm::parse(BytesIter &beginIter, BytesIter &endIter) {
     numAudioPorts = roWord(nextMidiWord(beginIter, endIter));
     minAudioFrames = roByte(nextMidiByte(beginIter, endIter));
     maxAudioFrames = roByte(nextMidiByte(beginIter, endIter));
-    currentAudioFrames = rwByte(nextMidiByte(beginIter, endIter),
-                                minAudioFrames, maxAudioFrames);
+    currentAudioFrames = rangedByte(nextMidiByte(beginIter, endIter),
+                                    minAudioFrames(), maxAudioFrames());
     minSyncFactor = roByte(nextMidiByte(beginIter, endIter));
     maxSyncFactor = roByte(nextMidiByte(beginIter, endIter));
-    currentSyncFactor =
-        rwByte(nextMidiByte(beginIter, endIter), minSyncFactor, maxSyncFactor);
+    currentSyncFactor = rangedByte(nextMidiByte(beginIter, endIter),
+                                   minSyncFactor(), maxSyncFactor());
     currentActiveConfig = rwByte(nextMidiByte(beginIter, endIter));
 
     const auto &tempNumConfigBlocks = nextMidiByte(beginIter, endIter);
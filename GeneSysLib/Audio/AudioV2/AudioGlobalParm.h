@@ -50,11 +50,11 @@ struct AudioGlobalParm {
 
   roByte minAudioFrames;
   roByte maxAudioFrames;
-  rwByte currentAudioFrames;
+  rangedByte currentAudioFrames;
 
   roByte minSyncFactor;
   roByte maxSyncFactor;
-  rwByte currentSyncFactor;
+  rangedByte currentSyncFactor;
 
   rwByte currentActiveConfig;
 
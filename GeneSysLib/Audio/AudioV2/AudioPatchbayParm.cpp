@@ -8,21 +8,30 @@
 #include "stdafx.h"
 #include "AudioPatchbayParm.h"
 #include "Generator.h"
+#include "WireSchema.h"
 #include <iterator>
-#ifndef Q_MOC_RUN
-#include <boost/range.hpp>
-#include <boost/range/algorithm_ext.hpp>
-#endif
 #include <algorithm>
 #include <limits>
 
-using boost::range::push_back;
-
 using namespace boost;
 using namespace std;
 
 namespace GeneSysLib {
 
+namespace {
+
+typedef Wire::Schema<
+    WIRE_FIELD(Byte, AudioPatchbayParm::ConfigBlock, inputChannelNumber),
+    WIRE_FIELD(Byte, AudioPatchbayParm::ConfigBlock, outputChannelNumber),
+    WIRE_FIELD(MidiWord, AudioPatchbayParm::ConfigBlock, portIDOfOutput)>
+    ConfigBlockLayout;
+
+}  // namespace
+
+struct AudioPatchbayParm::Layout
+    : Wire::Schema<Wire::Version<0x01>,
+                   WIRE_FIELD(MidiWord, AudioPatchbayParm, audioPortID)> {};
+
 commandDataKey_t AudioPatchbayParm::minKey() {
   return generateKey(Command::RetAudioPatchbayParm);
 }
@@ -45,20 +54,13 @@ CmdEnum AudioPatchbayParm::setCommand() {
 
 Bytes AudioPatchbayParm::ConfigBlock::generate() const {
   Bytes result;
-
-  result += inputChannelNumber();
-  result += outputChannelNumber();
-
-  appendMidiWord(result, portIDOfOutput());
-
+  ConfigBlockLayout::generate(*this, result);
   return result;
 }
 
 void AudioPatchbayParm::ConfigBlock::parse(BytesIter &beginIter,
                                            BytesIter &endIter) {
-  inputChannelNumber = roByte(nextMidiByte(beginIter, endIter));
-  outputChannelNumber = rwByte(nextMidiByte(beginIter, endIter));
-  portIDOfOutput = rwWord(nextMidiWord(beginIter, endIter));
+  ConfigBlockLayout::parse(*this, beginIter, endIter);
 }
 
 AudioPatchbayParm::AudioPatchbayParm(void) : configBlocks() {}
@@ -70,31 +72,19 @@ const commandDataKey_t AudioPatchbayParm::key() const {
 Bytes AudioPatchbayParm::generate() const {
   Bytes result;
 
-  result += versionNumber() & 0x7F;
-  appendMidiWord(result, audioPortID());
+  Layout::generate(*this, result,
+                   1 + configBlocks.size() * ConfigBlockLayout::size);
   result += configBlocks.size() & 0x7F;
-
-  for (const auto &config : configBlocks) {
-    push_back(result, config.generate());
-  }
+  Wire::generateBlocks<ConfigBlockLayout>(configBlocks, result);
 
   return result;
 }
 
 void AudioPatchbayParm::parse(BytesIter &beginIter, BytesIter &endIter) {
-  auto version = nextMidiByte(beginIter, endIter);
-
-  if (version == versionNumber()) {
-    audioPortID = roWord(nextMidiWord(beginIter, endIter));
-
+  if (Layout::parse(*this, beginIter, endIter)) {
     Byte numBlocks = nextMidiByte(beginIter, endIter);
-
-    configBlocks.clear();
-    for (auto i = 0; i < numBlocks; ++i) {
-      ConfigBlock config;
-      config.parse(beginIter, endIter);
-      configBlocks.push_back(config);
-    }
+    Wire::parseBlocks<ConfigBlockLayout>(configBlocks, numBlocks, beginIter,
+                                         endIter);
   }
 }
 
@@ -68,6 +68,8 @@ struct AudioPatchbayParm {
   FlatAudioPatchbayParm flatPatchbay(Byte inChannelNumber) const;
 
  private:
+  struct Layout;
+
   std::vector<ConfigBlock> configBlocks;
 };  // struct AudioPatchbayParm
 
@@ -9,13 +9,6 @@
 #include "AudioPortMeterValue.h"
 #include <limits>
 
-#ifdef __IOS__
-NSLock *audioMeterLock = nil;
-#else
-#include <QMutex>
-QMutex audioMeterMutex;
-#endif
-
 using namespace boost;
 using namespace std;
 
@@ -55,74 +48,14 @@ Bytes AudioPortMeterValue::generate() const {
 void AudioPortMeterValue::parse(BytesIter &beginIter, BytesIter &endIter) {
   Byte version = nextMidiByte(beginIter, endIter);
 
-#ifdef __IOS__
-  if (audioMeterLock == nil) {
-    audioMeterLock = [[NSLock alloc] init];
-  }
-#endif
-  
   if (version == versionNumber()) {
-#ifdef __IOS__
-    [audioMeterLock lock];
-    //NSLog(@"AudioPortMeter parse start");
-#else
-    audioMeterMutex.lock();
-#endif
     audioPortID = roWord(nextMidiWord(beginIter, endIter));
-    if (meterBlocks) {
-      for (int i = 0; i < meterBlockCount(); i++) {
-        if (meterBlocks[i].meterValues) {
-          free(meterBlocks[i].meterValues);
-        }
-      }
-      free(meterBlocks);
-    }
-    meterBlockCount = roByte(nextMidiByte(beginIter, endIter));
-    meterBlocks = (MeterBlock*) calloc(meterBlockCount(), sizeof(MeterBlock));
-
-    for (int i = 0; i < meterBlockCount(); i++) {
-      MeterBlock mb;
-      mb.meterType = std::bitset<8>(nextMidiByte(beginIter, endIter));
-      mb.meterValueCount = roByte(nextMidiByte(beginIter, endIter));
-      mb.meterValues = (roWord*) calloc(mb.meterValueCount(), sizeof(roWord));
-
-      for (int j = 0; j < mb.meterValueCount(); j++) {
-        mb.meterValues[j] = roWord(nextMidiWord(beginIter,endIter));
-      }
-      meterBlocks[i] = mb;
-      //NSLog(@"Audio: Added a meterBlock!");
-    }
-#ifdef __IOS__
-    [audioMeterLock unlock];
-    //NSLog(@"AudioPortMeter parse end");
-#else
-    audioMeterMutex.unlock();
-#endif
+    meterBlocks.parse(beginIter, endIter);
   }
 }
 
 Word AudioPortMeterValue::meterValue(int blockIndex, int meterIndex) const {
-  Word toRet = 0;
-#ifdef __IOS__
-
-  if (audioMeterLock == nil) {
-    audioMeterLock = [[NSLock alloc] init];
-  }
-  [audioMeterLock lock];
-#else
-  audioMeterMutex.lock();
-#endif
-    if ((int)meterBlockCount() > (int)blockIndex) {
-      if ((int)meterBlocks[blockIndex].meterValueCount() > (int)meterIndex) {
-        toRet = meterBlocks[blockIndex].meterValues[meterIndex]();
-      }
-    }
-#ifdef __IOS__
-  [audioMeterLock unlock];
-#else
-  audioMeterMutex.unlock();
-#endif
-  return toRet;
+  return meterBlocks.value(blockIndex, meterIndex);
 }
 
 Byte AudioPortMeterValue::versionNumber() const { return 0x01; }
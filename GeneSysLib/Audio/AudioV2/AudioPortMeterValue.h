@@ -16,18 +16,13 @@
 #include "AudioDeviceTypes.h"
 #include "property.h"
 #include "ControllerType.h"
+#include "MeterBlocks.h"
 
 namespace GeneSysLib {
 
 struct AudioPortMeterValue {
   typedef std::bitset<8> MeterTypeBitmap;
 
-  struct MeterBlock {
-    MeterTypeBitmap meterType;
-    roByte meterValueCount = roByte(0);
-    roWord *meterValues = 0;
-  };
-
   static commandDataKey_t minKey();
   static commandDataKey_t maxKey();
   static commandDataKey_t queryKey(Word audioPortID);
@@ -44,8 +39,7 @@ struct AudioPortMeterValue {
   // properties
   Byte versionNumber() const;
   roWord audioPortID;
-  roByte meterBlockCount = roByte(0);
-  MeterBlock *meterBlocks = 0;
+  MeterBlocks meterBlocks;
 
   MeterTypeBitmap meterType;
 
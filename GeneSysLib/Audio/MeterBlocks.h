@@ -0,0 +1,196 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef METERBLOCKS_H
+#define METERBLOCKS_H
+
+#include "LibTypes.h"
+#include "StreamHelpers.h"
+
+#include <algorithm>
+#include <atomic>
+
+// A meter answer has an input, an output and a mix block at most. A block
+// holds one value per channel, the widest blocks being the channel counts of
+// AudioPortParm and the mixer inputs of MixerPortParm.
+#define kMeterBlockCapacity 3
+#define kMeterValueCapacity 32
+
+namespace GeneSysLib {
+
+// The meter blocks of an AudioPortMeterValue or MixerMeterValue held inline,
+// so parsing an answer reuses the same storage every time. Writes are
+// published through a sequence counter (a seqlock): readers on other threads
+// never lock, they retry if a write overlapped their read.
+struct MeterBlocks {
+  MeterBlocks() : m_sequence(0), m_blockCount(0) {
+    for (auto &block : m_blocks) {
+      block.meterType.store(0, std::memory_order_relaxed);
+      block.valueCount.store(0, std::memory_order_relaxed);
+      for (auto &value : block.values) {
+        value.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  MeterBlocks(const MeterBlocks &other) : MeterBlocks() { *this = other; }
+
+  MeterBlocks &operator=(const MeterBlocks &other) {
+    if (this != &other) {
+      Block blocks[kMeterBlockCapacity];
+      const Byte blockCount = other.read(blocks);
+
+      beginWrite();
+      m_blockCount.store(blockCount, std::memory_order_relaxed);
+      for (int i = 0; i < blockCount; ++i) {
+        store(i, blocks[i]);
+      }
+      endWrite();
+    }
+    return *this;
+  }
+
+  // block count, then per block its type, value count and values
+  void parse(BytesIter &beginIter, BytesIter &endIter) {
+    const Byte blockCount = nextMidiByte(beginIter, endIter);
+
+    beginWrite();
+    m_blockCount.store(std::min<Byte>(blockCount, kMeterBlockCapacity),
+                       std::memory_order_relaxed);
+    for (int i = 0; i < blockCount; ++i) {
+      Block block;
+      block.meterType = nextMidiByte(beginIter, endIter);
+      const Byte valueCount = nextMidiByte(beginIter, endIter);
+      block.valueCount = std::min<Byte>(valueCount, kMeterValueCapacity);
+      for (int j = 0; j < valueCount; ++j) {
+        const Word value = nextMidiWord(beginIter, endIter);
+        if (j < kMeterValueCapacity) {
+          block.values[j] = value;
+        }
+      }
+      if (i < kMeterBlockCapacity) {
+        store(i, block);
+      }
+    }
+    endWrite();
+  }
+
+  Byte blockCount() const {
+    return m_blockCount.load(std::memory_order_acquire);
+  }
+
+  Byte valueCount(int blockIndex) const {
+    Byte result = 0;
+    if ((blockIndex >= 0) && (blockIndex < kMeterBlockCapacity)) {
+      do {
+        const unsigned sequence = beginRead();
+        result = (blockIndex < m_blockCount.load(std::memory_order_relaxed))
+                     ? m_blocks[blockIndex].valueCount.load(
+                           std::memory_order_relaxed)
+                     : 0;
+        if (endRead(sequence)) {
+          break;
+        }
+      } while (true);
+    }
+    return result;
+  }
+
+  // 0 for a block or value the answer did not contain
+  Word value(int blockIndex, int meterIndex) const {
+    Word result = 0;
+    if ((blockIndex >= 0) && (blockIndex < kMeterBlockCapacity) &&
+        (meterIndex >= 0) && (meterIndex < kMeterValueCapacity)) {
+      do {
+        const unsigned sequence = beginRead();
+        const auto &block = m_blocks[blockIndex];
+        result = ((blockIndex < m_blockCount.load(std::memory_order_relaxed)) &&
+                  (meterIndex < block.valueCount.load(std::memory_order_relaxed)))
+                     ? block.values[meterIndex].load(std::memory_order_relaxed)
+                     : 0;
+        if (endRead(sequence)) {
+          break;
+        }
+      } while (true);
+    }
+    return result;
+  }
+
+ private:
+  struct Block {
+    Byte meterType;
+    Byte valueCount;
+    Word values[kMeterValueCapacity];
+  };
+
+  struct AtomicBlock {
+    std::atomic<Byte> meterType;
+    std::atomic<Byte> valueCount;
+    std::atomic<Word> values[kMeterValueCapacity];
+  };
+
+  // copies a consistent view of all blocks, returns the block count
+  Byte read(Block *blocks) const {
+    do {
+      const unsigned sequence = beginRead();
+      const Byte blockCount = m_blockCount.load(std::memory_order_relaxed);
+      for (int i = 0; i < blockCount; ++i) {
+        const auto &block = m_blocks[i];
+        blocks[i].meterType = block.meterType.load(std::memory_order_relaxed);
+        blocks[i].valueCount = block.valueCount.load(std::memory_order_relaxed);
+        for (int j = 0; j < blocks[i].valueCount; ++j) {
+          blocks[i].values[j] = block.values[j].load(std::memory_order_relaxed);
+        }
+      }
+      if (endRead(sequence)) {
+        return blockCount;
+      }
+    } while (true);
+  }
+
+  void store(int index, const Block &block) {
+    auto &target = m_blocks[index];
+    target.meterType.store(block.meterType, std::memory_order_relaxed);
+    target.valueCount.store(block.valueCount, std::memory_order_relaxed);
+    for (int j = 0; j < block.valueCount; ++j) {
+      target.values[j].store(block.values[j], std::memory_order_relaxed);
+    }
+  }
+
+  // a single writer, the thread that parses or assigns the answer
+  void beginWrite() {
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void endWrite() {
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+  }
+
+  unsigned beginRead() const {
+    unsigned sequence;
+    do {
+      sequence = m_sequence.load(std::memory_order_acquire);
+    } while (sequence & 1);
+    return sequence;
+  }
+
+  bool endRead(unsigned sequence) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_sequence.load(std::memory_order_relaxed) == sequence;
+  }
+
+  std::atomic<unsigned> m_sequence;
+  std::atomic<Byte> m_blockCount;
+  AtomicBlock m_blocks[kMeterBlockCapacity];
+};  // struct MeterBlocks
+
+}  // namespace GeneSysLib
+
+#endif  // METERBLOCKS_H
@@ -7,6 +7,7 @@
 
 #include "stdafx.h"
 #include "MixerInputParm.h"
+#include "WireSchema.h"
 #include <limits>
 
 using namespace boost;
@@ -14,6 +15,14 @@ using namespace std;
 
 namespace GeneSysLib {
 
+struct MixerInputParm::Layout
+    : Wire::Schema<Wire::Version<0x01>,
+                   WIRE_FIELD(MidiWord, MixerInputParm, audioPortID),
+                   WIRE_FIELD(MidiByte, MixerInputParm, mixerInputNumber),
+                   WIRE_FIELD(MidiWord, MixerInputParm, audioSourceAudioPortID),
+                   WIRE_FIELD(MidiByte, MixerInputParm, audioSourceChannelID)> {
+};
+
 commandDataKey_t MixerInputParm::minKey() {
   return generateKey(Command::RetMixerInputParm);
 }
@@ -36,25 +45,12 @@ CmdEnum MixerInputParm::retCommand() { return Command::RetMixerInputParm; }
 
 Bytes MixerInputParm::generate() const {
   Bytes result;
-
-  result += versionNumber();
-  appendMidiWord(result, audioPortID());
-  appendMidiByte(result, mixerInputNumber());
-  appendMidiWord(result, audioSourceAudioPortID());
-  appendMidiByte(result, audioSourceChannelID());
-
+  Layout::generate(*this, result);
   return result;
 }
 
 void MixerInputParm::parse(BytesIter &beginIter, BytesIter &endIter) {
-  Byte version = nextMidiByte(beginIter, endIter);
-
-  if (version == versionNumber()) {
-    audioPortID = nextROWord(beginIter, endIter);
-    mixerInputNumber = nextROByte(beginIter, endIter);
-    audioSourceAudioPortID = nextRWWord(beginIter, endIter);
-    audioSourceChannelID = nextRWByte(beginIter, endIter);
-  }
+  Layout::parse(*this, beginIter, endIter);
 }
 
 Byte MixerInputParm::versionNumber() const { return 0x01; }
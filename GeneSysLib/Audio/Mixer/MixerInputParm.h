@@ -39,6 +39,9 @@ struct MixerInputParm {
   roByte mixerInputNumber;
   rwWord audioSourceAudioPortID;
   rwByte audioSourceChannelID;
+
+ private:
+  struct Layout;
 };  // struct MixerInputParm
 
 struct GetMixerInputParmCommand
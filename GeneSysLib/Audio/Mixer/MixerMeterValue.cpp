@@ -12,13 +12,6 @@
 using namespace boost;
 using namespace std;
 
-#ifdef __IOS__
-NSLock *mixerMeterLock = nil;
-#else
-#include <QMutex>
-QMutex mixerMeterMutex;
-#endif
-
 namespace GeneSysLib {
 
 commandDataKey_t MixerMeterValue::minKey() {
@@ -56,99 +49,18 @@ void MixerMeterValue::parse(BytesIter &beginIter, BytesIter &endIter) {
   Byte version = nextMidiByte(beginIter, endIter);
 
   if (version == versionNumber()) {
-#ifdef __IOS__
-    if (mixerMeterLock == nil) {
-      mixerMeterLock = [[NSLock alloc] init];
-    }
-    [mixerMeterLock lock];
-    //NSLog(@"MixerMeter parse start");
-#else
-    mixerMeterMutex.lock();
-#endif
     audioPortID = roWord(nextMidiWord(beginIter, endIter));
     mixerOutputNumber = roByte(nextMidiByte(beginIter, endIter));
-    if (meterBlocks) {
-      for (int i = 0; i < meterBlockCount(); i++) {
-        if (meterBlocks[i].meterValues) {
-          free(meterBlocks[i].meterValues);
-        }
-      }
-      free(meterBlocks);
-    }
-    meterBlockCount = roByte(nextMidiByte(beginIter, endIter));
-    meterBlocks = (MeterBlock*) malloc(sizeof(MeterBlock) * meterBlockCount());
-
-    for (int i = 0; i < meterBlockCount(); i++) {
-      MeterBlock mb;
-      mb.meterType = std::bitset<8>(nextMidiByte(beginIter, endIter));
-      mb.meterValueCount = roByte(nextMidiByte(beginIter, endIter));
-      mb.meterValues = (roWord*) malloc(sizeof(roWord) * mb.meterValueCount());
-      for (int j = 0; j < mb.meterValueCount(); j++) {
-        mb.meterValues[j] = roWord(nextMidiWord(beginIter,endIter));
-      }
-      meterBlocks[i] = mb;
-      //NSLog(@"Mixer: Added a meterBlock!");
-    }
-#ifdef __IOS__
-    [mixerMeterLock unlock];
-    //NSLog(@"MixerMeter parse end");
-#else
-    mixerMeterMutex.unlock();
-#endif
+    meterBlocks.parse(beginIter, endIter);
   }
 }
 
 Byte MixerMeterValue::versionNumber() const { return 0x01; }
 
-Word MixerMeterValue::outputMeter() const
-{
-#ifdef __IOS__
-  if (mixerMeterLock == nil) {
-    mixerMeterLock = [[NSLock alloc] init];
-  }
-  [mixerMeterLock lock];
-  //NSLog(@"O lock");
-#else
-  mixerMeterMutex.lock();
-#endif
-  Word toRet = 0;
-  if (meterBlockCount() > 1) {
-    if (meterBlocks[1].meterValueCount() > 0)
-      toRet = meterBlocks[1].meterValues[0]();
-  }
-#ifdef __IOS__
-  [mixerMeterLock unlock];
-  //NSLog(@"O unlock");
-#else
-  mixerMeterMutex.unlock();
-#endif
-  return toRet;
-}
+Word MixerMeterValue::outputMeter() const { return meterBlocks.value(1, 0); }
 
-Word MixerMeterValue::inputMeter(Byte mixerInputNumber) const
-{
-#ifdef __IOS__
-  if (mixerMeterLock == nil) {
-    mixerMeterLock = [[NSLock alloc] init];
-  }
-  //NSLog(@"I lock");
-  [mixerMeterLock lock];
-#else
-  mixerMeterMutex.lock();
-#endif
-  Word toRet = 0;
-  if (meterBlockCount() > 0) {
-    if (meterBlocks[0].meterValueCount() >= mixerInputNumber)
-      toRet = meterBlocks[0].meterValues[mixerInputNumber - 1]();
-  }
-#ifdef __IOS__
-  [mixerMeterLock unlock];
-  //NSLog(@"I unlock");
-#else
-  mixerMeterMutex.unlock();
-#endif
-  return toRet;
+Word MixerMeterValue::inputMeter(Byte mixerInputNumber) const {
+  return meterBlocks.value(0, mixerInputNumber - 1);
 }
 
 }  // namespace GeneSysLib
-
@@ -17,6 +17,7 @@
 #include "AudioDeviceTypes.h"
 #include "property.h"
 #include "ControllerType.h"
+#include "MeterBlocks.h"
 #include "StreamHelpers.h"
 
 namespace GeneSysLib {
@@ -24,12 +25,6 @@ namespace GeneSysLib {
 struct MixerMeterValue {
   typedef std::bitset<8> MeterTypeBitmap;
 
-  struct MeterBlock {
-    MeterTypeBitmap meterType;
-    roByte meterValueCount = roByte(0);
-    roWord* meterValues = 0;
-  };
-
   static commandDataKey_t minKey();
   static commandDataKey_t maxKey();
   static commandDataKey_t queryKey(Word audioPortID, Byte mixerOutputNumber);
@@ -48,8 +43,7 @@ struct MixerMeterValue {
   roByte mixerOutputNumber;
   MeterTypeBitmap meterType;
 
-  roByte meterBlockCount = roByte(0);
-  MeterBlock* meterBlocks = 0;
+  MeterBlocks meterBlocks;
 
   Word outputMeter() const;
   Word inputMeter(Byte mixerInputNumber) const;
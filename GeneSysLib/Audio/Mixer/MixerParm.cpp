@@ -7,6 +7,7 @@
 
 #include "stdafx.h"
 #include "MixerParm.h"
+#include "WireSchema.h"
 #include <limits>
 
 using namespace boost;
@@ -14,6 +15,23 @@ using namespace std;
 
 namespace GeneSysLib {
 
+namespace {
+
+typedef Wire::Schema<
+    WIRE_FIELD(MidiByte, MixerParm::MixerBlock, mixerConfigurationNumber),
+    WIRE_FIELD(MidiByte, MixerParm::MixerBlock, maximumInputs),
+    WIRE_FIELD(MidiByte, MixerParm::MixerBlock, maximumOutputs)>
+    MixerBlockLayout;
+
+}  // namespace
+
+struct MixerParm::Layout
+    : Wire::Schema<
+          Wire::Version<0x01>,
+          WIRE_FIELD(MidiByte, MixerParm, activeMixerConfigurationBlock),
+          WIRE_FIELD(MidiByte, MixerParm, audioConfigurationNumber),
+          WIRE_FIELD(MidiByte, MixerParm, mixerBlockCount)> {};
+
 commandDataKey_t MixerParm::minKey() {
   return generateKey(Command::RetMixerParm);
 }
@@ -36,36 +54,17 @@ CmdEnum MixerParm::retCommand() { return Command::RetMixerParm; }
 
 Bytes MixerParm::generate() const {
   Bytes result;
-
-  result += versionNumber();
-  appendMidiByte(result, activeMixerConfigurationBlock());
-  appendMidiByte(result, audioConfigurationNumber());
-  appendMidiByte(result, mixerBlockCount());
-  for (int i = 0; i < mixerBlockCount(); i++) {
-    MixerBlock mb = mixerBlocks.at(i);
-    appendMidiByte(result, mb.mixerConfigurationNumber());
-    appendMidiByte(result, mb.maximumInputs());
-    appendMidiByte(result, mb.maximumOutputs());
-  }
-
+  Layout::generate(*this, result, mixerBlocks.size() * MixerBlockLayout::size);
+  Wire::generateBlocks<MixerBlockLayout>(mixerBlocks, result);
   return result;
 }
 
 void MixerParm::parse(BytesIter &beginIter, BytesIter &endIter) {
-  Byte version = nextMidiByte(beginIter, endIter);
-
-  if (version == versionNumber()) {
-    activeMixerConfigurationBlock = rwByte(nextMidiByte(beginIter, endIter));
-    audioConfigurationNumber = roByte(nextMidiByte(beginIter, endIter));
-    mixerBlockCount = roByte(nextMidiByte(beginIter, endIter));
-    mixerBlocks.clear();
-    for (int i = 0; i < mixerBlockCount(); i++) {
-      MixerBlock mb;
-      mb.mixerConfigurationNumber = roByte(nextMidiByte(beginIter, endIter));
-      mb.maximumInputs = roByte(nextMidiByte(beginIter, endIter));
-      mb.maximumOutputs = roByte(nextMidiByte(beginIter,endIter));
-      mixerBlocks.push_back(mb);
-    }
+  if (Layout::parse(*this, beginIter, endIter) &&
+      !Wire::parseBlocks<MixerBlockLayout>(mixerBlocks, mixerBlockCount(),
+                                           beginIter, endIter)) {
+    // truncated, keep the count in line with the blocks there are
+    mixerBlockCount = roByte(0);
   }
 }
 
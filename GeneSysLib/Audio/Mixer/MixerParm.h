@@ -45,6 +45,9 @@ struct MixerParm {
   roByte audioConfigurationNumber;
   roByte mixerBlockCount;
   std::vector<MixerBlock> mixerBlocks;
+
+ private:
+  struct Layout;
 };  // struct MixerParm
 
 struct GetMixerParmCommand
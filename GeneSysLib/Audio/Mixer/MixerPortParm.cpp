@@ -7,12 +7,29 @@
 
 #include "stdafx.h"
 #include "MixerPortParm.h"
+#include "WireSchema.h"
 #include <limits>
 
 using namespace boost;
 using namespace std;
 
 namespace GeneSysLib {
+
+namespace {
+
+typedef Wire::Schema<
+    WIRE_FIELD(MidiWord, MixerPortParm::AudioPortMixerBlock, audioPortID),
+    WIRE_FIELD(MidiByte, MixerPortParm::AudioPortMixerBlock, numInputs),
+    WIRE_FIELD(MidiByte, MixerPortParm::AudioPortMixerBlock, numOutputs)>
+    AudioPortMixerBlockLayout;
+
+}  // namespace
+
+struct MixerPortParm::Layout
+    : Wire::Schema<
+          Wire::Version<0x01>,
+          WIRE_FIELD(MidiByte, MixerPortParm, audioPortMixerBlockCount)> {};
+
 /*
 commandDataKey_t MixerPortParm::minKey() {
   return generateKey(Command::RetMixerPortParm);
@@ -36,32 +53,19 @@ CmdEnum MixerPortParm::retCommand() { return Command::RetMixerPortParm; }
 
 Bytes MixerPortParm::generate() const {
   Bytes result;
-
-  result += versionNumber();
-  appendMidiByte(result, audioPortMixerBlockCount());
-  for (int i = 0; i < audioPortMixerBlockCount(); i++) {
-    AudioPortMixerBlock apmb = audioPortMixerBlocks.at(i);
-    appendMidiWord(result, apmb.audioPortID());
-    appendMidiByte(result, apmb.numInputs());
-    appendMidiByte(result, apmb.numOutputs());
-  }
-
+  Layout::generate(*this, result, audioPortMixerBlocks.size() *
+                                      AudioPortMixerBlockLayout::size);
+  Wire::generateBlocks<AudioPortMixerBlockLayout>(audioPortMixerBlocks, result);
   return result;
 }
 
 void MixerPortParm::parse(BytesIter &beginIter, BytesIter &endIter) {
-  Byte version = nextMidiByte(beginIter, endIter);
-
-  if (version == versionNumber()) {
-    audioPortMixerBlockCount = nextROByte(beginIter, endIter);
-    audioPortMixerBlocks.clear();
-    for (int i = 0; i < audioPortMixerBlockCount(); i++) {
-      AudioPortMixerBlock apmb;
-      apmb.audioPortID = nextROWord(beginIter, endIter);
-      apmb.numInputs = nextRWByte(beginIter, endIter);
-      apmb.numOutputs = nextRWByte(beginIter, endIter);
-      audioPortMixerBlocks.push_back(apmb);
-    }
+  if (Layout::parse(*this, beginIter, endIter) &&
+      !Wire::parseBlocks<AudioPortMixerBlockLayout>(
+          audioPortMixerBlocks, audioPortMixerBlockCount(), beginIter,
+          endIter)) {
+    // truncated, keep the count in line with the blocks there are
+    audioPortMixerBlockCount = roByte(0);
   }
 }
 
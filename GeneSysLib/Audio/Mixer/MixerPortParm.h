@@ -43,6 +43,9 @@ struct MixerPortParm {
   Byte versionNumber() const;
   roByte audioPortMixerBlockCount;
   std::vector<AudioPortMixerBlock> audioPortMixerBlocks;
+
+ private:
+  struct Layout;
 };  // struct MixerPortParm
 
 struct GetMixerPortParmCommand
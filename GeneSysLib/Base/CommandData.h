@@ -10,9 +10,11 @@
 
 #include "LibTypes.h"
 #include "CommandDataKey.h"
-#ifndef Q_MOC_RUN
-#include <boost/scoped_ptr.hpp>
-#endif
+#include <cassert>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
 
 namespace GeneSysLib {
 
@@ -31,30 +33,67 @@ void parse(T &t, BytesIter &b, BytesIter &e) {
   t.parse(b, e);
 }
 
+// payloads up to this size are stored inside commandData_t itself, larger
+// ones are allocated on the heap
+#define kCommandDataInlineSize 64
+
 struct commandData_t {
   template <typename T>
   commandData_t(T x)
-      : self_(new model_t<T>(x)) {}
+      : self_(0) {
+    construct<T>(std::move(x));
+  }
 
   commandData_t() : self_(0) {}
 
-  commandData_t(commandData_t const &that)
-      : self_(that.self_ ? that.self_->clone() : 0) {}
+  commandData_t(commandData_t const &that) : self_(0) {
+    if (that.self_) {
+      self_ = that.self_->clone(&storage_);
+    }
+  }
+
+  commandData_t(commandData_t &&that) : self_(0) { moveFrom(that); }
+
+  ~commandData_t() { destroy(); }
 
   friend void swap(commandData_t &lhs, commandData_t &rhs) {
-    boost::swap(lhs.self_, rhs.self_);
+    commandData_t tmp(std::move(lhs));
+    lhs = std::move(rhs);
+    rhs = std::move(tmp);
   }
 
-  bool empty() const { return (bool)self_; }
+  bool empty() const { return self_ != 0; }
+
+  commandData_t &operator=(commandData_t const &rhs) {
+    if (this != &rhs) {
+      // reuse the payload already held when the types match
+      if ((self_) && (rhs.self_) && (self_->type() == rhs.self_->type())) {
+        self_->assign(*rhs.self_);
+      } else {
+        commandData_t tmp(rhs);
+        destroy();
+        moveFrom(tmp);
+      }
+    }
+    return *this;
+  }
 
-  commandData_t &operator=(commandData_t rhs) {
-    swap(*this, rhs);
+  commandData_t &operator=(commandData_t &&rhs) {
+    if (this != &rhs) {
+      destroy();
+      moveFrom(rhs);
+    }
     return *this;
   }
 
   template <typename T>
   commandData_t &operator=(T const &x) {
-    self_.reset(new model_t<T>(x));
+    if ((self_) && (self_->type() == typeid(T))) {
+      static_cast<model_t<T> *>(self_)->data_ = x;
+    } else {
+      destroy();
+      construct<T>(T(x));
+    }
     return *this;
   }
 
@@ -77,20 +116,24 @@ struct commandData_t {
   const T &get() const {
     assert(self_);
     assert(typeid(T) == self_->type());
-    return static_cast<model_t<T> *>(self_.get())->data_;
+    return static_cast<const model_t<T> *>(self_)->data_;
   }
 
   template <typename T>
   T &get() {
     assert(self_);
     assert(typeid(T) == self_->type());
-    return static_cast<model_t<T> *>(self_.get())->data_;
+    return static_cast<model_t<T> *>(self_)->data_;
   }
 
  private:
+  typedef std::aligned_storage<kCommandDataInlineSize>::type storage_t;
+
   struct concept_t {
     virtual ~concept_t() {}
-    virtual concept_t *clone() const = 0;
+    virtual concept_t *clone(storage_t *storage) const = 0;
+    virtual concept_t *move(storage_t *storage) = 0;
+    virtual void assign(const concept_t &that) = 0;
     virtual const std::type_info &type() const = 0;
 
     // Forwarding functions
@@ -102,8 +145,38 @@ struct commandData_t {
   template <typename T>
   struct model_t : concept_t {
     model_t(T const &x) : data_(x) {}
+    model_t(T &&x) : data_(std::move(x)) {}
+
+    // only payloads that can be moved without throwing live inline, moving
+    // a commandData_t must not fail half way
+    static bool fitsInline() {
+      return (sizeof(model_t) <= sizeof(storage_t)) &&
+             (std::alignment_of<model_t>::value <=
+              std::alignment_of<storage_t>::value) &&
+             std::is_nothrow_move_constructible<T>::value;
+    }
+
+    static concept_t *create(storage_t *storage, T &&x) {
+      if (fitsInline()) {
+        return new (storage) model_t(std::move(x));
+      }
+      return new model_t(std::move(x));
+    }
 
-    virtual model_t *clone() const { return new model_t(data_); }
+    virtual concept_t *clone(storage_t *storage) const {
+      if (fitsInline()) {
+        return new (storage) model_t(data_);
+      }
+      return new model_t(data_);
+    }
+
+    virtual concept_t *move(storage_t *storage) {
+      return new (storage) model_t(std::move(data_));
+    }
+
+    virtual void assign(const concept_t &that) {
+      data_ = static_cast<const model_t &>(that).data_;
+    }
 
     virtual const commandDataKey_t key() const {
       return GeneSysLib::key(data_);
@@ -118,10 +191,40 @@ struct commandData_t {
     T data_;
   };
 
+  template <typename T>
+  void construct(T &&x) {
+    self_ = model_t<T>::create(&storage_, std::move(x));
+  }
+
+  bool isInline() const {
+    return (const void *)self_ == (const void *)&storage_;
+  }
+
+  // takes over the payload of that, leaving it empty
+  void moveFrom(commandData_t &that) {
+    if (that.isInline()) {
+      self_ = that.self_->move(&storage_);
+      that.destroy();
+    } else {
+      self_ = that.self_;
+      that.self_ = 0;
+    }
+  }
+
+  void destroy() {
+    if (isInline()) {
+      self_->~concept_t();
+    } else {
+      delete self_;
+    }
+    self_ = 0;
+  }
+
   template <typename ValueType>
   friend ValueType *command_cast(concept_t *);
 
-  boost::scoped_ptr<concept_t> self_;
+  concept_t *self_;
+  storage_t storage_;
 };  // struct commandData_t
 
 struct EmptyCommandData {
@@ -12,50 +12,89 @@
 #include "CommandDefines.h"
 #include "StreamHelpers.h"
 
+#include <stdint.h>
+
 namespace GeneSysLib {
-typedef Bytes commandDataKey_t;
+
+// A key packs the command byte followed by up to six index bytes into the
+// high bytes of an integer, most significant first, with the number of key
+// bytes in the lowest byte. Comparing two keys gives the same order as
+// comparing the byte strings they replace, shorter keys sorting first.
+typedef uint64_t commandDataKey_t;
+
+#define kKeyMaxBytes 7
+
+// only called through generateKey, which checks the key fits
+inline constexpr commandDataKey_t appendKeyByte(commandDataKey_t key, Byte b) {
+  return ((key & 0xFF) < kKeyMaxBytes)
+             ? ((key | (static_cast<commandDataKey_t>(b)
+                        << (56 - 8 * (key & 0xFF)))) + 1)
+             : key;
+}
 
 template <typename T>
-inline Bytes &appendBytes(Bytes &result, T t) {
-  result.push_back(static_cast<Byte>(t & 0xFF));
-  return result;
+inline constexpr commandDataKey_t appendKey(commandDataKey_t key, T t) {
+  return appendKeyByte(key, static_cast<Byte>(t & 0xFF));
 }
 
-template <>
-inline Bytes &appendBytes<Byte>(Bytes &result, Byte byte) {
-  result.push_back(byte);
-  return result;
+inline constexpr commandDataKey_t appendKey(commandDataKey_t key, Byte byte) {
+  return appendKeyByte(key, byte);
 }
 
-template <>
-inline Bytes &appendBytes<Word>(Bytes &result, Word word) {
-  appendMidiWord(result, word);
-  return result;
+// words are stored the way they travel, as two 7-bit bytes
+inline constexpr commandDataKey_t appendKey(commandDataKey_t key, Word word) {
+  return appendKeyByte(appendKeyByte(key, (word >> 7) & 0x7F), word & 0x7F);
 }
 
-inline commandDataKey_t generateKeyHelper(Bytes &result) { return result; }
+// the key bytes an index takes, words travel as two
+template <typename T>
+struct KeyBytes {
+  enum { value = 1 };
+};
+
+template <>
+struct KeyBytes<Word> {
+  enum { value = 2 };
+};
+
+template <typename... Ts>
+struct KeyLength;
+
+template <>
+struct KeyLength<> {
+  enum { value = 1 };  // the command byte
+};
+
+template <typename T, typename... Ts>
+struct KeyLength<T, Ts...> {
+  enum { value = KeyBytes<T>::value + KeyLength<Ts...>::value };
+};
+
+inline constexpr commandDataKey_t generateKeyHelper(commandDataKey_t key) {
+  return key;
+}
 
 template <typename T, typename... Ts>
-inline commandDataKey_t generateKeyHelper(Bytes &result, T t, Ts... ts) {
-  appendBytes(result, t);
-  return generateKeyHelper(result, ts...);
+inline constexpr commandDataKey_t generateKeyHelper(commandDataKey_t key, T t,
+                                                    Ts... ts) {
+  return generateKeyHelper(appendKey(key, t), ts...);
 }
 
 template <typename... Ts>
-inline commandDataKey_t generateKey(Command::Enum cmd, Ts... ts) {
-  Bytes result;
-  appendBytes(result, static_cast<Byte>(cmd & 0x7F));
-  return generateKeyHelper(result, ts...);
+inline constexpr commandDataKey_t generateKey(Command::Enum cmd, Ts... ts) {
+  // appendKeyByte drops what does not fit, so two keys could end up the same
+  static_assert(KeyLength<Ts...>::value <= kKeyMaxBytes,
+                "too many index bytes for a command data key");
+  return generateKeyHelper(appendKeyByte(0, static_cast<Byte>(cmd & 0x7F)),
+                           ts...);
 }
 
-inline Command::Enum keyToCommand(const commandDataKey_t &key) {
-  assert(key.size() > 0);
-  return static_cast<Command::Enum>(ANSWR_BIT | key.at(0));
+inline constexpr Byte keyToCommandID(commandDataKey_t key) {
+  return static_cast<Byte>(key >> 56);
 }
 
-inline Byte keyToCommandID(const commandDataKey_t &key) {
-  assert(key.size() > 0);
-  return key.at(0);
+inline constexpr Command::Enum keyToCommand(commandDataKey_t key) {
+  return static_cast<Command::Enum>(ANSWR_BIT | keyToCommandID(key));
 }
 
 }  // namespace GeneSysLib
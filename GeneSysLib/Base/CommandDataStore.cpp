@@ -0,0 +1,110 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "CommandDataStore.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace GeneSysLib {
+
+namespace {
+
+bool entryLess(const CommandDataStore::value_type *entry,
+               commandDataKey_t key) {
+  return entry->first < key;
+}
+
+}  // namespace
+
+CommandDataStore::CommandDataStore() : m_families() {}
+
+bool CommandDataStore::empty() const { return size() == 0; }
+
+size_t CommandDataStore::size() const {
+  size_t result = 0;
+  for (const auto &family : m_families) {
+    result += family.index.size();
+  }
+  return result;
+}
+
+void CommandDataStore::clear() {
+  for (auto &family : m_families) {
+    family.index.clear();
+    family.entries.clear();
+  }
+}
+
+void CommandDataStore::erase(CmdEnum command) {
+  if ((command >= 0) && (command < kCommandSlots)) {
+    m_families[command].index.clear();
+    m_families[command].entries.clear();
+  }
+}
+
+bool CommandDataStore::contains(commandDataKey_t key) const {
+  return find(key) != 0;
+}
+
+size_t CommandDataStore::count(CmdEnum command) const {
+  const auto *family = familyFor(command);
+  return (family) ? family->index.size() : 0;
+}
+
+commandData_t &CommandDataStore::operator[](commandDataKey_t key) {
+  auto &family = m_families[slot(key)];
+  auto position =
+      lower_bound(family.index.begin(), family.index.end(), key, entryLess);
+
+  if ((position == family.index.end()) || ((*position)->first != key)) {
+    family.entries.push_back(value_type(key, commandData_t()));
+    position = family.index.insert(position, &family.entries.back());
+  }
+
+  return (*position)->second;
+}
+
+commandData_t &CommandDataStore::at(commandDataKey_t key) {
+  auto *entry = find(key);
+  if (!entry) {
+    throw out_of_range("CommandDataStore::at");
+  }
+  return entry->second;
+}
+
+const commandData_t &CommandDataStore::at(commandDataKey_t key) const {
+  const auto *entry = find(key);
+  if (!entry) {
+    throw out_of_range("CommandDataStore::at");
+  }
+  return entry->second;
+}
+
+const CommandDataStore::Family *CommandDataStore::familyFor(
+    CmdEnum command) const {
+  if ((command < 0) || (command >= kCommandSlots)) {
+    return 0;
+  }
+  return &m_families[command];
+}
+
+CommandDataStore::value_type *CommandDataStore::find(
+    commandDataKey_t key) const {
+  const auto &family = m_families[slot(key)];
+  auto position =
+      lower_bound(family.index.begin(), family.index.end(), key, entryLess);
+
+  if ((position != family.index.end()) && ((*position)->first == key)) {
+    return *position;
+  }
+  return 0;
+}
+
+}  // namespace GeneSysLib
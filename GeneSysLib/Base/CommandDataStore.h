@@ -0,0 +1,137 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __COMMANDDATASTORE_H__
+#define __COMMANDDATASTORE_H__
+
+#include "LibTypes.h"
+#include "CommandData.h"
+#include "CommandDataKey.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/iterator/iterator_facade.hpp>
+#endif
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace GeneSysLib {
+
+// Holds the command data of one device keyed by commandDataKey_t. Entries
+// are grouped into one family per answer command, so finding a family is an
+// array index and finding an entry is a binary search over that family's
+// sorted index. Entries are never moved once stored, references stay valid
+// as more entries are added, the same as they did in a std::map.
+struct CommandDataStore {
+  typedef std::pair<const commandDataKey_t, commandData_t> value_type;
+
+ private:
+  struct Family {
+    std::deque<value_type> entries;
+    std::vector<value_type *> index;  // sorted by key
+  };
+
+  template <typename Value>
+  class Iterator
+      : public boost::iterator_facade<Iterator<Value>, Value,
+                                      boost::forward_traversal_tag> {
+   public:
+    Iterator() : m_families(0), m_family(kCommandSlots), m_entry(0) {}
+    Iterator(const Family *families, size_t family)
+        : m_families(families), m_family(family), m_entry(0) {
+      skipEmpty();
+    }
+
+   private:
+    friend class boost::iterator_core_access;
+
+    void increment() {
+      ++m_entry;
+      skipEmpty();
+    }
+
+    bool equal(const Iterator &that) const {
+      return (m_family == that.m_family) && (m_entry == that.m_entry);
+    }
+
+    Value &dereference() const {
+      return *m_families[m_family].index[m_entry];
+    }
+
+    void skipEmpty() {
+      while ((m_family < kCommandSlots) &&
+             (m_entry >= m_families[m_family].index.size())) {
+        ++m_family;
+        m_entry = 0;
+      }
+    }
+
+    const Family *m_families;
+    size_t m_family;
+    size_t m_entry;
+  };
+
+ public:
+  typedef Iterator<value_type> iterator;
+  typedef Iterator<const value_type> const_iterator;
+
+  CommandDataStore();
+
+  bool empty() const;
+  size_t size() const;
+  void clear();
+
+  // drops every entry of a family, references into it become invalid
+  void erase(CmdEnum command);
+
+  bool contains(commandDataKey_t key) const;
+
+  // number of entries stored for an answer command
+  size_t count(CmdEnum command) const;
+
+  commandData_t &operator[](commandDataKey_t key);
+  commandData_t &at(commandDataKey_t key);
+  const commandData_t &at(commandDataKey_t key) const;
+
+  iterator begin() { return iterator(m_families, 0); }
+  iterator end() { return iterator(); }
+  const_iterator begin() const { return const_iterator(m_families, 0); }
+  const_iterator end() const { return const_iterator(); }
+
+  // visits the entries of one answer command in key order
+  template <typename Action>
+  void for_each(CmdEnum command, Action action) {
+    const auto *family = familyFor(command);
+    if (family) {
+      for (auto *entry : family->index) {
+        action(entry->second);
+      }
+    }
+  }
+
+  template <typename Action>
+  void for_each(CmdEnum command, Action action) const {
+    const auto *family = familyFor(command);
+    if (family) {
+      for (const auto *entry : family->index) {
+        action(entry->second);
+      }
+    }
+  }
+
+ private:
+  static size_t slot(commandDataKey_t key) { return keyToCommandID(key); }
+
+  const Family *familyFor(CmdEnum command) const;
+  value_type *find(commandDataKey_t key) const;
+
+  Family m_families[kCommandSlots];
+};  // struct CommandDataStore
+
+}  // namespace GeneSysLib
+
+#endif  // __COMMANDDATASTORE_H__
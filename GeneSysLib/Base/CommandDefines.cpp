@@ -207,4 +207,190 @@ set<CmdEnum> commandDependancy(CmdEnum command) {
   return D;
 }
 
+CmdEnum responseCommand(CmdEnum command) {
+  CmdEnum result = Command::ACK;
+
+  switch (command) {
+  case Command::GetDevice:
+    result = Command::RetDevice;
+    break;
+
+  case Command::GetCommandList:
+    result = Command::RetCommandList;
+    break;
+
+  case Command::GetInfoList:
+    result = Command::RetInfoList;
+    break;
+
+  case Command::GetInfo:
+    result = Command::RetInfo;
+    break;
+
+  case Command::GetResetList:
+    result = Command::RetResetList;
+    break;
+
+  case Command::GetSaveRestoreList:
+    result = Command::RetSaveRestoreList;
+    break;
+
+  case Command::GetEthernetPortInfo:
+    result = Command::RetEthernetPortInfo;
+    break;
+
+  case Command::GetGizmoCount:
+    result = Command::RetGizmoCount;
+    break;
+
+  case Command::GetGizmoInfo:
+    result = Command::RetGizmoInfo;
+    break;
+
+  case Command::GetMIDIInfo:
+    result = Command::RetMIDIInfo;
+    break;
+
+  case Command::GetMIDIPortInfo:
+    result = Command::RetMIDIPortInfo;
+    break;
+
+  case Command::GetMIDIPortFilter:
+    result = Command::RetMIDIPortFilter;
+    break;
+
+  case Command::GetMIDIPortRemap:
+    result = Command::RetMIDIPortRemap;
+    break;
+
+  case Command::GetMIDIPortRoute:
+    result = Command::RetMIDIPortRoute;
+    break;
+
+  case Command::GetMIDIPortDetail:
+    result = Command::RetMIDIPortDetail;
+    break;
+
+  case Command::GetRTPMIDIConnectionDetail:
+    result = Command::RetRTPMIDIConnectionDetail;
+    break;
+
+  case Command::GetUSBHostMIDIDeviceDetail:
+    result = Command::RetUSBHostMIDIDeviceDetail;
+    break;
+
+  case Command::GetAudioInfo:
+    result = Command::RetAudioInfo;
+    break;
+
+  case Command::GetAudioCfgInfo:
+    result = Command::RetAudioCfgInfo;
+    break;
+
+  case Command::GetAudioPortInfo:
+    result = Command::RetAudioPortInfo;
+    break;
+
+  case Command::GetAudioPortCfgInfo:
+    result = Command::RetAudioPortCfgInfo;
+    break;
+
+  case Command::GetAudioPortPatchbay:
+    result = Command::RetAudioPortPatchbay;
+    break;
+
+  case Command::GetAudioClockInfo:
+    result = Command::RetAudioClockInfo;
+    break;
+
+  case Command::GetAudioGlobalParm:
+    result = Command::RetAudioGlobalParm;
+    break;
+
+  case Command::GetAudioPortParm:
+    result = Command::RetAudioPortParm;
+    break;
+
+  case Command::GetAudioDeviceParm:
+    result = Command::RetAudioDeviceParm;
+    break;
+
+  case Command::GetAudioControlParm:
+    result = Command::RetAudioControlParm;
+    break;
+
+  case Command::GetAudioControlDetail:
+    result = Command::RetAudioControlDetail;
+    break;
+
+  case Command::GetAudioControlDetailValue:
+    result = Command::RetAudioControlDetailValue;
+    break;
+
+  case Command::GetAudioClockParm:
+    result = Command::RetAudioClockParm;
+    break;
+
+  case Command::GetAudioPatchbayParm:
+    result = Command::RetAudioPatchbayParm;
+    break;
+
+  case Command::GetAudioChannelName:
+    result = Command::RetAudioChannelName;
+    break;
+
+  case Command::GetAudioPortMeterValue:
+    result = Command::RetAudioPortMeterValue;
+    break;
+
+  case Command::GetMixerParm:
+    result = Command::RetMixerParm;
+    break;
+
+  case Command::GetMixerPortParm:
+    result = Command::RetMixerPortParm;
+    break;
+
+  case Command::GetMixerInputParm:
+    result = Command::RetMixerInputParm;
+    break;
+
+  case Command::GetMixerOutputParm:
+    result = Command::RetMixerOutputParm;
+    break;
+
+  case Command::GetMixerInputControl:
+    result = Command::RetMixerInputControl;
+    break;
+
+  case Command::GetMixerOutputControl:
+    result = Command::RetMixerOutputControl;
+    break;
+
+  case Command::GetMixerInputControlValue:
+    result = Command::RetMixerInputControlValue;
+    break;
+
+  case Command::GetMixerOutputControlValue:
+    result = Command::RetMixerOutputControlValue;
+    break;
+
+  case Command::GetMixerMeterValue:
+    result = Command::RetMixerMeterValue;
+    break;
+
+  default:
+    // writes, resets and save/restore are answered with an ACK
+    break;
+  }
+
+  return result;
+}
+
+bool isRetryable(CmdEnum command) {
+  // a reset or save/restore may already have been acted upon when its answer
+  // goes missing so never send those twice
+  return ((command != Command::Reset) && (command != Command::SaveRestore));
+}
+
 }  // namespace GeneSysLib
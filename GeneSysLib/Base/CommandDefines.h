@@ -18,6 +18,9 @@ namespace GeneSysLib {
 #define WRITE_BIT 0x2000
 #define QUERY_BIT 0x2000
 
+// answers carry a 7-bit command ID, tables indexed by it have this many slots
+#define kCommandSlots 128
+
 namespace Command {
 typedef enum Enum {
   GetDevice = QUERY_BIT | 0x0001,
@@ -200,6 +203,13 @@ typedef std::vector<CmdEnum> CmdEnumVector;
 
 std::set<CmdEnum> commandDependancy(Command::Enum command);
 
+// returns the command the device answers the given command with: the matching
+// Ret* command for a Get* query and ACK for everything else
+CmdEnum responseCommand(Command::Enum command);
+
+// returns true if the command can safely be resent when its answer is lost
+bool isRetryable(Command::Enum command);
+
 typedef readonly_property<CmdEnum> roCmdEnum;
 typedef readwrite_property<CmdEnum> rwCmdEnum;
 
@@ -0,0 +1,188 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "CommandMetrics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+namespace GeneSysLib {
+
+namespace {
+
+size_t latencyBucket(long long usec) {
+  size_t bucket = 0;
+  while ((bucket < kLatencyBuckets - 1) && (usec >= (1LL << bucket))) {
+    ++bucket;
+  }
+  return bucket;
+}
+
+void writeStats(ostream &stream, const CommandMetrics::Stats &stats) {
+  stream << '\t' << stats.requests << '\t' << stats.answers << '\t'
+         << stats.retries << '\t' << stats.timeouts << '\t' << stats.received
+         << '\t' << stats.parseFailures << '\t' << stats.bytesOut << '\t'
+         << stats.bytesIn << '\t' << (long long)stats.meanLatency() << '\t'
+         << stats.latencyMin << '\t' << stats.latencyPercentile(0.5) << '\t'
+         << stats.latencyPercentile(0.9) << '\t'
+         << stats.latencyPercentile(0.99) << '\t' << stats.latencyMax << '\n';
+}
+
+}  // namespace
+
+CommandMetrics::Stats::Stats()
+    : requests(0),
+      answers(0),
+      retries(0),
+      timeouts(0),
+      received(0),
+      parseFailures(0),
+      bytesOut(0),
+      bytesIn(0),
+      latency(),
+      latencyTotal(0),
+      latencyMin(0),
+      latencyMax(0) {
+  latency.fill(0);
+}
+
+void CommandMetrics::Stats::add(const Stats &other) {
+  if (other.answers > 0) {
+    latencyMin = (answers > 0) ? min(latencyMin, other.latencyMin)
+                               : other.latencyMin;
+    latencyMax = max(latencyMax, other.latencyMax);
+  }
+
+  requests += other.requests;
+  answers += other.answers;
+  retries += other.retries;
+  timeouts += other.timeouts;
+  received += other.received;
+  parseFailures += other.parseFailures;
+  bytesOut += other.bytesOut;
+  bytesIn += other.bytesIn;
+  for (size_t i = 0; i < kLatencyBuckets; ++i) {
+    latency[i] += other.latency[i];
+  }
+  latencyTotal += other.latencyTotal;
+}
+
+double CommandMetrics::Stats::meanLatency() const {
+  return (answers > 0) ? (double)latencyTotal / answers : 0.0;
+}
+
+long long CommandMetrics::Stats::latencyPercentile(double fraction) const {
+  if (answers == 0) {
+    return 0;
+  }
+
+  const double wanted = min(max(fraction, 0.0), 1.0) * answers;
+  unsigned long count = 0;
+  for (size_t i = 0; i < kLatencyBuckets - 1; ++i) {
+    count += latency[i];
+    if (count >= wanted) {
+      return min(1LL << i, latencyMax);
+    }
+  }
+  return latencyMax;
+}
+
+CommandMetrics::CommandMetrics() : m_commands() {}
+
+void CommandMetrics::clear() { m_commands.clear(); }
+
+void CommandMetrics::addRequest(CmdEnum command) {
+  ++m_commands[command].requests;
+}
+
+void CommandMetrics::addSent(CmdEnum command, size_t bytes) {
+  m_commands[command].bytesOut += bytes;
+}
+
+void CommandMetrics::addRetry(CmdEnum command) {
+  ++m_commands[command].retries;
+}
+
+void CommandMetrics::addTimeout(CmdEnum command) {
+  ++m_commands[command].timeouts;
+}
+
+void CommandMetrics::addAnswer(CmdEnum command, long long usec) {
+  auto &stats = m_commands[command];
+  usec = max(usec, 0LL);
+
+  stats.latencyMin = (stats.answers > 0) ? min(stats.latencyMin, usec) : usec;
+  stats.latencyMax = max(stats.latencyMax, usec);
+  stats.latencyTotal += usec;
+  ++stats.latency[latencyBucket(usec)];
+  ++stats.answers;
+}
+
+void CommandMetrics::addReceived(CmdEnum command, size_t bytes, bool parsed) {
+  auto &stats = m_commands[command];
+  ++stats.received;
+  stats.bytesIn += bytes;
+  if (!parsed) {
+    ++stats.parseFailures;
+  }
+}
+
+const CommandMetrics::StatsMap &CommandMetrics::commands() const {
+  return m_commands;
+}
+
+CommandMetrics::Stats CommandMetrics::stats(CmdEnum command) const {
+  const auto found = m_commands.find(command);
+  return (found != m_commands.end()) ? found->second : Stats();
+}
+
+CommandMetrics::Stats CommandMetrics::total() const {
+  Stats result;
+  for (const auto &item : m_commands) {
+    result.add(item.second);
+  }
+  return result;
+}
+
+void CommandMetrics::write(ostream &stream) const {
+  typedef pair<CmdEnum, Stats> Row;
+
+  vector<Row> rows(m_commands.begin(), m_commands.end());
+  stable_sort(rows.begin(), rows.end(), [](const Row &lhs, const Row &rhs) {
+    return (lhs.second.bytesOut + lhs.second.bytesIn) >
+           (rhs.second.bytesOut + rhs.second.bytesIn);
+  });
+
+  stream << "command\trequests\tanswers\tretries\ttimeouts\treceived\t"
+            "parse failures\tbytes out\tbytes in\tmean usec\tmin usec\t"
+            "p50 usec\tp90 usec\tp99 usec\tmax usec\n";
+
+  for (const auto &row : rows) {
+    stream << "0x" << hex << uppercase << setw(4) << setfill('0')
+           << (int)row.first << dec << nouppercase << setfill(' ');
+    writeStats(stream, row.second);
+  }
+
+  stream << "total";
+  writeStats(stream, total());
+}
+
+bool CommandMetrics::save(const string &fileName) const {
+  ofstream file(fileName.c_str(), ios::out | ios::trunc);
+  if (!file) {
+    return false;
+  }
+  write(file);
+  return file.good();
+}
+
+}  // namespace GeneSysLib
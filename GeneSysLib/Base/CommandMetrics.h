@@ -0,0 +1,87 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __COMMANDMETRICS_H__
+#define __COMMANDMETRICS_H__
+
+#include "LibTypes.h"
+#include "CommandDefines.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/array.hpp>
+#endif
+#include <iosfwd>
+#include <map>
+#include <string>
+
+// bucket i of the latency histogram holds round trips shorter than 2^i usec,
+// the last one everything longer
+#define kLatencyBuckets 24
+
+namespace GeneSysLib {
+
+// Traffic and round trip statistics of each command a Communicator sends
+// and receives. Requests, retries, timeouts and round trips are counted
+// against the command that was sent, bytes in and parse failures against
+// the command that arrived.
+struct CommandMetrics {
+  struct Stats {
+    Stats();
+
+    void add(const Stats &other);
+
+    // usec, 0 without answers
+    double meanLatency() const;
+
+    // the upper bound of the bucket holding the given fraction of answers
+    long long latencyPercentile(double fraction) const;
+
+    unsigned long requests;  // sent by the application, retries excluded
+    unsigned long answers;   // requests retired by their answer
+    unsigned long retries;
+    unsigned long timeouts;  // deadlines passed, retried or not
+    unsigned long received;  // messages that arrived
+    unsigned long parseFailures;
+    unsigned long long bytesOut;  // retries included
+    unsigned long long bytesIn;
+
+    // from the first send of a request to its answer, in usec
+    boost::array<unsigned long, kLatencyBuckets> latency;
+    long long latencyTotal;
+    long long latencyMin;
+    long long latencyMax;
+  };  // struct Stats
+
+  typedef std::map<CmdEnum, Stats> StatsMap;
+
+  CommandMetrics();
+
+  void clear();
+
+  void addRequest(CmdEnum command);
+  void addSent(CmdEnum command, size_t bytes);
+  void addRetry(CmdEnum command);
+  void addTimeout(CmdEnum command);
+  void addAnswer(CmdEnum command, long long usec);
+  void addReceived(CmdEnum command, size_t bytes, bool parsed);
+
+  const StatsMap &commands() const;
+  Stats stats(CmdEnum command) const;
+  Stats total() const;
+
+  // one line per command, the most bytes on the line first, tab separated
+  // with a header so it opens in a spreadsheet
+  void write(std::ostream &stream) const;
+  bool save(const std::string &fileName) const;
+
+ private:
+  StatsMap m_commands;
+};  // struct CommandMetrics
+
+}  // namespace GeneSysLib
+
+#endif  // __COMMANDMETRICS_H__
@@ -6,10 +6,13 @@
 */
 
 #include "Communicator.h"
+#include "ACK.h"
 #include "MyAlgorithms.h"
 
 #ifndef Q_MOC_RUN
+#include <boost/bind.hpp>
 #include <boost/range/adaptors.hpp>
+#include <boost/range/algorithm/find_if.hpp>
 #endif
 
 using namespace std;
@@ -135,37 +138,46 @@ dispatch_queue_t _serialQueue = dispatch_queue_create("com.iconnectivity.sendSys
 #include "RtMidi.h"
 
 #include <QMutex>
+#include <algorithm>
 
 QMutex sendMutex;
-QMutex writeMutex;
+QMutex windowMutex;
+QMutex metricsMutex;
 
 namespace GeneSysLib {
 
 using boost::begin;
 using boost::end;
 
-void readCallback(double, Bytes *data, void *userData) {
+namespace {
 
-  //bugfixing: testing mutex already locked or not to
-  //avoid dead lock situation
-  // --zx, 2016-06-08
-  if(writeMutex.tryLock() == false) {
-     writeMutex.unlock();
-     writeMutex.lock();
-  }
+Word sysexWord(Bytes::const_iterator iter) {
+  return ((*iter << 7) & 0x3F80) | (*(iter + 1) & 0x7F);
+}
+
+// requests each priority class may have queued, beyond that they are
+// refused. Writes from the controls are never refused, the UI shows them as
+// done, instead the oldest queued write makes room for the newest.
+const size_t kQueueSize[kPriorityClasses] = {64, 16, 16};
+
+bool queueHasRoom(RequestPriority::Enum priority, size_t queued) {
+  return queued < kQueueSize[priority];
+}
+
+// requests each class may let into the window per round while others wait
+const int kShare[kPriorityClasses] = {8, 2, 1};
 
+}  // namespace
+
+// Each input has a framer of its own and its callbacks come one at a time,
+// complete frames are handed to the I/O thread so nothing is locked here.
+void readCallback(double, Bytes *data, void *userData) {
   if (data) {
-    Communicator *c = (Communicator *)userData;
-    if (c) {
-      if (c->timerThread) {
-        c->timerThread->stopTimer();
-      }
-      if (c->m_parser) {
-        c->m_parser->parse(*data);
-      }
+    SysexFramer *framer = (SysexFramer *)userData;
+    if (framer) {
+      framer->push(*data);
     }
   }
-  writeMutex.unlock();
 }
 
 #endif  // __IOS__
@@ -179,6 +191,23 @@ Communicator::Communicator()
       m_probeIn(new RtMidiIn()),
       m_probeOut(new RtMidiOut()),
 #endif  // _WIN32
+      m_transport(),
+      m_transportOutputs(),
+      m_inFlight(),
+      m_queued(),
+      m_credits(),
+      m_clock(),
+      m_windowSize(kRequestWindow),
+      m_requestTimeout(kMessageTimeout),
+      m_maxRetries(kMessageRetries),
+      m_metrics(),
+      m_sendQueue(),
+      m_receiveQueue(),
+      m_posted(0),
+      m_written(0),
+      m_ioRunning(true),
+      m_outputsLost(false),
+      m_ioThread(this),
 #endif  // __IOS__
       currentOutPort() {
 #ifdef __IOS__
@@ -212,7 +241,11 @@ Communicator::Communicator()
   }
 
 #else   // NOT __IOS__
+  m_clock.start();
+  m_ioThread.start();
+
   timerThread = boost::shared_ptr<TimerThread>(new TimerThread());
+  timerThread->setPollHandler(boost::bind(&Communicator::checkTimeouts, this));
   timerThread->start();
 #endif  // __IOS__
 
@@ -220,8 +253,16 @@ Communicator::Communicator()
 }
 
 Communicator::~Communicator(void) {
+#ifndef __IOS__
+  timerThread->setPollHandler(TimerThread::PollHandler());
+#endif  // __IOS__
+
   closeAll();
 
+#ifndef __IOS__
+  stopIO();
+#endif  // __IOS__
+
 #ifdef __IOS__
   if (sourcePort != (MIDIPortRef)NULL) {
     MIDIPortDispose(sourcePort);
@@ -238,6 +279,9 @@ unsigned int Communicator::getInCount() {
 #ifdef __IOS__
   return static_cast<int>(MIDIGetNumberOfSources());
 #else  // __IOS__
+  if (m_transport) {
+    return (unsigned int)m_transport->inPorts().size();
+  }
 #ifdef _WIN32
   boost::shared_ptr<RtMidiIn> midiIn =
       boost::shared_ptr<RtMidiIn>(new RtMidiIn);
@@ -253,6 +297,9 @@ unsigned int Communicator::getOutCount() {
 #ifdef __IOS__
   return static_cast<int>(MIDIGetNumberOfDestinations());
 #else  // __IOS__
+  if (m_transport) {
+    return (unsigned int)m_transport->outPorts().size();
+  }
 #ifdef _WIN32
   boost::shared_ptr<RtMidiOut> midiOut =
       boost::shared_ptr<RtMidiOut>(new RtMidiOut);
@@ -287,6 +334,9 @@ vector<string> Communicator::getInPorts() {
   }
 
 #else  // __IOS__
+  if (m_transport) {
+    return m_transport->inPorts();
+  }
 #ifdef _WIN32
   boost::shared_ptr<RtMidiIn> midiIn =
       boost::shared_ptr<RtMidiIn>(new RtMidiIn());
@@ -325,6 +375,9 @@ vector<string> Communicator::getOutPorts() {
     }
   }
 #else  // __IOS__
+  if (m_transport) {
+    return m_transport->outPorts();
+  }
 
 #ifdef _WIN32
   boost::shared_ptr<RtMidiOut> midiOut =
@@ -385,6 +438,15 @@ bool Communicator::openAllInputs() {
   }
 
 #else  // __IOS__
+  if (m_transport) {
+    for (unsigned int i = 0; i < getInCount(); ++i) {
+      m_framers.push_back(new SysexFramer(
+          boost::bind(&Communicator::queueFrame, this, _1, _2)));
+    }
+    return m_transport->openInputs(
+        boost::bind(&Communicator::receive, this, _1, _2));
+  }
+
   try {
     unsigned int inCount = getInCount();
     for (unsigned int i = 0; i < inCount; ++i) {
@@ -393,8 +455,11 @@ bool Communicator::openAllInputs() {
       pIn->openPort(i);
       pIn->ignoreTypes(false);
 
-      pIn->setCallback(readCallback, this);
+      auto pFramer = auto_ptr<SysexFramer>(new SysexFramer(
+          boost::bind(&Communicator::queueFrame, this, _1, _2)));
+      pIn->setCallback(readCallback, pFramer.get());
 
+      m_framers.push_back(pFramer);
       m_midiIn.push_back(pIn);
     }
   }
@@ -429,12 +494,16 @@ bool Communicator::openOutput(unsigned int outPort) {
 
   closeOutputs();
 
-  //bugfixing: testing mutex already being locked or not to
-  //avoid dead lock situation
-  // --zx, 2016-06-08
-  if(writeMutex.tryLock() == false) {
-     writeMutex.unlock();
-     writeMutex.lock();
+  // the ports are shared with the I/O thread
+  QMutexLocker locker(&sendMutex);
+
+  if (m_transport) {
+    if (outPort < getOutCount()) {
+      m_transportOutputs.insert(outPort);
+      currentOutPort = outPort;
+      return true;
+    }
+    return false;
   }
 
   if (!MyAlgorithms::contains(m_midiOut, (int)outPort)) {
@@ -445,14 +514,12 @@ bool Communicator::openOutput(unsigned int outPort) {
       currentOutPort = outPort;
     }
     catch (...) {
-      writeMutex.unlock();
-      closeOutputs();
+      releaseOutputs();
       result = false;
     }
   } else {
     result = false;
   }
-  writeMutex.unlock();
 #endif  // __IOS__
   return result;
 }
@@ -486,25 +553,15 @@ bool Communicator::openAllOutputs() {
   }
 
 #else   // NOT __IOS__
+  // the ports are shared with the I/O thread
+  QMutexLocker locker(&sendMutex);
 
-  //Bugfixing: MIDI communication error hanging software
-  // by iterately calling mutex lock.
-  //
-  //Cause: the "closeOutput" in "catch" block calling mutex
-  // lock before it is unlocked leading dead-lock issue and
-  // hang software.
-  //
-  // Solution: Adding mutex lock checking and unlock mutex before
-  // "closeOutput" called.
-  // --zx, 2016-06-08
-  bool bLocked = true;
-
-  //bugfixing: testing mutex already being locked or not to
-  //avoid dead lock situation
-  // --zx, 2016-06-08
-  if(writeMutex.tryLock() == false) {
-     writeMutex.unlock();
-     writeMutex.lock();
+  if (m_transport) {
+    for (unsigned int outPort = 0; outPort < getOutCount(); ++outPort) {
+      m_transportOutputs.insert(outPort);
+    }
+    currentOutPort = ((getOutCount() > 0) ? (0) : (-1));
+    return result;
   }
 
   currentOutPort = ((getOutCount() > 0) ? (0) : (-1));
@@ -523,30 +580,16 @@ bool Communicator::openAllOutputs() {
         }
       }
       catch (...) {
-      //Bugfixing: --zx, 2016-06-08
-       writeMutex.unlock();
-       bLocked = false;
-
-       closeOutputs();
-       result = false;
-       break;
-      }
-    } else {
-        //Bugfixing: --zx, 2016-06-08
-        writeMutex.unlock();
-        bLocked = false;
-
-        closeOutputs();
+        releaseOutputs();
         result = false;
         break;
+      }
+    } else {
+      releaseOutputs();
+      result = false;
+      break;
     }
   }
-
-  //Bugfixing: --zx, 2016-06-08
-  if(bLocked == true) {
-      bLocked = false;
-      writeMutex.unlock();
-  }
 #endif  // __IOS__
 
   return result;
@@ -573,10 +616,18 @@ bool Communicator::closeInputs() {
 
 #else  // __IOS__
 
+  if (m_transport) {
+    m_transport->closeInputs();
+  }
+
+  // the callbacks use the framers, they are stopped and the inputs deleted,
+  // which waits for their threads, before the framers go
   for (auto &in : m_midiIn) {
+    in.cancelCallback();
     in.closePort();
   }
   m_midiIn.clear();
+  m_framers.clear();
 
 #endif  // __IOS__
 
@@ -599,20 +650,12 @@ bool Communicator::closeOutputs() {
 
 #else  // __IOS__
 
-  //bugfixing: testing mutex already being locked or not to
-  //avoid dead lock situation
-  // --zx, 2016-06-08
-  if(writeMutex.tryLock() == false) {
-     writeMutex.unlock();
-     writeMutex.lock();
-  }
+  // what was sent before the ports close still goes out
+  flushSends();
 
-  for (auto mOut : m_midiOut | map_values) {
-    mOut->closePort();
-    mOut.reset();
-  }
-  m_midiOut.clear();
-  writeMutex.unlock();
+  sendMutex.lock();
+  releaseOutputs();
+  sendMutex.unlock();
 
 #endif  // __IOS__
 
@@ -647,13 +690,15 @@ void Communicator::setCurrentOutput(unsigned int outPort) {
 #ifdef __IOS__
   if (outPort < outEndPoints.size()) {
 #else   // NOT __IOS__
-  if (MyAlgorithms::contains(m_midiOut, (int)outPort)) {
+  if ((MyAlgorithms::contains(m_midiOut, (int)outPort)) ||
+      (MyAlgorithms::contains(m_transportOutputs, outPort))) {
 #endif  // __IOS__
     currentOutPort = outPort;
   }
 }
 
-void Communicator::sendSysex(const Bytes &sysex) {
+bool Communicator::sendSysex(const Bytes &sysex,
+                             RequestPriority::Enum priority) {
 #ifdef __IOS__
   Bytes sysCopy(sysex);
   dispatch_async(_serialQueue, ^{
@@ -719,58 +764,507 @@ void Communicator::sendSysex(const Bytes &sysex) {
     Communicator::waitForAllTimers();
   }
   });
+  return true;
 
 #else  // NOT __IOS__
 
-  //bugfixing:Checking timeout timer existance and stop
-  // running timeout timer to avoid timeout event
-  // interupting during slow communcation process.
-  // -- zx, 2016-06-08
-  //if(timerThread->isTimerActive() == true)
-  timerThread->stopTimer();
+  closeLostPorts();
+  if (sysex.size() < 19) {
+    post(currentOutPort, sysex);
+    return true;
+  }
+
+  PendingRequest request;
+  request.sysex = sysex;
+  request.outPort = currentOutPort;
+  request.command = (CmdEnum)sysexWord(sysex.begin() + 14);
+  request.transID = sysexWord(sysex.begin() + 12);
+  request.priority = priority;
+  request.retryable =
+      (priority != RequestPriority::Meter) && isRetryable(request.command);
+  request.response = responseCommand(request.command);
+  request.sent = 0;
+  request.deadline = 0;
+  request.retries = 0;
+
+  windowMutex.lock();
+  auto &queue = m_queued[priority];
+  if ((priority == RequestPriority::Interactive) &&
+      (!queueHasRoom(priority, queue.size()))) {
+    queue.pop_front();
+  }
+  const bool accepted = queueHasRoom(priority, queue.size());
+  if (accepted) {
+    queue.push_back(std::move(request));
+    dispatch();
+  }
+  windowMutex.unlock();
+
+  if (accepted) {
+    metricsMutex.lock();
+    m_metrics.addRequest((CmdEnum)sysexWord(sysex.begin() + 14));
+    metricsMutex.unlock();
+  }
+  return accepted;
+#endif  // __IOS__
+}
+
+#ifndef __IOS__
+void Communicator::IOThread::run() { m_communicator->runIO(); }
+
+// any thread, the frame is written by the I/O thread in the order queued
+void Communicator::post(unsigned int outPort, const Bytes &sysex) {
+  OutgoingFrame frame;
+  frame.outPort = outPort;
+  frame.sysex = sysex;
+
+  ++m_posted;
+  m_sendQueue.push(std::move(frame));
+  wakeIO();
+}
+
+// the framer of an input, on the thread the input delivers on. The frame is
+// decoded in place, only the answer is queued.
+void Communicator::queueFrame(BytesIter beginIter, BytesIter endIter) {
+  IncomingMessage message;
+  message.size = std::distance(beginIter, endIter);
+  message.transID = (message.size >= 19) ? sysexWord(beginIter + 12) : 0;
+  message.command = (message.size >= 16) ? (CmdEnum)sysexWord(beginIter + 14)
+                                         : Command::Unknown;
+
+  message.decoded = SysexParser::decode(beginIter, endIter, message.deviceID,
+                                        message.transID, message.command,
+                                        message.commandData);
+
+  m_receiveQueue.push(std::move(message));
+  wakeIO();
+}
+
+void Communicator::wakeIO() {
+  m_ioMutex.lock();
+  m_ioWake.wakeOne();
+  m_ioMutex.unlock();
+}
+
+void Communicator::runIO() {
+  std::vector<OutgoingFrame> frames;
+  OutgoingFrame outgoing;
+  IncomingMessage message;
+
+  m_ioMutex.lock();
+  while (m_ioRunning) {
+    if ((m_sendQueue.empty()) && (m_receiveQueue.empty())) {
+      m_ioWake.wait(&m_ioMutex);
+      continue;
+    }
+    m_ioMutex.unlock();
+
+    // everything queued since the last round goes out back to back
+    while (m_sendQueue.pop(outgoing)) {
+      frames.push_back(std::move(outgoing));
+    }
+    if (!frames.empty()) {
+      transmit(frames);
+      m_written += frames.size();
+      frames.clear();
+    }
 
-  //bugfixing: testing mutex already being locked or not to
-  //avoid dead lock situation
-  // --zx, 2016-06-08
-  if(sendMutex.tryLock() == false) {
-     sendMutex.unlock();
-     sendMutex.lock();
+    // the handlers may queue more frames, they go out on the next round
+    while (m_receiveQueue.pop(message)) {
+      handleMessage(message);
+    }
+
+    m_ioMutex.lock();
+    m_ioDrained.wakeAll();
   }
+  m_ioMutex.unlock();
+}
 
-  //bugfxing: flag if send command is not succeded, don't start
-  //timeout timer.
-  //--zx,2016-06-08
-  bool bSucceded = true;
+void Communicator::stopIO() {
+  m_ioMutex.lock();
+  m_ioRunning = false;
+  m_ioWake.wakeOne();
+  m_ioDrained.wakeAll();
+  m_ioMutex.unlock();
 
-  if ((MyAlgorithms::contains(m_midiOut, (int)currentOutPort)) &&
-      m_midiOut.at(currentOutPort)) {
-    Bytes sendBytes = sysex;
+  m_ioThread.wait();
+}
 
-    try {
-      const auto &outPort = m_midiOut.at(currentOutPort);
-      outPort->sendMessage(&sendBytes);
+// waits until the frames queued so far are written, the I/O thread itself
+// cannot wait on them
+void Communicator::flushSends() {
+  if (QThread::currentThread() == &m_ioThread) {
+    return;
+  }
+
+  const unsigned long posted = m_posted;
+  m_ioMutex.lock();
+  while ((m_ioRunning) && (m_written < posted)) {
+    if (!m_ioDrained.wait(&m_ioMutex, kMessageTimeout)) {
+      break;
     }
-    catch (...) {
-      //bugfxing: If send command is not succeded, unlock mutex and flag
-      //the succeded as false.
-      //--zx,2016-06-08
-      bSucceded = false;
-      sendMutex.unlock();
+  }
+  m_ioMutex.unlock();
+}
+
+// the I/O thread only
+void Communicator::transmit(std::vector<OutgoingFrame> &frames) {
+  std::vector<const OutgoingFrame *> sent;
+  bool lost = false;
 
-      closeAll();
+  sendMutex.lock();
+  for (auto &frame : frames) {
+    if (m_outputsLost) {
+      break;
+    }
+    if (m_transport) {
+      if ((MyAlgorithms::contains(m_transportOutputs, frame.outPort)) &&
+          (m_transport->send(frame.outPort, frame.sysex))) {
+        sent.push_back(&frame);
+      }
+    } else if ((MyAlgorithms::contains(m_midiOut, (int)frame.outPort)) &&
+               m_midiOut.at(frame.outPort)) {
+      try {
+        const auto &port = m_midiOut.at(frame.outPort);
+        port->sendMessage(&frame.sysex);
+        sent.push_back(&frame);
+      }
+      catch (...) {
+        lost = true;
+        break;
+      }
     }
   }
+  sendMutex.unlock();
 
-  timerThread->startTimer();
+  metricsMutex.lock();
+  for (auto frame : sent) {
+    if (frame->sysex.size() >= 16) {
+      m_metrics.addSent((CmdEnum)sysexWord(frame->sysex.begin() + 14),
+                        frame->sysex.size());
+    }
+  }
+  metricsMutex.unlock();
 
-  //bugfxing: If send command is succeded, unlock mutex.
-  //--zx,2016-06-08
-  if(bSucceded == false) {
-    sendMutex.unlock();
+  // closing the ports waits for this thread, the next send closes them
+  if (lost) {
+    m_outputsLost = true;
   }
-#endif  // __IOS__
 }
 
+// sendMutex is held
+void Communicator::releaseOutputs() {
+  currentOutPort = -1;
+  m_outputsLost = false;
+  for (auto mOut : m_midiOut | map_values) {
+    mOut->closePort();
+    mOut.reset();
+  }
+  m_midiOut.clear();
+  m_transportOutputs.clear();
+}
+
+// a write failed on the I/O thread, the ports are closed by the next thread
+// that sends as they were before the I/O thread
+void Communicator::closeLostPorts() {
+  if ((m_outputsLost) && (QThread::currentThread() != &m_ioThread)) {
+    closeAll();
+  }
+}
+
+void Communicator::receive(unsigned int inPort, Bytes &data) {
+  if (inPort < m_framers.size()) {
+    readCallback(0.0, &data, &m_framers[inPort]);
+  }
+}
+
+void Communicator::setTransport(TransportPtr transport) {
+  closeAll();
+  m_transport = transport;
+}
+
+void Communicator::setWindowSize(unsigned int size) {
+  windowMutex.lock();
+  m_windowSize = std::max(size, 1u);
+  dispatch();
+  windowMutex.unlock();
+}
+
+unsigned int Communicator::windowSize() const { return m_windowSize; }
+
+void Communicator::setRequestTimeout(int msec) { m_requestTimeout = msec; }
+
+int Communicator::requestTimeout() const { return m_requestTimeout; }
+
+void Communicator::setMaxRetries(int retries) { m_maxRetries = retries; }
+
+unsigned int Communicator::inFlightCount() {
+  windowMutex.lock();
+  unsigned int result = (unsigned int)m_inFlight.size();
+  windowMutex.unlock();
+  return result;
+}
+
+bool Communicator::windowFull() {
+  windowMutex.lock();
+  bool result = (m_inFlight.size() >= m_windowSize);
+  windowMutex.unlock();
+  return result;
+}
+
+void Communicator::clearInFlight(RequestPriority::Enum priority,
+                                 Word transID) {
+  const auto matches = [priority, transID](const PendingRequest &request) {
+    return (request.priority == priority) && (request.transID == transID);
+  };
+
+  windowMutex.lock();
+  m_inFlight.remove_if(matches);
+  auto &queue = m_queued[priority];
+  queue.erase(std::remove_if(queue.begin(), queue.end(), matches),
+              queue.end());
+  dispatch();
+  windowMutex.unlock();
+}
+
+void Communicator::cancelRequest(Word transID) {
+  const auto matches = [transID](const PendingRequest &request) {
+    return request.transID == transID;
+  };
+
+  windowMutex.lock();
+  m_inFlight.remove_if(matches);
+  for (auto &queue : m_queued) {
+    queue.erase(std::remove_if(queue.begin(), queue.end(), matches),
+                queue.end());
+  }
+  dispatch();
+  windowMutex.unlock();
+}
+
+unsigned int Communicator::pendingCount(RequestPriority::Enum priority) {
+  windowMutex.lock();
+  unsigned int result = (unsigned int)m_queued[priority].size();
+  for (const auto &request : m_inFlight) {
+    if (request.priority == priority) {
+      ++result;
+    }
+  }
+  windowMutex.unlock();
+  return result;
+}
+
+bool Communicator::queueFull(RequestPriority::Enum priority) {
+  windowMutex.lock();
+  bool result = !queueHasRoom(priority, m_queued[priority].size());
+  windowMutex.unlock();
+  return result;
+}
+
+// windowMutex is held. Lets queued requests into the window while it has
+// room, the class to go next is picked by nextClass().
+void Communicator::dispatch() {
+  unsigned int inFlight[kPriorityClasses] = {};
+  for (const auto &request : m_inFlight) {
+    ++inFlight[request.priority];
+  }
+
+  for (int next = nextClass(inFlight); next >= 0; next = nextClass(inFlight)) {
+    auto &queue = m_queued[next];
+    PendingRequest request = std::move(queue.front());
+    queue.pop_front();
+
+    // tracked before it is sent so a fast answer can retire it
+    request.sent = m_clock.nsecsElapsed() / 1000;
+    request.deadline = m_clock.elapsed() + m_requestTimeout;
+    m_inFlight.push_back(request);
+    ++inFlight[next];
+    --m_credits[next];
+
+    post(request.outPort, request.sysex);
+  }
+}
+
+// windowMutex is held. The highest priority class with a request queued and
+// some of its share left goes next. Once every class with requests has used
+// its share a new round starts. Only interactive requests may take the last
+// free slot of the window, so a long read never holds the controls up for
+// more than one round trip.
+int Communicator::nextClass(const unsigned int *inFlight) {
+  if (m_inFlight.size() >= m_windowSize) {
+    return -1;
+  }
+
+  for (int round = 0; round < 2; ++round) {
+    bool waiting = false;
+    for (int priority = 0; priority < kPriorityClasses; ++priority) {
+      const unsigned int limit =
+          (priority == RequestPriority::Interactive)
+              ? m_windowSize
+              : std::max(m_windowSize, 2u) - 1;
+      if ((m_queued[priority].empty()) || (inFlight[priority] >= limit)) {
+        continue;
+      }
+      if (m_credits[priority] > 0) {
+        return priority;
+      }
+      waiting = true;
+    }
+
+    if (!waiting) {
+      break;
+    }
+    for (int priority = 0; priority < kPriorityClasses; ++priority) {
+      m_credits[priority] = kShare[priority];
+    }
+  }
+  return -1;
+}
+
+void Communicator::streamSysex(const Bytes &sysex) {
+  streamSysex(currentOutPort, sysex);
+}
+
+void Communicator::streamSysex(unsigned int outPort, const Bytes &sysex) {
+  closeLostPorts();
+  if (sysex.size() >= 16) {
+    metricsMutex.lock();
+    m_metrics.addRequest((CmdEnum)sysexWord(sysex.begin() + 14));
+    metricsMutex.unlock();
+  }
+  post(outPort, sysex);
+}
+
+CommandMetrics Communicator::metrics() {
+  metricsMutex.lock();
+  CommandMetrics result = m_metrics;
+  metricsMutex.unlock();
+  return result;
+}
+
+void Communicator::resetMetrics() {
+  metricsMutex.lock();
+  m_metrics.clear();
+  metricsMutex.unlock();
+}
+
+bool Communicator::saveMetrics(const std::string &fileName) {
+  return metrics().save(fileName);
+}
+
+void Communicator::handleMessage(const IncomingMessage &message) {
+  if (message.size >= 19) {
+    const auto acked = ((message.decoded) && (message.command == Command::ACK))
+                           ? message.commandData.get<ACK>().commandID()
+                           : Command::Unknown;
+    retireRequest(message.transID, message.command, acked);
+  }
+
+  if ((message.decoded) && (m_parser)) {
+    m_parser->dispatch(message.command, message.deviceID, message.transID,
+                       message.commandData);
+  }
+
+  metricsMutex.lock();
+  m_metrics.addReceived(message.command, message.size, message.decoded);
+  metricsMutex.unlock();
+}
+
+void Communicator::retireRequest(Word transID, CmdEnum command,
+                                 CmdEnum ackedCommand) {
+  bool answered = false;
+  CmdEnum requestCommand = Command::Unknown;
+  qint64 latency = 0;
+
+  windowMutex.lock();
+  // The device answers in order so retire the oldest matching request.
+  // Queries and writes share a transaction ID, so an ACK only retires the
+  // request of the command it names. It can also be the error answer to a
+  // query.
+  auto request = find_if(m_inFlight, [&](const PendingRequest &pending) {
+    return ((pending.transID == transID) &&
+            ((command == Command::ACK) ? (pending.command == ackedCommand)
+                                       : (pending.response == command)));
+  });
+  if (request != m_inFlight.end()) {
+    answered = true;
+    requestCommand = request->command;
+    latency = m_clock.nsecsElapsed() / 1000 - request->sent;
+    m_inFlight.erase(request);
+    dispatch();
+  }
+  windowMutex.unlock();
+
+  if (answered) {
+    metricsMutex.lock();
+    m_metrics.addAnswer(requestCommand, latency);
+    metricsMutex.unlock();
+  }
+}
+
+bool Communicator::checkTimeouts() {
+  bool expired = false;
+  std::vector<PendingRequest> resend;
+  std::vector<CmdEnum> timedOut;
+
+  windowMutex.lock();
+  const qint64 now = m_clock.elapsed();
+  for (auto request = m_inFlight.begin(); request != m_inFlight.end();) {
+    if (request->deadline > now) {
+      ++request;
+      continue;
+    }
+
+    timedOut.push_back(request->command);
+
+    // a meter poll is as good as lost, the next cycle asks again
+    if (request->priority == RequestPriority::Meter) {
+      request = m_inFlight.erase(request);
+      continue;
+    }
+
+    if ((!request->retryable) || (request->retries >= m_maxRetries)) {
+      expired = true;
+      break;
+    }
+    ++request->retries;
+    request->deadline = now + m_requestTimeout;
+    resend.push_back(*request);
+    ++request;
+  }
+
+  // once a request has run out of retries the link is considered lost, drop
+  // everything so the owners of the remaining requests can start over
+  if (expired) {
+    m_inFlight.clear();
+    for (auto &queue : m_queued) {
+      queue.clear();
+    }
+    resend.clear();
+  } else {
+    dispatch();
+  }
+  windowMutex.unlock();
+
+  if (!timedOut.empty()) {
+    metricsMutex.lock();
+    for (auto command : timedOut) {
+      m_metrics.addTimeout(command);
+    }
+    for (const auto &request : resend) {
+      m_metrics.addRetry(request.command);
+    }
+    metricsMutex.unlock();
+  }
+
+  for (const auto &request : resend) {
+    post(request.outPort, request.sysex);
+  }
+
+  return expired;
+}
+#endif  // __IOS__
+
 void Communicator::reset() {
 //#ifndef __IOS__
 //  for (auto inIter = m_midiIn.begin(); inIter != m_midiIn.end(); ++inIter) {
@@ -786,10 +1280,12 @@ void Communicator::parseBytes(BytesIter &beginIter, BytesIter &endIter, DeviceID
     auto blockEnd = find(blockStart, endIter, (Byte)0xF7);
 
     while ((blockStart != endIter) && (blockEnd != endIter)) {
-      Bytes block;
-      block.insert(block.end(), blockStart, blockEnd + 1);
+      // the block is patched and parsed in place, no copy is made
+      auto block = blockStart;
+      auto blockSize = std::distance(blockStart, blockEnd + 1);
 
-      if (block[7] == 0 &&
+      if (blockSize >= 19 &&
+          block[7] == 0 &&
           block[8] == 0 &&
           block[9] == 0 &&
           block[10] == 0 &&
@@ -802,13 +1298,13 @@ void Communicator::parseBytes(BytesIter &beginIter, BytesIter &endIter, DeviceID
         block[11] = sn[4];
 
         int acc = 0;
-        for (size_t i = 5; i < block.size() - 2; i++) {
+        for (auto i = 5; i < blockSize - 2; i++) {
           acc += block[i];
         }
-        block[block.size() - 2] = (~(acc) + 1) & 0x7F; // redo crc
+        block[blockSize - 2] = (~(acc) + 1) & 0x7F; // redo crc
       }
 
-      m_parser->parse(block);
+      m_parser->parse(blockStart, blockEnd + 1);
 
       if (blockEnd == endIter) {
         break;
@@ -12,20 +12,32 @@
 #include "ACK.h"
 #include "Generator.h"
 #include "SysexParser.h"
+#include "SysexFramer.h"
 
 #ifndef Q_MOC_RUN
 #include <boost/shared_ptr.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 #endif
+#include <deque>
 
 #ifndef __IOS__
 ////////////////////////////////////////////////////////////////////////////////
 // IOS not includes
 ////////////////////////////////////////////////////////////////////////////////
+#include "CommandMetrics.h"
 #include "DeviceID.h"
 #include "IPMode.h"
+#include "MPSCQueue.h"
 #include "RtMidi.h"
 #include "TimerThread.h"
+#include "Transport.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
 
 #ifndef Q_MOC_RUN
 #include <boost/tuple/tuple.hpp>
@@ -46,6 +58,18 @@ using boost::ptr_vector;
 
 namespace GeneSysLib {
 
+// Who a request is for. Queued requests are let into the request window in
+// this order, every class getting a share of each round so none starves.
+namespace RequestPriority {
+typedef enum Enum {
+  Interactive = 0,  // writes from the controls
+  Meter,            // meter polls, dropped instead of retried
+  Background        // queries, rereads and restores
+} Enum;
+}  // namespace RequestPriority
+
+#define kPriorityClasses 3
+
 struct Communicator {
   Communicator();
   virtual ~Communicator(void);
@@ -67,7 +91,10 @@ struct Communicator {
 #endif
   void setCurrentOutput(unsigned int outPort);
 
-  void sendSysex(const Bytes &sysex);
+  // false if the queue of the priority class is full and the request was
+  // refused. A full Interactive queue drops its oldest request instead.
+  bool sendSysex(const Bytes &sysex, RequestPriority::Enum priority =
+                                         RequestPriority::Interactive);
 
   void reset();
 
@@ -87,6 +114,46 @@ struct Communicator {
   // Not IOS variables
   //////////////////////////////////////////////////////////////////////////////
   boost::shared_ptr<TimerThread> timerThread;
+
+  // talks through the transport instead of the RtMidi ports, set it before
+  // any port is opened
+  void setTransport(TransportPtr transport);
+
+  // in-flight request window
+  void setWindowSize(unsigned int size);
+  unsigned int windowSize() const;
+  void setRequestTimeout(int msec);
+  int requestTimeout() const;
+  void setMaxRetries(int retries);
+
+  unsigned int inFlightCount();
+  bool windowFull();
+
+  // drops the requests of one sender, those of the priority class with the
+  // transaction ID, queued or in the window. Other senders keep theirs.
+  void clearInFlight(RequestPriority::Enum priority, Word transID);
+
+  // drops the requests with the transaction ID, queued or in the window, so
+  // a write its sender has given up on is not sent again
+  void cancelRequest(Word transID);
+
+  // requests of a priority class waiting in its queue or in the window
+  unsigned int pendingCount(RequestPriority::Enum priority);
+  bool queueFull(RequestPriority::Enum priority);
+
+  // sends outside the request window, for periodic traffic that paces itself
+  void streamSysex(const Bytes &sysex);
+  void streamSysex(unsigned int outPort, const Bytes &sysex);
+
+  // per command traffic and round trips since the last reset
+  CommandMetrics metrics();
+  void resetMetrics();
+  bool saveMetrics(const std::string &fileName);
+
+  // `command` is what came back, for an ACK `ackedCommand` is the command it
+  // answers
+  void retireRequest(Word transID, CmdEnum command, CmdEnum ackedCommand);
+  bool checkTimeouts();
 #endif  //__IOS__
 
   boost::shared_ptr<SysexParser> m_parser;
@@ -126,6 +193,7 @@ struct Communicator {
   // Not IOS variables
   //////////////////////////////////////////////////////////////////////////////
   ptr_vector<RtMidiIn> m_midiIn;
+  ptr_vector<SysexFramer> m_framers;
   std::map<int, boost::shared_ptr<RtMidiOut> > m_midiOut;
 #ifndef _WIN32
   //////////////////////////////////////////////////////////////////////////////
@@ -134,6 +202,89 @@ struct Communicator {
   boost::shared_ptr<RtMidiIn> m_probeIn;
   boost::shared_ptr<RtMidiOut> m_probeOut;
 #endif  // _WIN32
+
+  struct PendingRequest {
+    Bytes sysex;
+    unsigned int outPort;
+    Word transID;
+    CmdEnum command;
+    CmdEnum response;
+    RequestPriority::Enum priority;
+    bool retryable;
+    qint64 sent;  // usec of the first send
+    qint64 deadline;
+    int retries;
+  };
+
+  struct OutgoingFrame {
+    unsigned int outPort;
+    Bytes sysex;
+  };
+
+  // a frame as decoded on the thread it arrived on, where the framer holds
+  // its bytes, so only the answer crosses to the I/O thread
+  struct IncomingMessage {
+    size_t size;
+    Word transID;
+    CmdEnum command;  // Unknown if the frame is too short for one
+    bool decoded;
+    DeviceID deviceID;
+    commandData_t commandData;
+  };
+
+  // writes the queued frames and dispatches the received ones, so callers
+  // never wait on the MIDI ports
+  struct IOThread : public QThread {
+    explicit IOThread(Communicator *communicator)
+        : m_communicator(communicator) {}
+
+   protected:
+    void run();
+
+   private:
+    Communicator *m_communicator;
+  };
+
+  void post(unsigned int outPort, const Bytes &sysex);
+  void queueFrame(BytesIter beginIter, BytesIter endIter);
+  void handleMessage(const IncomingMessage &message);
+  void wakeIO();
+  void runIO();
+  void stopIO();
+  void flushSends();
+
+  void dispatch();
+  int nextClass(const unsigned int *inFlight);
+
+  void transmit(std::vector<OutgoingFrame> &frames);
+  void releaseOutputs();
+  void closeLostPorts();
+  void receive(unsigned int inPort, Bytes &data);
+
+  TransportPtr m_transport;
+  std::set<unsigned int> m_transportOutputs;
+
+  std::list<PendingRequest> m_inFlight;
+  std::deque<PendingRequest> m_queued[kPriorityClasses];
+  int m_credits[kPriorityClasses];  // what is left of each share this round
+  QElapsedTimer m_clock;
+
+  unsigned int m_windowSize;
+  int m_requestTimeout;
+  int m_maxRetries;
+
+  CommandMetrics m_metrics;
+
+  MPSCQueue<OutgoingFrame> m_sendQueue;
+  MPSCQueue<IncomingMessage> m_receiveQueue;
+  std::atomic<unsigned long> m_posted;   // frames queued to send
+  std::atomic<unsigned long> m_written;  // of those, frames taken by m_ioThread
+  QMutex m_ioMutex;
+  QWaitCondition m_ioWake;
+  QWaitCondition m_ioDrained;
+  bool m_ioRunning;
+  std::atomic<bool> m_outputsLost;  // a write failed, see closeLostPorts()
+  IOThread m_ioThread;
 #endif  // !__IOS__
 
   unsigned int currentOutPort;
@@ -0,0 +1,167 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "DeviceStateCache.h"
+#include "Generator.h"
+#include "SysexParser.h"
+
+#include <QCryptographicHash>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace GeneSysLib {
+
+namespace {
+
+const Byte kCacheVersion = 0x02;
+const int kHashSize = 16;
+
+QByteArray md5(const Byte *data, size_t size) {
+  return QCryptographicHash::hash(
+      QByteArray::fromRawData((const char *)data, (int)size),
+      QCryptographicHash::Md5);
+}
+
+// "iCC", the PID, the cache file version, the serial number and the
+// firmware version ahead of the answers
+Bytes header(const DeviceID &deviceID, const string &firmware) {
+  Bytes result;
+  result.push_back(0x69);
+  result.push_back(0x43);
+  result.push_back(0x43);
+  result.push_back((deviceID.pid() >> 8) & 0xFF);
+  result.push_back(deviceID.pid() & 0xFF);
+  result.push_back(kCacheVersion);
+
+  const auto serial = deviceID.serialNumber();
+  result.insert(result.end(), serial.begin(), serial.end());
+
+  const size_t size = min(firmware.size(), (size_t)0xFF);
+  result.push_back((Byte)size);
+  result.insert(result.end(), firmware.begin(), firmware.begin() + size);
+  return result;
+}
+
+}  // namespace
+
+DeviceStateCache::DeviceStateCache() : m_answers(), m_families() {}
+
+Bytes DeviceStateCache::build(const DeviceID &deviceID, const string &firmware,
+                              const CommandDataStore &store,
+                              Cacheable cacheable) {
+  set<CmdEnum> families;
+  for (const auto &entry : store) {
+    const auto family = keyToCommand(entry.first);
+    if (cacheable(family)) {
+      const auto D = commandDependancy(family);
+      families.insert(family);
+      families.insert(D.begin(), D.end());
+    }
+  }
+
+  Bytes result = header(deviceID, firmware);
+  for (auto family : families) {
+    store.for_each(family, [&](const commandData_t &data) {
+      generateInto(result, deviceID, 0, family, data);
+    });
+  }
+
+  const QByteArray hash = md5(result.data(), result.size());
+  result.insert(result.end(), hash.begin(), hash.end());
+  return result;
+}
+
+bool DeviceStateCache::load(Bytes data, const DeviceID &deviceID,
+                            const string &firmware, Cacheable cacheable) {
+  clear();
+
+  const Bytes expected = header(deviceID, firmware);
+  if ((data.size() < expected.size() + kHashSize) ||
+      (!equal(expected.begin(), expected.end(), data.begin()))) {
+    return false;
+  }
+
+  const auto finish = data.end() - kHashSize;
+  const QByteArray hash = md5(data.data(), data.size() - kHashSize);
+  if (!equal(hash.begin(), hash.end(), finish,
+             [](char a, Byte b) { return (Byte)a == b; })) {
+    return false;
+  }
+
+  auto blockStart = find(data.begin() + expected.size(), finish, (Byte)0xF0);
+  auto blockEnd = find(blockStart, finish, (Byte)0xF7);
+  while ((blockStart != finish) && (blockEnd != finish)) {
+    DeviceID answerDeviceID;
+    Word answerTransID;
+    CmdEnum command;
+    commandData_t commandData;
+
+    if (SysexParser::decode(blockStart, blockEnd + 1, answerDeviceID,
+                            answerTransID, command, commandData)) {
+      m_answers[commandData.key()] = commandData;
+      if (cacheable(command)) {
+        m_families.insert(command);
+      }
+    }
+
+    blockStart = find(blockEnd, finish, (Byte)0xF0);
+    blockEnd = find(blockStart, finish, (Byte)0xF7);
+  }
+
+  return !m_families.empty();
+}
+
+void DeviceStateCache::clear() {
+  m_answers.clear();
+  m_families.clear();
+}
+
+bool DeviceStateCache::empty() const { return m_families.empty(); }
+
+bool DeviceStateCache::contains(CmdEnum family) const {
+  return m_families.count(family) > 0;
+}
+
+const set<CmdEnum> &DeviceStateCache::families() const { return m_families; }
+
+bool DeviceStateCache::answer(CmdEnum family, CommandDataStore &store) const {
+  if (!contains(family)) {
+    return false;
+  }
+
+  const auto D = commandDependancy(family);
+  if (!all_of(D.begin(), D.end(),
+              [&](CmdEnum d) { return matches(d, store); })) {
+    return false;
+  }
+
+  store.erase(family);
+  m_answers.for_each(family, [&](const commandData_t &data) {
+    store[data.key()] = data;
+  });
+  return true;
+}
+
+// the answers of the family in `store` are those in the file, no more and
+// no fewer
+bool DeviceStateCache::matches(CmdEnum family,
+                               const CommandDataStore &store) const {
+  if (store.count(family) != m_answers.count(family)) {
+    return false;
+  }
+
+  bool result = true;
+  store.for_each(family, [&](const commandData_t &data) {
+    result = result && (m_answers.contains(data.key())) &&
+             (m_answers.at(data.key()).generate() == data.generate());
+  });
+  return result;
+}
+
+}  // namespace GeneSysLib
@@ -0,0 +1,69 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __DEVICESTATECACHE_H__
+#define __DEVICESTATECACHE_H__
+
+#include "CommandDataStore.h"
+#include "CommandDefines.h"
+#include "DeviceID.h"
+#include "LibTypes.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/function.hpp>
+#endif
+#include <set>
+#include <string>
+
+namespace GeneSysLib {
+
+// The answers of the families that only change with the firmware, kept
+// between connections so they need not be queried again. A cache file
+// belongs to one device and firmware version:
+//
+//   69 43 43, PID (2), 02, serial number (5), firmware size, firmware
+//   the Ret frames of the cached families and of those they depend on
+//   MD5 of everything above
+//
+// The answers a cached family was built on are stored along with it. The
+// family is only answered from the cache while the device still gives those
+// same answers.
+struct DeviceStateCache {
+  typedef boost::function<bool(CmdEnum)> Cacheable;
+
+  DeviceStateCache();
+
+  // the file for the answers in `store` of the families `cacheable` is true
+  // for, and of the families they depend on
+  static Bytes build(const DeviceID &deviceID, const std::string &firmware,
+                     const CommandDataStore &store, Cacheable cacheable);
+
+  // false if `data` is not a cache file of the device and firmware, or holds
+  // none of the families `cacheable` is true for
+  bool load(Bytes data, const DeviceID &deviceID,
+            const std::string &firmware, Cacheable cacheable);
+  void clear();
+
+  bool empty() const;
+  bool contains(CmdEnum family) const;
+  const std::set<CmdEnum> &families() const;
+
+  // Copies the cached answers of the family into `store` if the answers it
+  // depends on, already in `store`, are those it was cached with. False if
+  // the family has to be queried.
+  bool answer(CmdEnum family, CommandDataStore &store) const;
+
+ private:
+  bool matches(CmdEnum family, const CommandDataStore &store) const;
+
+  CommandDataStore m_answers;  // every answer in the file
+  std::set<CmdEnum> m_families;  // those that can be answered
+};  // struct DeviceStateCache
+
+}  // namespace GeneSysLib
+
+#endif  // __DEVICESTATECACHE_H__
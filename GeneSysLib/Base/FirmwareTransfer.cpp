@@ -0,0 +1,414 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "FirmwareTransfer.h"
+
+#ifndef __IOS__
+
+#include "ACK.h"
+
+#include <QCryptographicHash>
+
+#ifndef Q_MOC_RUN
+#include <boost/bind.hpp>
+#endif
+#include <algorithm>
+
+using namespace std;
+
+namespace GeneSysLib {
+
+namespace {
+
+// the sequencer specific event holding the MD5 of a firmware file's sysex
+// events: FF 7F 14, 00 01 73 00 and the 16 bytes of the hash
+const Byte kMD5Prefix[] = {0x00, 0x01, 0x73, 0x00};
+const size_t kMD5Size = 16;
+
+Word sysexWord(const Byte *data) {
+  return ((data[0] << 7) & 0x3F80) | (data[1] & 0x7F);
+}
+
+quint32 chunkLong(const Byte *data) {
+  return ((quint32)data[0] << 24) | ((quint32)data[1] << 16) |
+         ((quint32)data[2] << 8) | (quint32)data[3];
+}
+
+// a variable length quantity, false if it runs past end
+bool readVLQ(const Byte *&pos, const Byte *end, size_t &value) {
+  value = 0;
+  for (int i = 0; (i < 4) && (pos < end); ++i) {
+    const Byte byte = *pos++;
+    value = (value << 7) | (byte & 0x7F);
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// what the file holds of the firmware, the frames are appended as sent
+struct Image {
+  Image(Bytes &data, QCryptographicHash &hash)
+      : data(data), hash(hash), starts(), storedMD5() {}
+
+  void addFrame(const Byte *event, const Byte *begin, const Byte *end) {
+    hash.addData((const char *)event, (int)(end - event));
+    starts.push_back(data.size());
+    data.push_back(0xF0);
+    data.insert(data.end(), begin, end);
+  }
+
+  Bytes &data;
+  QCryptographicHash &hash;
+  std::vector<size_t> starts;
+  QByteArray storedMD5;
+};
+
+// the events of one track, stops at the first it cannot make sense of
+void readTrack(const Byte *pos, const Byte *end, Image &image) {
+  Byte running = 0;
+  while (pos < end) {
+    size_t delta = 0;
+    if ((!readVLQ(pos, end, delta)) || (pos >= end)) {
+      return;
+    }
+
+    const Byte *event = pos;
+    Byte status = *pos;
+    if (status >= 0x80) {
+      ++pos;
+    } else if (running != 0) {
+      status = running;
+    } else {
+      return;
+    }
+
+    size_t length = 0;
+    if (status == 0xFF) {
+      if (pos >= end) {
+        return;
+      }
+      const Byte type = *pos++;
+      if ((!readVLQ(pos, end, length)) || (length > (size_t)(end - pos))) {
+        return;
+      }
+      if ((type == 0x7F) && (length == sizeof(kMD5Prefix) + kMD5Size) &&
+          (equal(kMD5Prefix, kMD5Prefix + sizeof(kMD5Prefix), pos))) {
+        image.storedMD5 =
+            QByteArray((const char *)pos + sizeof(kMD5Prefix), (int)kMD5Size);
+      }
+    } else if ((status == 0xF0) || (status == 0xF7)) {
+      if ((!readVLQ(pos, end, length)) || (length > (size_t)(end - pos))) {
+        return;
+      }
+      // the length is only part of the file, the device gets F0 and the rest
+      if ((status == 0xF0) && (length > 0)) {
+        image.addFrame(event, pos, pos + length);
+      }
+    } else if (status > 0xF0) {
+      return;
+    } else {
+      running = status;
+      length = (((status & 0xF0) == 0xC0) || ((status & 0xF0) == 0xD0)) ? 1 : 2;
+      length = min(length, (size_t)(end - pos));
+    }
+    pos += length;
+  }
+}
+
+// bare sysex messages one after the other, as a .syx file holds them
+void readSysex(const Byte *pos, const Byte *end, Image &image) {
+  while ((pos = find(pos, end, (Byte)0xF0)) != end) {
+    const Byte *last = find(pos, end, (Byte)0xF7);
+    if (last == end) {
+      return;
+    }
+    image.addFrame(pos, pos + 1, last + 1);
+    pos = last + 1;
+  }
+}
+
+}  // namespace
+
+FirmwareTransfer::FirmwareTransfer(CommPtr comm)
+    : m_comm(comm),
+      m_handlerRegistered(false),
+      m_data(),
+      m_frames(),
+      m_state(Idle),
+      m_acked(0),
+      m_next(0),
+      m_bytesAcked(0),
+      m_window(1),
+      m_limit(kFirmwareWindow),
+      m_lastAnswer(0),
+      m_retries(0),
+      m_stalls(0),
+      m_started(0),
+      m_startBytes(0),
+      m_maxWindow(kFirmwareWindow),
+      m_stallTimeout(kFirmwareStallTimeout),
+      m_maxRetries(kFirmwareRetries) {
+  m_clock.start();
+}
+
+FirmwareTransfer::~FirmwareTransfer() { cancel(); }
+
+bool FirmwareTransfer::load(const Byte *data, size_t size) {
+  static const Byte header[] = {'M', 'T', 'h', 'd'};
+
+  QMutexLocker locker(&m_mutex);
+  m_state = Idle;
+  m_data.clear();
+  m_frames.clear();
+  m_data.reserve(size);
+
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  Image image(m_data, hash);
+
+  const Byte *end = data + size;
+  if ((size >= 8) && (equal(header, header + 4, data))) {
+    const Byte *pos = data;
+    while (end - pos >= 8) {
+      const size_t length = chunkLong(pos + 4);
+      const Byte *chunk = pos + 8;
+      if (length > (size_t)(end - chunk)) {
+        break;
+      }
+      if (equal(pos, pos + 4, "MTrk")) {
+        readTrack(chunk, chunk + length, image);
+      }
+      pos = chunk + length;
+    }
+  } else {
+    readSysex(data, end, image);
+  }
+
+  for (size_t i = 0; i < image.starts.size(); ++i) {
+    Frame frame;
+    frame.offset = image.starts[i];
+    frame.size = ((i + 1 < image.starts.size()) ? image.starts[i + 1]
+                                                : m_data.size()) -
+                 frame.offset;
+    frame.transID =
+        (frame.size >= 14) ? sysexWord(&m_data[frame.offset + 12]) : (Word)0;
+    m_frames.push_back(frame);
+  }
+
+  if ((m_frames.empty()) ||
+      ((image.storedMD5.size() == (int)kMD5Size) &&
+       (hash.result() != image.storedMD5))) {
+    m_data.clear();
+    m_frames.clear();
+    return false;
+  }
+  return true;
+}
+
+void FirmwareTransfer::setMaxWindow(unsigned int frames) {
+  QMutexLocker locker(&m_mutex);
+  m_maxWindow = max(frames, 1u);
+  m_limit = min(m_limit, m_maxWindow);
+}
+
+void FirmwareTransfer::setStallTimeout(int msec) {
+  QMutexLocker locker(&m_mutex);
+  m_stallTimeout = max(msec, 0);
+}
+
+void FirmwareTransfer::setMaxRetries(int retries) {
+  QMutexLocker locker(&m_mutex);
+  m_maxRetries = max(retries, 0);
+}
+
+void FirmwareTransfer::start() {
+  begin();
+
+  QMutexLocker locker(&m_mutex);
+  m_acked = 0;
+  m_bytesAcked = 0;
+  m_limit = m_maxWindow;
+  m_stalls = 0;
+  restart();
+}
+
+void FirmwareTransfer::resume() {
+  begin();
+
+  QMutexLocker locker(&m_mutex);
+  restart();
+}
+
+void FirmwareTransfer::cancel() {
+  m_mutex.lock();
+  if (m_state == Sending) {
+    m_state = Idle;
+  }
+  m_mutex.unlock();
+
+  release();
+}
+
+bool FirmwareTransfer::poll() {
+  QMutexLocker locker(&m_mutex);
+  const qint64 now = m_clock.elapsed();
+  if ((m_state == Sending) && (now - m_lastAnswer >= m_stallTimeout)) {
+    goBack(now);
+  }
+
+  const bool sending = (m_state == Sending);
+  locker.unlock();
+
+  if (!sending) {
+    release();
+  }
+  return sending;
+}
+
+FirmwareTransfer::State FirmwareTransfer::state() {
+  QMutexLocker locker(&m_mutex);
+  return m_state;
+}
+
+FirmwareTransfer::Progress FirmwareTransfer::progress() {
+  QMutexLocker locker(&m_mutex);
+  const qint64 now = m_clock.elapsed();
+  const qint64 elapsed = now - m_started;
+
+  Progress result;
+  result.frames = m_frames.size();
+  result.framesAcked = m_acked;
+  result.bytes = m_data.size();
+  result.bytesAcked = m_bytesAcked;
+  result.bytesPerSecond =
+      (elapsed > 0) ? (m_bytesAcked - m_startBytes) * 1000.0 / elapsed : 0.0;
+  result.remaining =
+      (result.bytesPerSecond > 0.0)
+          ? (qint64)((result.bytes - result.bytesAcked) * 1000.0 /
+                     result.bytesPerSecond)
+          : -1;
+  result.sinceAnswer = (m_state == Sending) ? now - m_lastAnswer : 0;
+  result.window = m_window;
+  result.stalls = m_stalls;
+  return result;
+}
+
+void FirmwareTransfer::handleACK(CmdEnum, DeviceID, Word transID,
+                                 const commandData_t &commandData) {
+  QMutexLocker locker(&m_mutex);
+  if ((m_state != Sending) || (m_acked >= m_next)) {
+    return;
+  }
+
+  // a late answer to a frame sent again after a stall
+  const auto &frame = m_frames[m_acked];
+  if (transID != frame.transID) {
+    return;
+  }
+
+  const qint64 now = m_clock.elapsed();
+  if (commandData.get<ACK>().errorCode() != 0) {
+    goBack(now);
+    return;
+  }
+
+  ++m_acked;
+  m_bytesAcked += frame.size;
+  m_lastAnswer = now;
+  m_retries = 0;
+  if (m_window < m_limit) {
+    ++m_window;
+  }
+
+  if (m_acked == m_frames.size()) {
+    m_state = Complete;
+  } else {
+    fill();
+  }
+}
+
+// the caller holds the lock
+void FirmwareTransfer::restart() {
+  const qint64 now = m_clock.elapsed();
+  m_next = m_acked;
+  m_window = 1;
+  m_retries = 0;
+  m_lastAnswer = now;
+  m_started = now;
+  m_startBytes = m_bytesAcked;
+
+  if (m_acked >= m_frames.size()) {
+    m_state = m_frames.empty() ? Idle : Complete;
+    return;
+  }
+  m_state = Sending;
+  fill();
+}
+
+void FirmwareTransfer::begin() {
+  if ((m_comm) && (!m_handlerRegistered)) {
+    m_comm->registerExclusiveHandler(
+        Command::ACK,
+        boost::bind(&FirmwareTransfer::handleACK, this, _1, _2, _3, _4));
+    m_handlerRegistered = true;
+  }
+}
+
+// the caller holds the lock
+void FirmwareTransfer::goBack(qint64 now) {
+  ++m_stalls;
+  if (++m_retries > m_maxRetries) {
+    m_state = Failed;
+    return;
+  }
+
+  // the bootloader gave up with this many unanswered, stay below that
+  const unsigned int unanswered = (unsigned int)(m_next - m_acked);
+  if (unanswered > 0) {
+    m_limit = max(min(m_limit, unanswered), 2u) - 1;
+  }
+
+  m_window = 1;
+  m_next = m_acked;
+  m_lastAnswer = now;
+  fill();
+}
+
+// the caller holds the lock
+void FirmwareTransfer::fill() {
+  if (!m_comm) {
+    return;
+  }
+
+  while ((m_next < m_frames.size()) && (m_next - m_acked < m_window)) {
+    // ACKs are matched by transaction ID, a frame that repeats the ID of
+    // one in flight waits until that one is answered
+    const auto &frame = m_frames[m_next];
+    for (size_t i = m_acked; i < m_next; ++i) {
+      if (m_frames[i].transID == frame.transID) {
+        return;
+      }
+    }
+
+    ++m_next;
+    const auto begin = m_data.begin() + frame.offset;
+    m_comm->streamSysex(Bytes(begin, begin + frame.size));
+  }
+}
+
+// not from the ACK handler, the parser is running it
+void FirmwareTransfer::release() {
+  if ((m_comm) && (m_handlerRegistered)) {
+    m_comm->unRegisterExclusiveHandler();
+    m_handlerRegistered = false;
+  }
+}
+
+}  // namespace GeneSysLib
+
+#endif  // __IOS__
@@ -0,0 +1,129 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __FIRMWARETRANSFER_H__
+#define __FIRMWARETRANSFER_H__
+
+#ifndef __IOS__
+
+#include "LibTypes.h"
+#include "CommandData.h"
+#include "Communicator.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <vector>
+
+#define kFirmwareWindow 1          // frames unanswered at most
+#define kFirmwareStallTimeout 5000  // msec without an ACK before going back
+#define kFirmwareRetries 3          // stalls in a row before giving up
+
+namespace GeneSysLib {
+
+// Streams a firmware image to a device in bootloader mode. The sysex events
+// of the MIDI file are read once into a table of frames kept back to back in
+// one buffer, then sent outside the request window while the transfer paces
+// itself on the bootloader's ACKs.
+//
+// The window of unanswered frames opens by one with each ACK, up to the
+// largest the bootloader has kept up with. It is one frame, the old
+// send-and-wait, unless setMaxWindow() raises it for a model whose
+// bootloader is known to buffer more. ACKs are matched by transaction ID,
+// so a frame repeating the ID of one in flight is held back until that one
+// is answered. When it stalls or refuses a frame
+// the window closes to one, the limit is lowered below where it gave up and
+// sending goes back to the first frame not acknowledged. After
+// `maxRetries` stalls without progress the transfer fails, resume() picks it
+// up again from the same frame.
+struct FirmwareTransfer {
+  typedef enum State { Idle, Sending, Complete, Failed } State;
+
+  struct Progress {
+    size_t frames;
+    size_t framesAcked;
+    size_t bytes;
+    size_t bytesAcked;
+    double bytesPerSecond;  // acknowledged, since the transfer (re)started
+    qint64 remaining;       // msec, -1 until a rate is known
+    qint64 sinceAnswer;     // msec since the last ACK
+    unsigned int window;
+    int stalls;
+  };
+
+  FirmwareTransfer(CommPtr comm);
+  ~FirmwareTransfer();
+
+  // Reads the sysex events of a standard MIDI file, or a file of bare sysex
+  // messages, into the frame table. False if there are none or the file
+  // carries an MD5 of its sysex events that does not match them.
+  bool load(const Byte *data, size_t size);
+
+  void setMaxWindow(unsigned int frames);
+  void setStallTimeout(int msec);
+  void setMaxRetries(int retries);
+
+  // sends from the first frame, or from the first one not acknowledged
+  void start();
+  void resume();
+  void cancel();
+
+  // goes back when the bootloader stalled and lets go of the ACK handler
+  // once done, returns true while sending
+  bool poll();
+
+  State state();
+  Progress progress();
+
+ private:
+  struct Frame {
+    size_t offset;  // in m_data
+    size_t size;
+    Word transID;
+  };
+
+  void handleACK(CmdEnum command, DeviceID deviceID, Word transID,
+                 const commandData_t &commandData);
+
+  void begin();
+  void restart();
+  void goBack(qint64 now);
+  void fill();
+  void release();
+
+  CommPtr m_comm;
+  bool m_handlerRegistered;
+
+  Bytes m_data;
+  std::vector<Frame> m_frames;
+
+  QMutex m_mutex;
+  QElapsedTimer m_clock;
+  State m_state;
+
+  size_t m_acked;  // frames acknowledged, all before any unanswered one
+  size_t m_next;   // the next frame to send
+  size_t m_bytesAcked;
+  unsigned int m_window;
+  unsigned int m_limit;  // what the bootloader has kept up with so far
+  qint64 m_lastAnswer;
+  int m_retries;
+  int m_stalls;
+
+  qint64 m_started;  // when sending last (re)started
+  size_t m_startBytes;
+
+  unsigned int m_maxWindow;
+  int m_stallTimeout;
+  int m_maxRetries;
+};  // struct FirmwareTransfer
+
+}  // namespace GeneSysLib
+
+#endif  // __IOS__
+
+#endif  // __FIRMWARETRANSFER_H__
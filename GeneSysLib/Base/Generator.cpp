@@ -6,42 +6,72 @@
 */
 
 #include "stdafx.h"
-#include <numeric>
+#include <algorithm>
 #include "Generator.h"
 #include "CommandData.h"
 #include "Info.h"
 #include "ACK.h"
 
-#ifndef Q_MOC_RUN
-#include <boost/range.hpp>
-#include <boost/range/algorithm_ext/push_back.hpp>
-#endif
+// the start, PID, serial number, transaction ID, command and payload length
+#define kSysexHeaderSize 18
+
+// checksum and F7
+#define kSysexFooterSize 2
 
 using namespace std;
-using namespace boost;
-using boost::range::push_back;
 
 namespace GeneSysLib {
 
+namespace {
+
+// F0, the manufacturer ID and 7E, the checksum does not cover these
+const Byte kSysexStart[] = {0xF0, 0x00, 0x01, 0x73, 0x7E};
+
+}  // namespace
+
 Bytes generate(DeviceID deviceID, Word transID, CmdEnum commandID,
                const commandData_t &data) {
   Bytes sysex;
-  sysex += 0xF0, 0x00, 0x01, 0x73, 0x7E;  // header
+  generateInto(sysex, deviceID, transID, commandID, data);
+  return sysex;
+}
 
-  appendMidiWord(sysex, deviceID.pid());
-  push_back(sysex, deviceID.serialNumber());
-  appendMidiWord(sysex, transID);
-  appendMidiWord(sysex, static_cast<Word>(commandID));
+size_t generateInto(Bytes &sysex, DeviceID deviceID, Word transID,
+                    CmdEnum commandID, const commandData_t &data) {
+  const auto &payload = data.generate();
+  const auto size = kSysexHeaderSize + payload.size() + kSysexFooterSize;
 
-  const auto &generatedData = data.generate();
-  appendMidiWord(sysex, (Word)(generatedData.size()));
-  push_back(sysex, generatedData);
+  const auto offset = sysex.size();
+  sysex.resize(offset + size);
 
-  // checksum
-  sysex += (~(accumulate(sysex.begin() + 5, sysex.end(), 0x00)) + 1) & 0x7F;
+  auto out = &sysex[offset];
+  out = copy(kSysexStart, kSysexStart + sizeof(kSysexStart), out);
 
-  sysex += 0xF7;
-  return sysex;
+  unsigned int sum = 0;
+  const auto put = [&](Byte value) {
+    *out++ = value;
+    sum += value;
+  };
+  const auto putWord = [&](Word value) {
+    put((value >> 7) & 0x7F);
+    put(value & 0x7F);
+  };
+
+  putWord(deviceID.pid());
+  for (auto value : deviceID.serialNumber()) {
+    put(value);
+  }
+  putWord(transID);
+  putWord(static_cast<Word>(commandID));
+  putWord(static_cast<Word>(payload.size()));
+  for (auto value : payload) {
+    put(value);
+  }
+
+  *out++ = (~sum + 1) & 0x7F;
+  *out = 0xF7;
+
+  return size;
 }
 
 }  // namespace GeneSysLib
@@ -19,6 +19,12 @@ namespace GeneSysLib {
 Bytes generate(DeviceID deviceID, Word transID, CmdEnum commandID,
                const commandData_t &data);
 
+// Appends the complete sysex message to the end of sysex and returns its
+// size. The checksum is summed while the message is written, so many
+// commands can be generated back to back into one reused buffer.
+size_t generateInto(Bytes &sysex, DeviceID deviceID, Word transID,
+                    CmdEnum commandID, const commandData_t &data);
+
 }  // namespace GeneSysLib
 
 // Audio Related
@@ -18,6 +18,8 @@
 #include "property.h"
 
 #define kMessageTimeout 2000
+#define kMessageRetries 2
+#define kRequestWindow 8
 
 typedef unsigned char Byte;
 typedef std::vector<Byte> Bytes;
@@ -41,6 +43,6 @@ struct commandData_t;
 
 // function (Command, DeviceID, TransID, commandData_t*)
 typedef boost::function<void(GeneSysLib::CmdEnum, GeneSysLib::DeviceID, Word,
-                             GeneSysLib::commandData_t)> Handler;
+                             const GeneSysLib::commandData_t &)> Handler;
 
 #endif  // __LIBTYPES_H__
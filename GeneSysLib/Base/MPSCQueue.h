@@ -0,0 +1,75 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __MPSCQUEUE_H__
+#define __MPSCQUEUE_H__
+
+#include <atomic>
+#include <utility>
+
+namespace GeneSysLib {
+
+// An unbounded FIFO any number of threads push to and a single thread pops
+// from. Pushing never blocks or waits on another thread: it allocates a node
+// and swaps it in with one atomic exchange. A push still in progress is not
+// seen by pop() until it completes, so producers wake the consumer after
+// they push.
+template <typename T>
+struct MPSCQueue {
+  MPSCQueue() : m_head(new Node()), m_tail(m_head.load()) {}
+
+  ~MPSCQueue() {
+    T item;
+    while (pop(item)) {
+    }
+    delete m_tail;
+  }
+
+  // any thread
+  void push(T item) {
+    Node *node = new Node(std::move(item));
+    Node *previous = m_head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+  // the consumer thread only, false when there is nothing to take
+  bool pop(T &item) {
+    Node *next = m_tail->next.load(std::memory_order_acquire);
+    if (!next) {
+      return false;
+    }
+    item = std::move(next->value);
+    delete m_tail;
+    m_tail = next;
+    return true;
+  }
+
+  // the consumer thread only
+  bool empty() const {
+    return m_tail->next.load(std::memory_order_acquire) == 0;
+  }
+
+ private:
+  // the node at m_tail has been taken already, its successor is the front
+  struct Node {
+    Node() : next(0), value() {}
+    explicit Node(T &&item) : next(0), value(std::move(item)) {}
+
+    std::atomic<Node *> next;
+    T value;
+  };
+
+  MPSCQueue(const MPSCQueue &);
+  MPSCQueue &operator=(const MPSCQueue &);
+
+  std::atomic<Node *> m_head;  // the last node pushed
+  Node *m_tail;
+};  // struct MPSCQueue
+
+}  // namespace GeneSysLib
+
+#endif  // __MPSCQUEUE_H__
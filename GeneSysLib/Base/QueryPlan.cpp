@@ -0,0 +1,128 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "QueryPlan.h"
+
+#include <map>
+
+using namespace std;
+
+namespace GeneSysLib {
+
+namespace {
+
+struct Node {
+  Node() : order(0), depth(-1), visiting(false) {}
+
+  size_t order;  // when the family joined the plan
+  int depth;     // the level, -1 until known
+  bool visiting;
+  vector<CmdEnum> dependencies;
+};
+
+typedef map<CmdEnum, Node> Graph;
+
+// one level past the deepest prerequisite, each node is visited once
+int depthOf(Graph &graph, CmdEnum command) {
+  auto &node = graph[command];
+  if (node.depth >= 0) {
+    return node.depth;
+  }
+  if (node.visiting) {
+    // a cycle in the dependency table, do not wait on it
+    return -1;
+  }
+
+  node.visiting = true;
+  int depth = 0;
+  for (auto dependency : node.dependencies) {
+    depth = max(depth, depthOf(graph, dependency) + 1);
+  }
+  node.visiting = false;
+  node.depth = depth;
+  return depth;
+}
+
+}  // namespace
+
+QueryPlan::QueryPlan() : m_levels() {}
+
+QueryPlan::QueryPlan(const list<CmdEnum> &query, Answered answered,
+                     Dependencies dependencies)
+    : m_levels() {
+  Graph graph;
+
+  // the query and every missing prerequisite, each expanded once
+  deque<CmdEnum> open;
+  for (auto command : query) {
+    if (graph.count(command) == 0) {
+      const auto order = graph.size();
+      graph[command].order = order;
+      open.push_back(command);
+    }
+  }
+
+  while (!open.empty()) {
+    const auto command = open.front();
+    open.pop_front();
+
+    for (auto dependency : dependencies(command)) {
+      if ((dependency == command) || (answered(dependency))) {
+        continue;
+      }
+      if (graph.count(dependency) == 0) {
+        const auto order = graph.size();
+        graph[dependency].order = order;
+        open.push_back(dependency);
+      }
+      graph[command].dependencies.push_back(dependency);
+    }
+  }
+
+  // the families of a level keep the order they joined the plan in
+  vector<CmdEnum> joined(graph.size());
+  for (const auto &item : graph) {
+    joined[item.second.order] = item.first;
+  }
+
+  for (auto command : joined) {
+    const auto depth = (size_t)max(depthOf(graph, command), 0);
+    if (m_levels.size() <= depth) {
+      m_levels.resize(depth + 1);
+    }
+    m_levels[depth].push_back(command);
+  }
+}
+
+bool QueryPlan::empty() const { return m_levels.empty(); }
+
+void QueryPlan::clear() { m_levels.clear(); }
+
+size_t QueryPlan::levelCount() const { return m_levels.size(); }
+
+const QueryPlan::Level &QueryPlan::level(size_t index) const {
+  return m_levels.at(index);
+}
+
+QueryPlan::Level QueryPlan::order() const {
+  Level result;
+  for (const auto &level : m_levels) {
+    result.insert(result.end(), level.begin(), level.end());
+  }
+  return result;
+}
+
+QueryPlan::Level QueryPlan::takeLevel() {
+  Level result;
+  if (!m_levels.empty()) {
+    result.swap(m_levels.front());
+    m_levels.pop_front();
+  }
+  return result;
+}
+
+}  // namespace GeneSysLib
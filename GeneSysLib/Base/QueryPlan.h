@@ -0,0 +1,57 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __QUERYPLAN_H__
+#define __QUERYPLAN_H__
+
+#include "CommandDefines.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/function.hpp>
+#endif
+#include <deque>
+#include <list>
+#include <set>
+#include <vector>
+
+namespace GeneSysLib {
+
+// The families of a query and the prerequisites they are missing, scheduled
+// over the graph of commandDependancy(). Families are grouped into levels so
+// a family only depends on families of earlier levels; the families of one
+// level are independent of each other and can be asked for together.
+struct QueryPlan {
+  typedef std::vector<CmdEnum> Level;
+  typedef boost::function<bool(CmdEnum)> Answered;
+  typedef boost::function<std::set<CmdEnum>(CmdEnum)> Dependencies;
+
+  QueryPlan();
+
+  // a prerequisite is part of the plan unless `answered` is true for it,
+  // the prerequisites of a family are looked up in `dependencies`
+  QueryPlan(const std::list<CmdEnum> &query, Answered answered,
+            Dependencies dependencies = &commandDependancy);
+
+  bool empty() const;
+  void clear();
+
+  size_t levelCount() const;
+  const Level &level(size_t index) const;
+
+  // every family of the plan in the order they will be asked for
+  Level order() const;
+
+  // removes and returns the first level
+  Level takeLevel();
+
+ private:
+  std::deque<Level> m_levels;
+};  // struct QueryPlan
+
+}  // namespace GeneSysLib
+
+#endif  // __QUERYPLAN_H__
@@ -22,8 +22,9 @@ struct SysexCommand {
 
   Bytes sysex() const { return generate(deviceID, transID, CMD, data); }
 
-  void send(const CommPtr &comm) const {
-    comm->sendSysex(sysex());
+  // false if the communicator refused it, see Communicator::sendSysex
+  bool send(const CommPtr &comm) const {
+    return comm->sendSysex(sysex());
   }
 
  protected:
@@ -38,8 +39,8 @@ Bytes sysex(const T &x) {
 }
 
 template <class DATA_T>
-void send(const DATA_T &x, const CommPtr &comm) {
-  x.send(comm);
+bool send(const DATA_T &x, const CommPtr &comm) {
+  return x.send(comm);
 }
 
 }  // namespace GeneSysLib
@@ -0,0 +1,79 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "SysexFramer.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace GeneSysLib {
+
+SysexFramer::SysexFramer(FrameHandler handler, size_t capacity)
+    : m_handler(handler), m_buffer(), m_inFrame(false) {
+  m_buffer.reserve(capacity);
+}
+
+void SysexFramer::push(Bytes &data) { push(data.begin(), data.end()); }
+
+void SysexFramer::push(BytesIter beginIter, BytesIter endIter) {
+  while (beginIter != endIter) {
+    if (!m_inFrame) {
+      beginIter = find(beginIter, endIter, (Byte)0xF0);
+      if (beginIter == endIter) {
+        break;
+      }
+
+      auto frameEnd = find(beginIter, endIter, (Byte)0xF7);
+      if (frameEnd != endIter) {
+        // the whole frame is in the caller's buffer, dispatch it in place
+        ++frameEnd;
+        if (m_handler) {
+          m_handler(beginIter, frameEnd);
+        }
+        beginIter = frameEnd;
+      } else {
+        // the frame continues in a later chunk
+        m_inFrame = true;
+        m_buffer.clear();
+        append(beginIter, endIter);
+        beginIter = endIter;
+      }
+    } else {
+      auto frameEnd = find(beginIter, endIter, (Byte)0xF7);
+      if (frameEnd != endIter) {
+        ++frameEnd;
+      }
+      append(beginIter, frameEnd);
+      beginIter = frameEnd;
+
+      if ((!m_buffer.empty()) && (m_buffer.back() == 0xF7)) {
+        m_inFrame = false;
+        if (m_handler) {
+          m_handler(m_buffer.begin(), m_buffer.end());
+        }
+        m_buffer.clear();
+      }
+    }
+  }
+}
+
+void SysexFramer::reset() {
+  m_inFrame = false;
+  m_buffer.clear();
+}
+
+void SysexFramer::append(BytesIter beginIter, BytesIter endIter) {
+  // drop frames that would outgrow the buffer rather than reallocating it
+  if (m_buffer.size() + distance(beginIter, endIter) > m_buffer.capacity()) {
+    reset();
+  } else {
+    m_buffer.insert(m_buffer.end(), beginIter, endIter);
+  }
+}
+
+}  // namespace GeneSysLib
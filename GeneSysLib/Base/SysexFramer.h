@@ -0,0 +1,45 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __SYSEXFRAMER_H__
+#define __SYSEXFRAMER_H__
+
+#include "LibTypes.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/function.hpp>
+#endif
+
+#define kFramerCapacity 4096
+
+namespace GeneSysLib {
+
+// Splits an incoming MIDI byte stream into F0..F7 frames. Complete frames are
+// handed to the frame handler as a view into either the caller's buffer or
+// the framer's own buffer, which is reused for the life of the framer so no
+// memory is allocated per frame.
+struct SysexFramer {
+  typedef boost::function<void(BytesIter, BytesIter)> FrameHandler;
+
+  explicit SysexFramer(FrameHandler handler,
+                       size_t capacity = kFramerCapacity);
+
+  void push(Bytes &data);
+  void push(BytesIter beginIter, BytesIter endIter);
+  void reset();
+
+ private:
+  void append(BytesIter beginIter, BytesIter endIter);
+
+  FrameHandler m_handler;
+  Bytes m_buffer;
+  bool m_inFrame;
+};  // struct SysexFramer
+
+}  // namespace GeneSysLib
+
+#endif  // __SYSEXFRAMER_H__
@@ -59,7 +59,7 @@
 #include "MixerPortParm.h"
 #include "MixerMeterValue.h"
 
-#include <map>
+#include <algorithm>
 #include <numeric>
 #ifndef Q_MOC_RUN
 #include <boost/range.hpp>
@@ -73,71 +73,223 @@ using namespace MyAlgorithms;
 
 namespace GeneSysLib {
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// command data factories
+//
+// CommandDataType maps an answer command to the type that parses it. The
+// factory table below is indexed by command ID and only holds function
+// addresses, so it is constant initialized by the compiler and needs no
+// run-time setup or locking.
+////////////////////////////////////////////////////////////////////////////////
+typedef commandData_t (*CommandDataFactory)();
+
+template <int CMD>
+struct CommandDataType {
+  typedef BytesCommandData<Command::Unknown> type;
+};
+
+#define COMMAND_DATA_TYPE(cmd, T) \
+  template <>                     \
+  struct CommandDataType<cmd> {   \
+    typedef T type;               \
+  }
+
+COMMAND_DATA_TYPE(Command::RetDevice, Device);
+COMMAND_DATA_TYPE(Command::RetCommandList, CommandList);
+COMMAND_DATA_TYPE(Command::RetInfoList, InfoList);
+COMMAND_DATA_TYPE(Command::RetInfo, Info);
+COMMAND_DATA_TYPE(Command::RetResetList, ResetList);
+COMMAND_DATA_TYPE(Command::RetSaveRestoreList, SaveRestoreList);
+COMMAND_DATA_TYPE(Command::RetEthernetPortInfo, EthernetPortInfo);
+COMMAND_DATA_TYPE(Command::ACK, ACK);
+COMMAND_DATA_TYPE(Command::RetGizmoCount, GizmoCount);
+COMMAND_DATA_TYPE(Command::RetGizmoInfo, GizmoInfo);
+
+COMMAND_DATA_TYPE(Command::RetMIDIInfo, MIDIInfo);
+COMMAND_DATA_TYPE(Command::RetMIDIPortInfo, MIDIPortInfo);
+COMMAND_DATA_TYPE(Command::RetMIDIPortFilter, MIDIPortFilter);
+COMMAND_DATA_TYPE(Command::RetMIDIPortRemap, MIDIPortRemap);
+COMMAND_DATA_TYPE(Command::RetMIDIPortRoute, MIDIPortRoute);
+COMMAND_DATA_TYPE(Command::RetMIDIPortDetail, MIDIPortDetail);
+COMMAND_DATA_TYPE(Command::RetRTPMIDIConnectionDetail, RTPMIDIConnectionDetail);
+COMMAND_DATA_TYPE(Command::RetUSBHostMIDIDeviceDetail, USBHostMIDIDeviceDetail);
+
+COMMAND_DATA_TYPE(Command::RetAudioInfo, AudioInfo);
+COMMAND_DATA_TYPE(Command::RetAudioCfgInfo, AudioCfgInfo);
+COMMAND_DATA_TYPE(Command::RetAudioPortInfo, AudioPortInfo);
+COMMAND_DATA_TYPE(Command::RetAudioPortCfgInfo, AudioPortCfgInfo);
+COMMAND_DATA_TYPE(Command::RetAudioPortPatchbay, AudioPortPatchbay);
+COMMAND_DATA_TYPE(Command::RetAudioClockInfo, AudioClockInfo);
+
+COMMAND_DATA_TYPE(Command::RetAudioGlobalParm, AudioGlobalParm);
+COMMAND_DATA_TYPE(Command::RetAudioPortParm, AudioPortParm);
+COMMAND_DATA_TYPE(Command::RetAudioDeviceParm, AudioDeviceParm);
+COMMAND_DATA_TYPE(Command::RetAudioControlParm, AudioControlParm);
+COMMAND_DATA_TYPE(Command::RetAudioControlDetail, AudioControlDetail);
+COMMAND_DATA_TYPE(Command::RetAudioControlDetailValue, AudioControlDetailValue);
+COMMAND_DATA_TYPE(Command::RetAudioClockParm, AudioClockParm);
+COMMAND_DATA_TYPE(Command::RetAudioPatchbayParm, AudioPatchbayParm);
+COMMAND_DATA_TYPE(Command::RetAudioPortMeterValue, AudioPortMeterValue);
+COMMAND_DATA_TYPE(Command::RetMixerParm, MixerParm);
+COMMAND_DATA_TYPE(Command::RetMixerPortParm, MixerPortParm);
+COMMAND_DATA_TYPE(Command::RetMixerInputParm, MixerInputParm);
+COMMAND_DATA_TYPE(Command::RetMixerOutputParm, MixerOutputParm);
+COMMAND_DATA_TYPE(Command::RetMixerInputControl, MixerInputControl);
+COMMAND_DATA_TYPE(Command::RetMixerOutputControl, MixerOutputControl);
+COMMAND_DATA_TYPE(Command::RetMixerInputControlValue, MixerInputControlValue);
+COMMAND_DATA_TYPE(Command::RetMixerOutputControlValue, MixerOutputControlValue);
+COMMAND_DATA_TYPE(Command::RetMixerMeterValue, MixerMeterValue);
+
+#undef COMMAND_DATA_TYPE
+
+template <int CMD>
+commandData_t makeCommandData() {
+  return typename CommandDataType<CMD>::type();
+}
+
+template <int... Is>
+struct Indices {};
+
+template <int N, int... Is>
+struct BuildIndices : BuildIndices<N - 1, N - 1, Is...> {};
+
+template <int... Is>
+struct BuildIndices<0, Is...> {
+  typedef Indices<Is...> type;
+};
+
+template <typename>
+struct FactoryTable;
+
+template <int... Is>
+struct FactoryTable<Indices<Is...> > {
+  static constexpr CommandDataFactory table[] = {&makeCommandData<Is>...};
+};
+
+template <int... Is>
+constexpr CommandDataFactory FactoryTable<Indices<Is...> >::table[];
+
+typedef FactoryTable<BuildIndices<kCommandSlots>::type> Factories;
+
+bool isSlot(CmdEnum command) {
+  return ((command >= 0) && (command < kCommandSlots));
+}
+
+}  // namespace
+
 long SysexParser::nextID = 0;
 
 SysexParser::SysexParser(void)
     : m_handlers(), m_exclusiveHandlerCommand(), m_exclusiveHandler() {}
 
-SysexParser::~SysexParser(void) { m_handlers.clear(); }
+SysexParser::~SysexParser(void) { unRegisterAll(); }
 
 long SysexParser::registerHandler(CmdEnum command, Handler& handler) {
-  m_handlers[command][nextID] = handler;
+  lock_guard<recursive_mutex> lock(m_mutex);
+  if (isSlot(command)) {
+    m_handlers[command].push_back(make_pair(nextID, handler));
+  }
   return nextID++;
 }
 
 void SysexParser::unRegisterHandler(CmdEnum command) {
-  if (m_handlers.find(command) != m_handlers.end()) {
-    m_handlers.erase(command);
+  lock_guard<recursive_mutex> lock(m_mutex);
+  if (isSlot(command)) {
+    m_handlers[command].clear();
   }
 }
 
 void SysexParser::unRegisterHandler(CmdEnum command, long id) {
-  if (m_handlers.find(command) != m_handlers.end()) {
-    m_handlers.at(command).erase(id);
+  lock_guard<recursive_mutex> lock(m_mutex);
+  if (isSlot(command)) {
+    auto &handlers = m_handlers[command];
+    handlers.erase(remove_if(handlers.begin(), handlers.end(),
+                             [id](const pair<long, Handler> &handler) {
+                               return handler.first == id;
+                             }),
+                   handlers.end());
   }
 }
 
-void SysexParser::unRegisterAll() { m_handlers.clear(); }
+void SysexParser::unRegisterAll() {
+  lock_guard<recursive_mutex> lock(m_mutex);
+  for (auto &handlers : m_handlers) {
+    handlers.clear();
+  }
+}
 
 void SysexParser::registerExclusiveHandler(CmdEnum command, Handler& handler) {
+  lock_guard<recursive_mutex> lock(m_mutex);
   m_exclusiveHandlerCommand.reset(command);
   m_exclusiveHandler.reset(handler);
 }
 
 void SysexParser::unRegisterExclusiveHandler() {
+  lock_guard<recursive_mutex> lock(m_mutex);
   m_exclusiveHandlerCommand.reset();
   m_exclusiveHandler.reset();
 }
 
-bool SysexParser::parse(Bytes sysex) const {
-  bool error = false;
-  auto beginIter = sysex.begin();
-  auto endIter = sysex.end();
+bool SysexParser::parse(Bytes& sysex) const {
+  return parse(sysex.begin(), sysex.end());
+}
 
+bool SysexParser::parse(BytesIter beginIter, BytesIter endIter) const {
   static unsigned long IDLOG = 0;
 
-  Word productID;
-  SerialNumber sn;
   DeviceID deviceID;
   Word transID;
   CmdEnum cmdID;
-  Word dataLength;
+  commandData_t cmdData;
 
-  // check the size
-  error = (sysex.size() < 19);
+  bool error = !decode(beginIter, endIter, deviceID, transID, cmdID, cmdData);
 
-  // check header
   if (!error) {
-    Bytes header;
-    copy(beginIter, beginIter + 5, std::back_inserter(header));
-    advance(beginIter, 5);
+    dispatch(cmdID, deviceID, transID, cmdData);
+    IDLOG++;
+  }
 
-    Bytes expectedHeader;
-    expectedHeader += 0xF0, 0x00, 0x01, 0x73, 0x7E;
+  return error;
+}
 
-    error = (expectedHeader != header);
+void SysexParser::dispatch(CmdEnum cmdID, DeviceID deviceID, Word transID,
+                           const commandData_t &cmdData) const {
+  // held while the handlers run, so one removed on another thread is not
+  // called once its remove returned
+  lock_guard<recursive_mutex> lock(m_mutex);
+  if ((m_exclusiveHandlerCommand) && (*m_exclusiveHandlerCommand == cmdID) &&
+      (m_exclusiveHandler)) {
+    (*m_exclusiveHandler)(cmdID, deviceID, transID, cmdData);
+  } else if (isSlot(cmdID)) {
+    // index based so a handler may unregister others while dispatching
+    const auto& handlers = m_handlers[cmdID];
+    for (size_t i = 0; i < handlers.size(); ++i) {
+      handlers[i].second(cmdID, deviceID, transID, cmdData);
+    }
   }
+}
 
+bool SysexParser::decode(BytesIter beginIter, BytesIter endIter,
+                         DeviceID &deviceID, Word &transID, CmdEnum &cmdID,
+                         commandData_t &commandData) {
+  static const Byte expectedHeader[] = {0xF0, 0x00, 0x01, 0x73, 0x7E};
+
+  bool error = false;
+
+  Word productID;
+  SerialNumber sn;
+  Word dataLength;
+
+  // check the size
+  error = (std::distance(beginIter, endIter) < 19);
+
+  // check header
+  if (!error) {
+    error = !std::equal(expectedHeader, expectedHeader + 5, beginIter);
+    beginIter += 5;
+  }
 
   // check the checksum
   if (!error) {
@@ -147,7 +299,7 @@ bool SysexParser::parse(Bytes sysex) const {
 
   // check footer
   if (!error) {
-    error = (sysex.back() != 0xF7);
+    error = (*(endIter - 1) != 0xF7);
   }
 
   if (!error) {
@@ -159,7 +311,7 @@ bool SysexParser::parse(Bytes sysex) const {
 #else
     copy(beginIter, beginIter + 5, sn.begin());
 #endif
-    advance(beginIter, 5);
+    beginIter += 5;
     deviceID = DeviceID(productID, sn);
 
     transID = nextMidiWord(beginIter, endIter);
@@ -175,89 +327,21 @@ bool SysexParser::parse(Bytes sysex) const {
     }
 
     if (!error) {
-      auto cmdData = createCommandDataObject(cmdID);
+      commandData = createCommandDataObject(cmdID);
 
       auto endWithoutFooter = endIter - 2;
-      cmdData.parse(beginIter, endWithoutFooter);
-
-      if ((m_exclusiveHandlerCommand) &&
-          (*m_exclusiveHandlerCommand == cmdID) && (m_exclusiveHandler)) {
-
-        (*m_exclusiveHandler)(cmdID, deviceID, transID, cmdData);
-      } else {
-        for (const auto& handler : m_handlers.at(cmdID) | map_values) {
-          handler(cmdID, deviceID, transID, cmdData);
-        }
-      }
-      IDLOG++;
+      commandData.parse(beginIter, endWithoutFooter);
     }
   }
 
-  return error;
+  return !error;
 }
 
-commandData_t SysexParser::createCommandDataObject(CmdEnum command) const {
-  commandData_t result = BytesCommandData<Command::Unknown>();
-
-  static bool tableCreated = false;
-  static map<CmdEnum, commandData_t> table;
-
-  if (!tableCreated) {
-    tableCreated = true;
-    table[Command::RetDevice] = Device();
-    table[Command::RetCommandList] = CommandList();
-    table[Command::RetInfoList] = InfoList();
-    table[Command::RetInfo] = Info();
-    table[Command::RetResetList] = ResetList();
-    table[Command::RetSaveRestoreList] = SaveRestoreList();
-    table[Command::RetEthernetPortInfo] = EthernetPortInfo();
-    table[Command::ACK] = ACK();
-    table[Command::RetGizmoCount] = GizmoCount();
-    table[Command::RetGizmoInfo] = GizmoInfo();
-
-    table[Command::RetMIDIInfo] = MIDIInfo();
-    table[Command::RetMIDIPortInfo] = MIDIPortInfo();
-    table[Command::RetMIDIPortFilter] = MIDIPortFilter();
-    table[Command::RetMIDIPortRemap] = MIDIPortRemap();
-    table[Command::RetMIDIPortRoute] = MIDIPortRoute();
-    table[Command::RetMIDIPortDetail] = MIDIPortDetail();
-    table[Command::RetRTPMIDIConnectionDetail] = RTPMIDIConnectionDetail();
-    table[Command::RetUSBHostMIDIDeviceDetail] = USBHostMIDIDeviceDetail();
-
-    table[Command::RetAudioInfo] = AudioInfo();
-    table[Command::RetAudioCfgInfo] = AudioCfgInfo();
-    table[Command::RetAudioPortInfo] = AudioPortInfo();
-    table[Command::RetAudioPortCfgInfo] = AudioPortCfgInfo();
-    table[Command::RetAudioPortPatchbay] = AudioPortPatchbay();
-    table[Command::RetAudioClockInfo] = AudioClockInfo();
-
-    table[Command::RetAudioGlobalParm] = AudioGlobalParm();
-    table[Command::RetAudioPortParm] = AudioPortParm();
-    table[Command::RetAudioDeviceParm] = AudioDeviceParm();
-    table[Command::RetAudioControlParm] = AudioControlParm();
-    table[Command::RetAudioControlDetail] = AudioControlDetail();
-    table[Command::RetAudioControlDetailValue] = AudioControlDetailValue();
-    table[Command::RetAudioClockParm] = AudioClockParm();
-    table[Command::RetAudioPatchbayParm] = AudioPatchbayParm();
-    table[Command::RetAudioPortMeterValue] = AudioPortMeterValue();
-    table[Command::RetMixerParm] = MixerParm();
-    table[Command::RetMixerPortParm] = MixerPortParm();
-    table[Command::RetMixerInputParm] = MixerInputParm();
-    table[Command::RetMixerOutputParm] = MixerOutputParm();
-    table[Command::RetMixerInputControl] = MixerInputControl();
-    table[Command::RetMixerOutputControl] = MixerOutputControl();
-    table[Command::RetMixerInputControlValue] = MixerInputControlValue();
-    table[Command::RetMixerOutputControlValue] = MixerOutputControlValue();
-    table[Command::RetMixerMeterValue] = MixerMeterValue();
+commandData_t SysexParser::createCommandDataObject(CmdEnum command) {
+  if (isSlot(command)) {
+    return Factories::table[command]();
   }
-
-  if (tableCreated) {
-    if (contains(table, command)) {
-      result = table.at(command);
-    }
-  }
-
-  return result;
+  return BytesCommandData<Command::Unknown>();
 }
 
 }  // namespace GeneSysLib
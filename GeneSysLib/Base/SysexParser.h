@@ -13,7 +13,9 @@
 #ifndef Q_MOC_RUN
 #include <boost/optional.hpp>
 #endif
-#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace GeneSysLib {
 
@@ -29,15 +31,32 @@ struct SysexParser {
   void registerExclusiveHandler(CmdEnum command, Handler &handler);
   void unRegisterExclusiveHandler();
 
-  bool parse(Bytes sysex) const;
+  bool parse(Bytes &sysex) const;
+  bool parse(BytesIter beginIter, BytesIter endIter) const;
+
+  // decodes an answer without dispatching it, false if it is malformed
+  static bool decode(BytesIter beginIter, BytesIter endIter,
+                     DeviceID &deviceID, Word &transID, CmdEnum &command,
+                     commandData_t &commandData);
+
+  // runs the handlers of an answer decoded before
+  void dispatch(CmdEnum command, DeviceID deviceID, Word transID,
+                const commandData_t &commandData) const;
 
  private:
-  std::map<CmdEnum, std::map<long, Handler> > m_handlers;
+  typedef std::vector<std::pair<long, Handler> > HandlerList;
+
+  // Handlers are added and removed on the UI thread while the I/O thread
+  // dispatches, the lock covers both. It is recursive so a handler may
+  // register or remove handlers while it runs.
+  mutable std::recursive_mutex m_mutex;
+
+  HandlerList m_handlers[kCommandSlots];
 
   boost::optional<CmdEnum> m_exclusiveHandlerCommand;
   boost::optional<Handler> m_exclusiveHandler;
 
-  commandData_t createCommandDataObject(CmdEnum command) const;
+  static commandData_t createCommandDataObject(CmdEnum command);
 
   static long nextID;
 };  // struct SysexParser
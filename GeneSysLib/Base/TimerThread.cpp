@@ -9,7 +9,8 @@
 
 #ifndef __IOS__
 
-TimerThread::TimerThread(QObject *parent) : QThread(parent) {
+TimerThread::TimerThread(QObject *parent)
+    : QThread(parent), timer(0), pollTimer(0), pollHandler() {
   connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
 }
 
@@ -24,6 +25,8 @@ void TimerThread::startTimer() { emit timerStarted(); }
 
 void TimerThread::stopTimer() { emit timerStopped(); }
 
+void TimerThread::setPollHandler(PollHandler handler) { pollHandler = handler; }
+
 void TimerThread::run() {
   /* initialize */
   timer = new QTimer();
@@ -34,11 +37,22 @@ void TimerThread::run() {
   timer->setSingleShot(true);
   timer->setInterval(5000);
 
+  pollTimer = new QTimer();
+  connect(pollTimer, SIGNAL(timeout()), this, SLOT(poll()));
+  pollTimer->start(kPollInterval);
+
   exec();
 
+  pollTimer->deleteLater();
   timer->deleteLater();
 }
 
 void TimerThread::timeout() { emit timedOut(); }
 
+void TimerThread::poll() {
+  if ((pollHandler) && (pollHandler())) {
+    emit timedOut();
+  }
+}
+
 #endif  // __IOS__
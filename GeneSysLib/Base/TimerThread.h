@@ -13,12 +13,23 @@
 #include <QThread>
 #include <QTimer>
 
+#ifndef Q_MOC_RUN
+#include <boost/function.hpp>
+#endif
+
+#define kPollInterval 50
+
 class TimerThread : public QThread {
   Q_OBJECT
  public:
+  // returns true when the polled state has timed out
+  typedef boost::function<bool(void)> PollHandler;
+
   explicit TimerThread(QObject *parent = 0);
   ~TimerThread();
 
+  void setPollHandler(PollHandler handler);
+
 signals:
   void timerStarted();
   void timerStopped();
@@ -34,9 +45,12 @@ signals:
 
  private slots:
   void timeout();
+  void poll();
 
  private:
   QTimer *timer;
+  QTimer *pollTimer;
+  PollHandler pollHandler;
 };
 
 #endif  // __IOS__
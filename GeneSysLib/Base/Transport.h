@@ -0,0 +1,49 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __TRANSPORT_H__
+#define __TRANSPORT_H__
+
+#ifndef __IOS__
+
+#include "LibTypes.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#endif
+#include <string>
+#include <vector>
+
+namespace GeneSysLib {
+
+// The MIDI ports a Communicator talks through when they are not the RtMidi
+// ports of the system, such as an in-process VirtualDevice. Port indices are
+// the positions in inPorts() and outPorts().
+struct Transport {
+  // called with the bytes that arrived on an input, on any thread
+  typedef boost::function<void(unsigned int inPort, Bytes &data)> Receiver;
+
+  virtual ~Transport() {}
+
+  virtual std::vector<std::string> inPorts() = 0;
+  virtual std::vector<std::string> outPorts() = 0;
+
+  virtual bool openInputs(Receiver receiver) = 0;
+  // the receiver is not called any more once this returns
+  virtual void closeInputs() = 0;
+
+  virtual bool send(unsigned int outPort, const Bytes &sysex) = 0;
+};  // struct Transport
+
+typedef boost::shared_ptr<Transport> TransportPtr;
+
+}  // namespace GeneSysLib
+
+#endif  // __IOS__
+
+#endif  // __TRANSPORT_H__
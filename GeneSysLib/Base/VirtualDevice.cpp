@@ -0,0 +1,346 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "VirtualDevice.h"
+
+#ifndef __IOS__
+
+#include "CommandData.h"
+#include "ErrorCode.h"
+#include "StreamHelpers.h"
+#include "SysexParser.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/assign/std/vector.hpp>
+#endif
+#include <algorithm>
+#include <numeric>
+
+using namespace std;
+using namespace boost::assign;
+
+namespace GeneSysLib {
+
+namespace {
+
+Word sysexWord(const Bytes &sysex, size_t offset) {
+  return ((sysex[offset] << 7) & 0x3F80) | (sysex[offset + 1] & 0x7F);
+}
+
+void setSysexWord(Bytes &sysex, size_t offset, Word word) {
+  sysex[offset] = (word >> 7) & 0x7F;
+  sysex[offset + 1] = word & 0x7F;
+}
+
+void setChecksum(Bytes &sysex) {
+  sysex[sysex.size() - 2] =
+      (~(accumulate(sysex.begin() + 5, sysex.end() - 2, 0x00)) + 1) & 0x7F;
+}
+
+// the payload of a message, empty if the length does not fit
+pair<size_t, size_t> payload(const Bytes &sysex) {
+  const size_t begin = 18;
+  const size_t end = begin + sysexWord(sysex, 16);
+  if (end > sysex.size() - 2) {
+    return make_pair(begin, begin);
+  }
+  return make_pair(begin, end);
+}
+
+}  // namespace
+
+void VirtualDevice::DeliveryThread::run() { m_device->deliver(); }
+
+VirtualDevice::VirtualDevice()
+    : m_thread(this),
+      m_running(true),
+      m_receiveMutex(QMutex::Recursive),
+      m_receiver(),
+      m_identity(),
+      m_answers(),
+      m_families(),
+      m_deliveries(),
+      m_lineFree(0),
+      m_latency(0),
+      m_bandwidth(kMIDIBandwidth),
+      m_dropRate(0.0),
+      m_random() {
+  m_clock.start();
+  m_thread.start();
+}
+
+VirtualDevice::~VirtualDevice() {
+  m_mutex.lock();
+  m_running = false;
+  m_wake.wakeAll();
+  m_mutex.unlock();
+  m_thread.wait();
+}
+
+bool VirtualDevice::load(const Bytes &data) {
+  auto beginIter = data.begin();
+  auto endIter = data.end();
+
+  // a preset or cache file: magic, PID and version, then the answers and an
+  // MD5. Version 2 presets have a description after the header.
+  if ((data.size() > 21) && (data[0] == 0x69) && (data[1] == 0x43) &&
+      ((data[2] == 0x4D) || (data[2] == 0x43))) {
+    const Byte version = data[4];
+    beginIter += 5;
+    if ((data[2] == 0x4D) && (version == 0x02)) {
+      beginIter += min<size_t>(1 + *beginIter, distance(beginIter, endIter));
+    }
+    endIter -= 16;
+  }
+
+  QMutexLocker locker(&m_mutex);
+  m_answers.clear();
+  m_families.clear();
+  m_identity.clear();
+
+  while (beginIter < endIter) {
+    const auto frameBegin = std::find(beginIter, endIter, (Byte)0xF0);
+    const auto frameEnd = std::find(frameBegin, endIter, (Byte)0xF7);
+    if (frameEnd == endIter) {
+      break;
+    }
+    store(Bytes(frameBegin, frameEnd + 1));
+    beginIter = frameEnd + 1;
+  }
+
+  return !m_answers.empty();
+}
+
+bool VirtualDevice::addAnswer(const Bytes &sysex) {
+  QMutexLocker locker(&m_mutex);
+  return store(sysex);
+}
+
+size_t VirtualDevice::answerCount() {
+  QMutexLocker locker(&m_mutex);
+  return m_answers.size();
+}
+
+void VirtualDevice::setLatency(int msec) {
+  QMutexLocker locker(&m_mutex);
+  m_latency = max(msec, 0);
+}
+
+void VirtualDevice::setBandwidth(int bytesPerSecond) {
+  QMutexLocker locker(&m_mutex);
+  m_bandwidth = max(bytesPerSecond, 0);
+}
+
+void VirtualDevice::setDropRate(double rate) {
+  QMutexLocker locker(&m_mutex);
+  m_dropRate = min(max(rate, 0.0), 1.0);
+}
+
+void VirtualDevice::setSeed(unsigned int seed) {
+  QMutexLocker locker(&m_mutex);
+  m_random.seed(seed);
+}
+
+vector<string> VirtualDevice::inPorts() {
+  return vector<string>(1, kVirtualDevicePort);
+}
+
+vector<string> VirtualDevice::outPorts() {
+  return vector<string>(1, kVirtualDevicePort);
+}
+
+bool VirtualDevice::openInputs(Receiver receiver) {
+  QMutexLocker locker(&m_receiveMutex);
+  m_receiver = receiver;
+  return true;
+}
+
+void VirtualDevice::closeInputs() {
+  // waits for an answer being delivered to the receiver
+  m_receiveMutex.lock();
+  m_receiver = Receiver();
+  m_receiveMutex.unlock();
+
+  QMutexLocker locker(&m_mutex);
+  m_deliveries.clear();
+}
+
+bool VirtualDevice::send(unsigned int outPort, const Bytes &sysex) {
+  if ((outPort != 0) || (sysex.size() < 19) || (sysex.front() != 0xF0)) {
+    return false;
+  }
+
+  QMutexLocker locker(&m_mutex);
+  answer(sysex, sysexWord(sysex, 12), (CmdEnum)sysexWord(sysex, 14));
+  return true;
+}
+
+void VirtualDevice::answer(const Bytes &request, Word transID,
+                           CmdEnum command) {
+  const auto response = responseCommand(command);
+
+  if (response != Command::ACK) {
+    const auto range = payload(request);
+    Bytes query(request.begin() + range.first, request.begin() + range.second);
+    const Bytes *found = find(response, query.begin(), query.end());
+    if (found) {
+      schedule(restamp(*found, transID));
+    } else {
+      schedule(ack(transID, command, ErrorCode::UnknownCommand));
+    }
+    return;
+  }
+
+  // a write of a setting is kept as the answer to later queries for it
+  const auto family = (CmdEnum)(command & ~WRITE_BIT);
+  if (m_families.count(family) > 0) {
+    Bytes written = request;
+    setSysexWord(written, 14, family);
+    setChecksum(written);
+    store(written);
+  }
+  schedule(ack(transID, command, ErrorCode::NoError));
+}
+
+bool VirtualDevice::store(Bytes sysex) {
+  DeviceID deviceID;
+  Word transID;
+  CmdEnum command;
+  commandData_t commandData;
+  if ((!SysexParser::decode(sysex.begin(), sysex.end(), deviceID, transID,
+                            command, commandData)) ||
+      (command & QUERY_BIT)) {
+    return false;
+  }
+
+  if (m_identity.empty()) {
+    m_identity.assign(sysex.begin() + 5, sysex.begin() + 12);
+
+    // presets are saved without a serial number
+    if (std::all_of(m_identity.begin() + 2, m_identity.end(),
+                    [](Byte b) { return b == 0; })) {
+      m_identity.back() = 0x01;
+    }
+  }
+
+  const auto key = commandData.key();
+  auto found = m_answers.find(key);
+  if (found == m_answers.end()) {
+    m_families[command].push_back(key);
+    m_answers[key].swap(sysex);
+  } else {
+    found->second.swap(sysex);
+  }
+  return true;
+}
+
+// The parameters of a query lead the payload of its answer, after the
+// version byte of the answers that have one.
+const Bytes *VirtualDevice::find(CmdEnum family, BytesIter beginIter,
+                                 BytesIter endIter) {
+  const auto keys = m_families.find(family);
+  if (keys == m_families.end()) {
+    return 0;
+  }
+
+  const size_t length = distance(beginIter, endIter);
+  for (size_t offset = 0; offset < 2; ++offset) {
+    for (const auto &key : keys->second) {
+      const auto &sysex = m_answers[key];
+      const auto range = payload(sysex);
+      if ((range.second - range.first >= offset + length) &&
+          (equal(beginIter, endIter, sysex.begin() + range.first + offset))) {
+        return &sysex;
+      }
+    }
+  }
+  return 0;
+}
+
+Bytes VirtualDevice::restamp(const Bytes &sysex, Word transID) const {
+  Bytes result = sysex;
+  copy(m_identity.begin(), m_identity.end(), result.begin() + 5);
+  setSysexWord(result, 12, transID);
+  setChecksum(result);
+  return result;
+}
+
+Bytes VirtualDevice::ack(Word transID, CmdEnum command, Byte errorCode) const {
+  Bytes result;
+  result += 0xF0, 0x00, 0x01, 0x73, 0x7E;
+  if (m_identity.empty()) {
+    result.resize(result.size() + 7, 0x00);
+  } else {
+    result.insert(result.end(), m_identity.begin(), m_identity.end());
+  }
+  appendMidiWord(result, transID);
+  appendMidiWord(result, Command::ACK);
+  appendMidiWord(result, 3);
+  appendMidiWord(result, command);
+  result += errorCode & 0x7F;
+  result += 0x00, 0xF7;
+  setChecksum(result);
+  return result;
+}
+
+void VirtualDevice::schedule(const Bytes &sysex) {
+  const double draw = (double)(m_random() - m_random.min()) /
+                      (double)(m_random.max() - m_random.min());
+  if (draw < m_dropRate) {
+    return;
+  }
+
+  // answers leave one after the other, each once its bytes are on the line
+  const qint64 now = m_clock.nsecsElapsed() / 1000;
+  qint64 due = max(now + m_latency * 1000, m_lineFree);
+  if (m_bandwidth > 0) {
+    due += (qint64)sysex.size() * 1000000 / m_bandwidth;
+  }
+  m_lineFree = due;
+
+  Delivery delivery;
+  delivery.due = due;
+  delivery.sysex = sysex;
+  m_deliveries.push_back(delivery);
+  m_wake.wakeAll();
+}
+
+void VirtualDevice::deliver() {
+  m_mutex.lock();
+  while (m_running) {
+    if (m_deliveries.empty()) {
+      m_wake.wait(&m_mutex);
+      continue;
+    }
+
+    const qint64 wait =
+        m_deliveries.front().due - m_clock.nsecsElapsed() / 1000;
+    if (wait > 0) {
+      m_wake.wait(&m_mutex, (unsigned long)((wait + 999) / 1000));
+      continue;
+    }
+
+    Bytes sysex;
+    sysex.swap(m_deliveries.front().sysex);
+    m_deliveries.pop_front();
+    m_mutex.unlock();
+
+    // the receiver sends the next requests from here, which takes m_mutex
+    m_receiveMutex.lock();
+    if (m_receiver) {
+      m_receiver(0, sysex);
+    }
+    m_receiveMutex.unlock();
+
+    m_mutex.lock();
+  }
+  m_mutex.unlock();
+}
+
+}  // namespace GeneSysLib
+
+#endif  // __IOS__
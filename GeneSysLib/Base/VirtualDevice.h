@@ -0,0 +1,116 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __VIRTUALDEVICE_H__
+#define __VIRTUALDEVICE_H__
+
+#ifndef __IOS__
+
+#include "LibTypes.h"
+#include "CommandDataKey.h"
+#include "CommandDefines.h"
+#include "Transport.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <deque>
+#include <map>
+#include <random>
+
+#define kVirtualDevicePort "iConfig Virtual Device"
+#define kMIDIBandwidth 3125  // bytes per second of a DIN MIDI cable
+
+namespace GeneSysLib {
+
+// An in-process device for running without hardware. It answers Get queries
+// from the Ret answers it holds and ACKs Set writes, keeping the written
+// value so later queries see it. The answers come from a preset (.icm), a
+// device state cache (.icc) or plain sysex.
+//
+// Answers are delivered on a thread of their own after the configured
+// latency plus the time the bytes take on a line of the given bandwidth, and
+// are dropped at the given rate. Drops follow a seeded generator so a run can
+// be repeated exactly.
+struct VirtualDevice : public Transport {
+  VirtualDevice();
+  ~VirtualDevice();
+
+  // replaces the answers, false if nothing usable was found
+  bool load(const Bytes &data);
+
+  // adds or replaces the answer of one setting
+  bool addAnswer(const Bytes &sysex);
+  size_t answerCount();
+
+  void setLatency(int msec);
+  void setBandwidth(int bytesPerSecond);  // 0 for unlimited
+  void setDropRate(double rate);
+  void setSeed(unsigned int seed);
+
+  // Transport
+  std::vector<std::string> inPorts();
+  std::vector<std::string> outPorts();
+  bool openInputs(Receiver receiver);
+  void closeInputs();
+  bool send(unsigned int outPort, const Bytes &sysex);
+
+ private:
+  struct Delivery {
+    qint64 due;  // usec on m_clock
+    Bytes sysex;
+  };
+
+  struct DeliveryThread : public QThread {
+    explicit DeliveryThread(VirtualDevice *device) : m_device(device) {}
+
+   protected:
+    void run();
+
+   private:
+    VirtualDevice *m_device;
+  };
+
+  void answer(const Bytes &request, Word transID, CmdEnum command);
+  bool store(Bytes sysex);
+  const Bytes *find(CmdEnum family, BytesIter beginIter, BytesIter endIter);
+  Bytes restamp(const Bytes &sysex, Word transID) const;
+  Bytes ack(Word transID, CmdEnum command, Byte errorCode) const;
+  void schedule(const Bytes &sysex);
+  void deliver();
+
+  QMutex m_mutex;
+  QWaitCondition m_wake;
+  QElapsedTimer m_clock;
+  DeliveryThread m_thread;
+  bool m_running;
+
+  QMutex m_receiveMutex;  // held while an answer is delivered
+  Receiver m_receiver;
+  Bytes m_identity;  // pid and serial number as sent in answers
+
+  std::map<commandDataKey_t, Bytes> m_answers;
+  std::map<CmdEnum, std::vector<commandDataKey_t> > m_families;
+
+  std::deque<Delivery> m_deliveries;
+  qint64 m_lineFree;  // usec when the line has sent everything queued
+
+  int m_latency;
+  int m_bandwidth;
+  double m_dropRate;
+  std::minstd_rand m_random;
+};  // struct VirtualDevice
+
+typedef boost::shared_ptr<VirtualDevice> VirtualDevicePtr;
+
+}  // namespace GeneSysLib
+
+#endif  // __IOS__
+
+#endif  // __VIRTUALDEVICE_H__
@@ -0,0 +1,242 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __WIRESCHEMA_H__
+#define __WIRESCHEMA_H__
+
+#include "LibTypes.h"
+#include "property.h"
+
+#include <cstddef>
+#include <vector>
+
+// Declares a field of a schema: the codec the field is sent with, the struct
+// it belongs to and its member, e.g. WIRE_FIELD(MidiWord, MIDIInfo, numMIDIPorts)
+#define WIRE_FIELD(codec, owner, member)                              \
+  ::GeneSysLib::Wire::Field< ::GeneSysLib::Wire::codec, owner,        \
+                            decltype(owner::member), &owner::member>
+
+namespace GeneSysLib {
+
+// A command's fixed fields are listed once as a Schema, the parser and
+// generator are expanded from that list at compile time. The whole message
+// is checked for length up front, so the fields themselves are read and
+// written without any bounds checks, and generating knows the output size
+// before writing a byte.
+//
+//   struct AudioInfo::Layout
+//       : Wire::Schema<Wire::Version<0x01>,
+//                      WIRE_FIELD(MidiWord, AudioInfo, numberOfAudioPorts),
+//                      WIRE_FIELD(Byte, AudioInfo, numberOfUSBDeviceJacks)> {};
+//
+//   void AudioInfo::parse(BytesIter &begin, BytesIter &end) {
+//     Layout::parse(*this, begin, end);
+//   }
+namespace Wire {
+
+// codecs, each knows its size on the wire and how to read and write a value
+
+// a byte as is
+struct Byte {
+  enum { size = 1 };
+  typedef ::Byte value_type;
+
+  static value_type read(const ::Byte *data) { return data[0]; }
+  static void write(::Byte *data, value_type value) { data[0] = value; }
+};  // struct Byte
+
+// a byte with the high bit cleared
+struct MidiByte {
+  enum { size = 1 };
+  typedef ::Byte value_type;
+
+  static value_type read(const ::Byte *data) { return data[0]; }
+  static void write(::Byte *data, value_type value) { data[0] = value & 0x7F; }
+};  // struct MidiByte
+
+// 14 bits in two bytes, most significant first
+struct MidiWord {
+  enum { size = 2 };
+  typedef Word value_type;
+
+  static value_type read(const ::Byte *data) {
+    return ((data[0] << 7) & 0x3F80) | (data[1] & 0x7F);
+  }
+  static void write(::Byte *data, value_type value) {
+    data[0] = (value >> 7) & 0x7F;
+    data[1] = value & 0x7F;
+  }
+};  // struct MidiWord
+
+// 16 bits in three bytes, most significant first
+struct MidiWord3 {
+  enum { size = 3 };
+  typedef Word value_type;
+
+  static value_type read(const ::Byte *data) {
+    return static_cast<Word>((data[0] << 14) | ((data[1] & 0x7F) << 7) |
+                             (data[2] & 0x7F));
+  }
+  static void write(::Byte *data, value_type value) {
+    data[0] = (value >> 14) & 0x7F;
+    data[1] = (value >> 7) & 0x7F;
+    data[2] = value & 0x7F;
+  }
+};  // struct MidiWord3
+
+// how a codec value gets in and out of a member, which is either a plain
+// value or one of the properties in property.h
+template <typename T>
+struct Member {
+  typedef T type;
+  static const T &get(const T &member) { return member; }
+  static void set(T &member, const T &value) { member = value; }
+};  // struct Member
+
+template <typename T>
+struct Member<readonly_property<T> > {
+  typedef T type;
+  static const T &get(const readonly_property<T> &member) { return member(); }
+  static void set(readonly_property<T> &member, const T &value) {
+    member = readonly_property<T>(value);
+  }
+};  // struct Member
+
+template <typename T>
+struct Member<readwrite_property<T> > {
+  typedef T type;
+  static const T &get(const readwrite_property<T> &member) { return member(); }
+  static void set(readwrite_property<T> &member, const T &value) {
+    member = readwrite_property<T>(value);
+  }
+};  // struct Member
+
+// a member of Owner sent with Codec, see WIRE_FIELD
+template <typename Codec, typename Owner, typename M, M Owner::*member>
+struct Field {
+  enum { size = Codec::size };
+
+  static bool accepts(const ::Byte *) { return true; }
+
+  static void read(Owner &owner, const ::Byte *data) {
+    typedef typename Member<M>::type type;
+    Member<M>::set(owner.*member, static_cast<type>(Codec::read(data)));
+  }
+
+  static void write(const Owner &owner, ::Byte *data) {
+    typedef typename Codec::value_type value_type;
+    Codec::write(data, static_cast<value_type>(Member<M>::get(owner.*member)));
+  }
+};  // struct Field
+
+// the version byte most commands lead with, a message of any other version
+// is left alone
+template <::Byte version>
+struct Version {
+  enum { size = 1 };
+
+  static bool accepts(const ::Byte *data) { return data[0] == version; }
+
+  template <typename Owner>
+  static void read(Owner &, const ::Byte *) {}
+
+  template <typename Owner>
+  static void write(const Owner &, ::Byte *data) {
+    data[0] = version;
+  }
+};  // struct Version
+
+template <typename... Fields>
+struct Schema;
+
+template <>
+struct Schema<> {
+  enum { size = 0 };
+
+  static bool accepts(const ::Byte *) { return true; }
+
+  template <typename Owner>
+  static void read(Owner &, const ::Byte *) {}
+
+  template <typename Owner>
+  static void write(const Owner &, ::Byte *) {}
+};  // struct Schema
+
+template <typename First, typename... Rest>
+struct Schema<First, Rest...> {
+  enum { size = First::size + Schema<Rest...>::size };
+
+  static bool accepts(const ::Byte *data) {
+    return First::accepts(data) && Schema<Rest...>::accepts(data + First::size);
+  }
+
+  template <typename Owner>
+  static void read(Owner &owner, const ::Byte *data) {
+    First::read(owner, data);
+    Schema<Rest...>::read(owner, data + First::size);
+  }
+
+  template <typename Owner>
+  static void write(const Owner &owner, ::Byte *data) {
+    First::write(owner, data);
+    Schema<Rest...>::write(owner, data + First::size);
+  }
+
+  // fills owner and moves begin past the fields, false and nothing touched
+  // when the message is too short or of another version
+  template <typename Owner>
+  static bool parse(Owner &owner, BytesIter &begin, const BytesIter &end) {
+    if ((end - begin < size) || !accepts(&*begin)) {
+      return false;
+    }
+    read(owner, &*begin);
+    begin += size;
+    return true;
+  }
+
+  // appends the fields of owner, room for reserve more bytes is made as well
+  template <typename Owner>
+  static void generate(const Owner &owner, Bytes &result,
+                       size_t reserve = 0) {
+    const size_t offset = result.size();
+    result.reserve(offset + size + reserve);
+    result.resize(offset + size);
+    write(owner, &result[offset]);
+  }
+};  // struct Schema
+
+// count blocks of the same layout, all present or none are taken
+template <typename Layout, typename Block>
+bool parseBlocks(std::vector<Block> &blocks, size_t count, BytesIter &begin,
+                 const BytesIter &end) {
+  blocks.clear();
+  if (static_cast<size_t>(end - begin) < count * Layout::size) {
+    return false;
+  }
+
+  blocks.resize(count);
+  for (auto &block : blocks) {
+    Layout::read(block, &*begin);
+    begin += Layout::size;
+  }
+  return true;
+}
+
+template <typename Layout, typename Block>
+void generateBlocks(const std::vector<Block> &blocks, Bytes &result) {
+  const size_t offset = result.size();
+  result.resize(offset + blocks.size() * Layout::size);
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    Layout::write(blocks[i], &result[offset + i * Layout::size]);
+  }
+}
+
+}  // namespace Wire
+
+}  // namespace GeneSysLib
+
+#endif  // __WIRESCHEMA_H__
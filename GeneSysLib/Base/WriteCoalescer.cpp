@@ -0,0 +1,339 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "WriteCoalescer.h"
+
+#ifndef __IOS__
+
+#include "ACK.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/bind.hpp>
+#endif
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+namespace GeneSysLib {
+
+namespace {
+
+// the command word of a sysex message, 0 if it is too short to have one
+CmdEnum sysexCommand(const Bytes &sysex) {
+  if (sysex.size() < 16) {
+    return (CmdEnum)0;
+  }
+  return (CmdEnum)(((sysex[14] << 7) & 0x3F80) | (sysex[15] & 0x7F));
+}
+
+// puts another transaction ID into a sysex message, the checksum covers it
+Bytes withTransID(const Bytes &sysex, Word transID) {
+  Bytes result = sysex;
+  if (result.size() < 18) {
+    return result;
+  }
+  const Byte high = (transID >> 7) & 0x7F;
+  const Byte low = transID & 0x7F;
+  Byte &checksum = result[result.size() - 2];
+  checksum = (checksum + result[12] + result[13] - high - low) & 0x7F;
+  result[12] = high;
+  result[13] = low;
+  return result;
+}
+
+}  // namespace
+
+WriteCoalescer::WriteCoalescer(CommPtr comm)
+    : m_comm(comm),
+      m_ackHandlerID(-1),
+      m_entries(),
+      m_inFlight(),
+      m_nextTransID(0),
+      m_transactions(),
+      m_nextTransaction(1),
+      m_interval(kCoalesceInterval),
+      m_timeout(kCoalesceTimeout) {
+  m_clock.start();
+  if (m_comm) {
+    m_ackHandlerID = m_comm->registerHandler(
+        Command::ACK,
+        boost::bind(&WriteCoalescer::handleACK, this, _1, _2, _3, _4));
+  }
+}
+
+WriteCoalescer::~WriteCoalescer() {
+  if ((m_comm) && (m_ackHandlerID >= 0)) {
+    m_comm->unRegisterHandler(Command::ACK, m_ackHandlerID);
+  }
+}
+
+void WriteCoalescer::setInterval(int msec) { m_interval = max(msec, 0); }
+
+int WriteCoalescer::interval() const { return m_interval; }
+
+void WriteCoalescer::setTimeout(int msec) { m_timeout = max(msec, 0); }
+
+void WriteCoalescer::write(commandDataKey_t key, const Bytes &sysex) {
+  QMutexLocker locker(&m_mutex);
+  const qint64 now = m_clock.elapsed();
+
+  auto &entry = m_entries[key];
+  entry.sysex = sysex;
+  entry.queued = true;
+  entry.transaction = 0;
+
+  if (due(entry, now)) {
+    send(key, entry, now);
+  }
+}
+
+void WriteCoalescer::writeTogether(const Changes &changes, Completion done) {
+  if (changes.empty()) {
+    if (done) {
+      done(true);
+    }
+    return;
+  }
+
+  QMutexLocker locker(&m_mutex);
+  const qint64 now = m_clock.elapsed();
+  const long id = m_nextTransaction++;
+
+  auto &transaction = m_transactions[id];
+  transaction.changes = changes;
+  transaction.done = done;
+  transaction.unanswered = changes.size();
+  transaction.refused = false;
+  transaction.sent = now;
+
+  for (const auto &change : changes) {
+    auto &entry = m_entries[change.key];
+    entry.sysex = change.sysex;
+    send(change.key, entry, now, id);
+  }
+}
+
+bool WriteCoalescer::poll() {
+  QMutexLocker locker(&m_mutex);
+  const qint64 now = m_clock.elapsed();
+
+  Finished finished;
+  for (auto transaction = m_transactions.begin();
+       transaction != m_transactions.end();) {
+    auto current = transaction++;
+    if (now - current->second.sent >= m_timeout) {
+      finish(current, now, finished);
+    }
+  }
+
+  // given up on, a late answer releases nothing and the communicator must not
+  // send it again over a newer value
+  for (auto sent = m_inFlight.begin(); sent != m_inFlight.end();) {
+    if ((sent->second.transaction == 0) &&
+        (now - sent->second.sent >= m_timeout)) {
+      auto &entry = m_entries[sent->second.key];
+      if (entry.transID == sent->first) {
+        entry.inFlight = false;
+      }
+      if (m_comm) {
+        m_comm->cancelRequest(sent->first);
+      }
+      sent = m_inFlight.erase(sent);
+    } else {
+      ++sent;
+    }
+  }
+
+  bool remaining = (!m_transactions.empty()) || (!m_inFlight.empty());
+  for (auto &item : m_entries) {
+    auto &entry = item.second;
+    if (entry.queued) {
+      if ((!due(entry, now)) ||
+          (!send(item.first, entry, now, entry.transaction))) {
+        remaining = true;
+      }
+    }
+  }
+  locker.unlock();
+
+  for (const auto &item : finished) {
+    item.first(item.second);
+  }
+  return remaining;
+}
+
+void WriteCoalescer::flush(commandDataKey_t key) {
+  QMutexLocker locker(&m_mutex);
+
+  auto found = m_entries.find(key);
+  if ((found != m_entries.end()) && (found->second.queued)) {
+    send(key, found->second, m_clock.elapsed(), found->second.transaction);
+  }
+}
+
+void WriteCoalescer::flush() {
+  QMutexLocker locker(&m_mutex);
+  const qint64 now = m_clock.elapsed();
+
+  for (auto &item : m_entries) {
+    if (item.second.queued) {
+      send(item.first, item.second, now, item.second.transaction);
+    }
+  }
+}
+
+bool WriteCoalescer::pending() {
+  QMutexLocker locker(&m_mutex);
+  return (!m_transactions.empty()) || (!m_inFlight.empty()) ||
+         any_of(m_entries.begin(), m_entries.end(),
+                [](const Entries::value_type &item) {
+    return item.second.queued;
+  });
+}
+
+void WriteCoalescer::handleACK(CmdEnum, DeviceID, Word transID,
+                               const commandData_t &commandData) {
+  const auto &ack = commandData.get<ACK>();
+
+  QMutexLocker locker(&m_mutex);
+  auto found = m_inFlight.find(transID);
+  if ((found == m_inFlight.end()) ||
+      (found->second.command != ack.commandID())) {
+    return;
+  }
+
+  const auto sent = found->second;
+  m_inFlight.erase(found);
+
+  // an answer to a write sent before the latest one does not release the key
+  auto &entry = m_entries[sent.key];
+  if (entry.transID == transID) {
+    entry.inFlight = false;
+  }
+
+  const qint64 now = m_clock.elapsed();
+  Finished finished;
+  if (sent.transaction != 0) {
+    auto transaction = m_transactions.find(sent.transaction);
+    if (transaction != m_transactions.end()) {
+      if (ack.errorCode() != ErrorCode::NoError) {
+        transaction->second.refused = true;
+      }
+      if (--transaction->second.unanswered == 0) {
+        finish(transaction, now, finished);
+      }
+    }
+  }
+
+  if ((entry.queued) && (due(entry, now))) {
+    send(sent.key, entry, now, entry.transaction);
+  }
+  locker.unlock();
+
+  for (const auto &item : finished) {
+    item.first(item.second);
+  }
+}
+
+bool WriteCoalescer::due(const Entry &entry, qint64 now) const {
+  const qint64 since = now - entry.sent;
+  if ((entry.inFlight) && (since < m_timeout)) {
+    return false;
+  }
+  return (entry.sent < 0) || (since >= m_interval);
+}
+
+// skips the IDs of writes still unanswered while there are others
+Word WriteCoalescer::nextTransID() {
+  Word transID = kWriteTransIDFirst;
+  for (int i = 0; i < kWriteTransIDCount; ++i) {
+    transID = (Word)(kWriteTransIDFirst + m_nextTransID);
+    m_nextTransID = (m_nextTransID + 1) % kWriteTransIDCount;
+    if (m_inFlight.count(transID) == 0) {
+      break;
+    }
+  }
+  return transID;
+}
+
+// false if the request queue was full, the write stays queued for the
+// next poll
+bool WriteCoalescer::send(commandDataKey_t key, Entry &entry, qint64 now,
+                          long transaction) {
+  // a write given up on is replaced, its retries would undo this one
+  if ((m_comm) && (entry.inFlight) && (now - entry.sent >= m_timeout)) {
+    m_comm->cancelRequest(entry.transID);
+  }
+
+  const Word transID = nextTransID();
+  if ((m_comm) && (!m_comm->sendSysex(withTransID(entry.sysex, transID)))) {
+    entry.queued = true;
+    entry.transaction = transaction;
+    return false;
+  }
+
+  Sent item = {key, sysexCommand(entry.sysex), transaction, now};
+  m_inFlight[transID] = item;
+
+  entry.inFlight = true;
+  entry.queued = false;
+  entry.sent = now;
+  entry.transID = transID;
+  entry.transaction = 0;
+  return true;
+}
+
+// the unanswered writes of a transaction given up on
+void WriteCoalescer::forget(long transaction) {
+  for (auto sent = m_inFlight.begin(); sent != m_inFlight.end();) {
+    if (sent->second.transaction == transaction) {
+      auto &entry = m_entries[sent->second.key];
+      if (entry.transID == sent->first) {
+        entry.inFlight = false;
+      }
+      if (m_comm) {
+        m_comm->cancelRequest(sent->first);
+      }
+      sent = m_inFlight.erase(sent);
+    } else {
+      ++sent;
+    }
+  }
+}
+
+void WriteCoalescer::finish(Transactions::iterator transaction, qint64 now,
+                            Finished &finished) {
+  const auto &current = transaction->second;
+  const bool committed = (!current.refused) && (current.unanswered == 0);
+
+  if (!committed) {
+    forget(transaction->first);
+
+    // a key written again since keeps the newer value, one of the changes
+    // still queued after being refused is undone before it goes out
+    for (const auto &change : current.changes) {
+      auto &entry = m_entries[change.key];
+      const bool refused =
+          (entry.queued) && (entry.transaction == transaction->first);
+      if (((entry.queued) && (!refused)) || (entry.sysex != change.sysex)) {
+        continue;
+      }
+      entry.sysex = change.undo;
+      send(change.key, entry, now);
+    }
+  }
+
+  if (current.done) {
+    finished.push_back(make_pair(current.done, committed));
+  }
+  m_transactions.erase(transaction);
+}
+
+}  // namespace GeneSysLib
+
+#endif  // __IOS__
@@ -0,0 +1,153 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef __WRITECOALESCER_H__
+#define __WRITECOALESCER_H__
+
+#ifndef __IOS__
+
+#include "LibTypes.h"
+#include "CommandDataKey.h"
+#include "Communicator.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+#ifndef Q_MOC_RUN
+#include <boost/function.hpp>
+#endif
+#include <map>
+#include <vector>
+
+#define kCoalesceInterval 40   // msec between writes of the same setting
+#define kCoalesceTimeout 250   // msec before an unanswered write is given up
+
+// the transaction IDs the writes go out with, apart from the device's own
+#define kWriteTransIDFirst 0x3E00
+#define kWriteTransIDCount 0x100
+
+namespace GeneSysLib {
+
+// Collapses bursts of Set commands for the same setting, such as the values
+// sent while a fader is dragged. Writes are keyed by the command data key of
+// the setting. While a write for a key is unanswered or the key was written
+// less than `interval` ago, a newer value replaces the queued one, so only
+// the latest value goes out once the device has caught up. Each write goes
+// out with a transaction ID of its own, the ACK carrying it answers that
+// write and no other.
+//
+// Linked settings, such as the two channels of a stereo pair, are written
+// together as a transaction: their Set commands go out back to back and the
+// caller hears once whether the device took all of them.
+struct WriteCoalescer {
+  // a setting written by a transaction, undo puts back its previous value
+  struct Change {
+    commandDataKey_t key;
+    Bytes sysex;
+    Bytes undo;
+  };
+
+  typedef std::vector<Change> Changes;
+  typedef boost::function<void(bool)> Completion;
+
+  WriteCoalescer(CommPtr comm);
+  ~WriteCoalescer();
+
+  void setInterval(int msec);
+  int interval() const;
+  void setTimeout(int msec);
+
+  // sends now or queues, replacing any queued write for the key. A write the
+  // communicator refuses stays queued and goes out on a later poll.
+  void write(commandDataKey_t key, const Bytes &sysex);
+
+  // Sends the changes back to back, queued writes of their keys are dropped.
+  // done(true) once the device acknowledged every change. If one is refused
+  // or unanswered within the timeout the undo writes go out, except for keys
+  // written again since, and done(false). done is called without the lock
+  // held, on the thread that saw the last answer or the timeout.
+  void writeTogether(const Changes &changes, Completion done);
+
+  // sends the queued writes that are due and gives up on writes and
+  // transactions past their timeout, returns true if any remain
+  bool poll();
+
+  // sends the queued write for a key, or all of them, without waiting
+  void flush(commandDataKey_t key);
+  void flush();
+
+  bool pending();
+
+ private:
+  struct Entry {
+    Entry()
+        : inFlight(false), queued(false), sent(-1), transID(0),
+          transaction(0) {}
+
+    bool inFlight;
+    bool queued;
+    qint64 sent;       // -1 until the first write
+    Word transID;      // of the latest write sent
+    long transaction;  // of a queued write that was refused
+    Bytes sysex;
+  };
+
+  struct Transaction {
+    Changes changes;
+    Completion done;
+    size_t unanswered;
+    bool refused;
+    qint64 sent;
+  };
+
+  // an unanswered write, transaction 0 for a coalesced one
+  struct Sent {
+    commandDataKey_t key;
+    CmdEnum command;
+    long transaction;
+    qint64 sent;
+  };
+
+  typedef std::map<commandDataKey_t, Entry> Entries;
+  typedef std::map<Word, Sent> InFlight;
+  typedef std::map<long, Transaction> Transactions;
+  typedef std::vector<std::pair<Completion, bool> > Finished;
+
+  void handleACK(CmdEnum command, DeviceID deviceID, Word transID,
+                 const commandData_t &commandData);
+
+  bool due(const Entry &entry, qint64 now) const;
+  Word nextTransID();
+  bool send(commandDataKey_t key, Entry &entry, qint64 now,
+            long transaction = 0);
+  void forget(long transaction);
+  void finish(Transactions::iterator transaction, qint64 now,
+              Finished &finished);
+
+  CommPtr m_comm;
+  long m_ackHandlerID;
+
+  QMutex m_mutex;
+  QElapsedTimer m_clock;
+  Entries m_entries;
+
+  // unanswered writes by the transaction ID they went out with
+  InFlight m_inFlight;
+  Word m_nextTransID;
+
+  Transactions m_transactions;
+  long m_nextTransaction;
+
+  int m_interval;
+  int m_timeout;
+};  // struct WriteCoalescer
+
+}  // namespace GeneSysLib
+
+#endif  // __IOS__
+
+#endif  // __WRITECOALESCER_H__
@@ -8,11 +8,11 @@
 #ifndef PROPERTY_H
 #define PROPERTY_H
 
+#include <limits>
 #include <string>
 #include <vector>
 #ifndef Q_MOC_RUN
 #include <boost/array.hpp>
-#include <boost/function.hpp>
 #endif
 
 typedef boost::array<unsigned char, 5> SerialNumber;
@@ -21,34 +21,46 @@ typedef boost::array<unsigned char, 4> NetAddr;
 
 template <typename T>
 struct readwrite_property {
-  typedef boost::function<T(void)> test_point;
-  explicit readwrite_property() : prop(), min(), max() {}
+  explicit readwrite_property() : prop() {}
+  explicit readwrite_property(const T& t) : prop(t) {}
 
-  explicit readwrite_property(const T& t) : prop(t), min(), max() {}
+  T& operator()(void) { return prop; }
+  const T& operator()(void) const { return prop; }
+
+  void operator()(const T& t) { prop = t; }
 
-  explicit readwrite_property(test_point _min, test_point _max)
+ private:
+  T prop;
+};
+
+// A readwrite property whose setter clamps to a range only known at run
+// time, such as the limits a device reports alongside the value. The bounds
+// are kept by value so the property copies with the command data it is in.
+// Without bounds it takes any value of T.
+template <typename T>
+struct ranged_property {
+  ranged_property()
+      : prop(),
+        min(std::numeric_limits<T>::min()),
+        max(std::numeric_limits<T>::max()) {}
+
+  explicit ranged_property(const T& _min, const T& _max)
       : prop(), min(_min), max(_max) {}
 
-  explicit readwrite_property(const T& t, test_point _min, test_point _max)
+  explicit ranged_property(const T& t, const T& _min, const T& _max)
       : prop(t), min(_min), max(_max) {}
 
-  T& operator()(void) { return prop; }
   const T& operator()(void) const { return prop; }
 
-  void operator()(T t) {
-    prop = t;
-    if ((min) && (t < min())) {
-      prop = min();
-    }
-    if ((max) && (t > max())) {
-      prop = max();
-    }
-  }
+  void operator()(const T& t) { prop = (t < min) ? min : (t > max) ? max : t; }
+
+  const T& minimum() const { return min; }
+  const T& maximum() const { return max; }
 
  private:
   T prop;
-  test_point min;
-  test_point max;
+  T min;
+  T max;
 };
 
 template <typename T>
@@ -67,6 +79,7 @@ typedef readwrite_property<bool> rwBool;
 
 typedef readonly_property<uint8_t> roByte;
 typedef readwrite_property<uint8_t> rwByte;
+typedef ranged_property<uint8_t> rangedByte;
 
 typedef readonly_property<uint16_t> roWord;
 typedef readwrite_property<uint16_t> rwWord;
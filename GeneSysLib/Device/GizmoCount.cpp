@@ -7,9 +7,13 @@
 
 #include "stdafx.h"
 #include "GizmoCount.h"
+#include "WireSchema.h"
 
 namespace GeneSysLib {
 
+struct GizmoCount::Layout
+    : Wire::Schema<WIRE_FIELD(MidiWord, GizmoCount, gizmoCount)> {};
+
 CmdEnum GizmoCount::retCommand() { return Command::RetGizmoCount; }
 
 GizmoCount::GizmoCount(void) : gizmoCount() {}
@@ -20,14 +24,12 @@ const commandDataKey_t GizmoCount::key() const {
 
 Bytes GizmoCount::generate() const {
   Bytes result;
-
-  appendMidiWord(result, gizmoCount());
-
+  Layout::generate(*this, result);
   return result;
 }
 
 void GizmoCount::parse(BytesIter &beginIter, BytesIter &endIter) {
-  gizmoCount = roWord(nextMidiWord(beginIter, endIter));
+  Layout::parse(*this, beginIter, endIter);
 }
 
 }  // namespace GeneSysLib
@@ -27,6 +27,9 @@ struct GizmoCount {
 
   // properties
   roWord gizmoCount;
+
+ private:
+  struct Layout;
 };  // struct GizmoCount
 
 typedef SysexCommand<Command::GetGizmoCount, EmptyCommandData>
@@ -0,0 +1,671 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+// Times decoding, parsing and generating every answer SysexParser knows,
+// each with a payload of the size a fully featured device sends, and counts
+// the heap allocations every operation makes.
+//
+//   GeneSysLibBenchmarks [iterations]
+
+#include "CommandData.h"
+#include "CommandDefines.h"
+#include "MIDIPortFilter.h"
+#include "MeterBlocks.h"
+#include "StreamHelpers.h"
+#include "SysexParser.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/assign/std/vector.hpp>
+#endif
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+#include <string>
+
+using namespace GeneSysLib;
+using namespace boost::assign;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+// allocation counting, the benchmark runs on a single thread
+
+static unsigned long allocations = 0;
+
+void *operator new(size_t size) {
+  ++allocations;
+  void *p = malloc(size ? size : 1);
+  if (!p) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete[](void *p) noexcept { free(p); }
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// payload helpers
+
+void appendName(Bytes &payload, const string &name) {
+  appendMidiByte(payload, name.size());
+  appendString(payload, name);
+}
+
+void appendNetAddr(Bytes &payload) {
+  // 192.168.1.100 packed in 5 bytes of 7 bits
+  payload += 0x0C, 0x05, 0x20, 0x00, 0x64;
+}
+
+void appendMeterBlocks(Bytes &payload, Byte blockCount, Byte valueCount) {
+  appendMidiByte(payload, blockCount);
+  for (Byte block = 0; block < blockCount; ++block) {
+    appendMidiByte(payload, block + 1);  // meter type
+    appendMidiByte(payload, valueCount);
+    for (Byte value = 0; value < valueCount; ++value) {
+      appendMidiWord(payload, 0x1000 + value * 0x40);
+    }
+  }
+}
+
+// a complete answer around the payload, as it arrives from a device
+Bytes frame(CmdEnum command, const Bytes &payload) {
+  Bytes sysex;
+  sysex += 0xF0, 0x00, 0x01, 0x73, 0x7E;
+  appendMidiWord(sysex, 0x0005);  // product ID
+  sysex += 0x00, 0x00, 0x01, 0x23, 0x45;  // serial number
+  appendMidiWord(sysex, 0x0001);  // transaction ID
+  appendMidiWord(sysex, command);
+  appendMidiWord(sysex, payload.size());
+  sysex.insert(sysex.end(), payload.begin(), payload.end());
+  sysex += (~accumulate(sysex.begin() + 5, sysex.end(), 0x00) + 1) & 0x7F;
+  sysex += 0xF7;
+  return sysex;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// payloads
+
+Bytes device() {
+  Bytes p;
+  p += 0x01, 0x00;
+  appendMidiWord(p, 0x0200);
+  return p;
+}
+
+Bytes commandList() {
+  Bytes p;
+  for (Word command = 0x01; command < 0x68; ++command) {
+    appendMidiWord(p, command);
+  }
+  return p;
+}
+
+Bytes infoList() {
+  Bytes p;
+  p += 0x01, 0x00, 0x02, 0x00, 0x03, 0x00, 0x04, 0x00, 0x05, 0x00, 0x06, 0x00,
+      0x07, 0x00, 0x08, 0x00, 0x10, 0x1F;
+  return p;
+}
+
+Bytes info() {
+  Bytes p;
+  p += 0x10;
+  appendString(p, "iConnectAUDIO4+ Studio A");
+  return p;
+}
+
+Bytes resetList() {
+  Bytes p;
+  p += 0x01, 0x02;
+  return p;
+}
+
+Bytes saveRestoreList() {
+  Bytes p;
+  p += 0x01, 0x02, 0x03, 0x04, 0x05;
+  return p;
+}
+
+Bytes ethernetPortInfo() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01;
+  for (int i = 0; i < 6; ++i) {
+    appendNetAddr(p);
+  }
+  appendString(p, "0021A8E2C5F1");
+  appendName(p, "iConnectMIDI4+ Rack");
+  return p;
+}
+
+Bytes ack() {
+  Bytes p;
+  appendMidiWord(p, Command::SetMIDIPortFilter);
+  p += 0x00;
+  return p;
+}
+
+Bytes gizmoCount() {
+  Bytes p;
+  appendMidiWord(p, 0x0004);
+  return p;
+}
+
+Bytes gizmoInfo() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0002);
+  p += 0x01;
+  appendMidiWord(p, 0x0021);
+  appendMidiWord(p, 0x0005);
+  p += 0x00, 0x00, 0x01, 0x23, 0x46;
+  return p;
+}
+
+Bytes midiInfo() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x004A);
+  appendMidiWord(p, 0x0009);
+  p += 0x04, 0x01, 0x02, 0x01, 0x10, 0x10, 0x04, 0x04, 0x03, 0x10;
+  return p;
+}
+
+Bytes midiPortInfo() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0011);
+  p += 0x03, 0x01, 0x02, 0x00, 0x00;
+  p += 0x14, 0x03;
+  appendString(p, "USB Host 1 Port 2");
+  return p;
+}
+
+Bytes midiPortFilter() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01, 0x08;
+  p += 0x00, 0x0F;
+  for (int channel = 0; channel < kMIDIPortFilterNumberOfChannels; ++channel) {
+    p += 0x3F;
+  }
+  for (Byte controller = 0; controller < 8; ++controller) {
+    p += 0x00, 0x00, 0x7F, 0x7F;
+    p += controller + 1;
+  }
+  return p;
+}
+
+Bytes midiPortRemap() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01, 0x08;
+  for (Byte channel = 0; channel < 16; ++channel) {
+    p += 0x3F, channel;
+  }
+  for (Byte controller = 0; controller < 8; ++controller) {
+    p += 0x00, 0x00, 0x7F, 0x7F;
+    p += controller + 1, controller + 0x10;
+  }
+  return p;
+}
+
+Bytes midiPortRoute() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  // one bit for each of 74 ports, four to a byte
+  for (int i = 0; i < 19; ++i) {
+    p += 0x0F;
+  }
+  return p;
+}
+
+Bytes midiPortDetail() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0011);
+  p += 0x03;
+  p += 0x01, 0x01, 0x02;
+  appendMidiWord3Byte(p, 0x0582);
+  appendMidiWord3Byte(p, 0x012B);
+  appendName(p, "Roland");
+  appendName(p, "INTEGRA-7");
+  return p;
+}
+
+Bytes rtpMIDIConnectionDetail() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0021);
+  p += 0x01;
+  appendNetAddr(p);
+  appendMidiWord3Byte(p, 5004);
+  appendName(p, "Studio MacBook Pro");
+  return p;
+}
+
+Bytes usbHostMIDIDeviceDetail() {
+  Bytes p;
+  p += 0x01, 0x01, 0x01, 0x02, 0x02;
+  appendMidiWord3Byte(p, 0x0582);
+  appendMidiWord3Byte(p, 0x012B);
+  appendName(p, "Roland");
+  appendName(p, "INTEGRA-7");
+  return p;
+}
+
+Bytes audioInfo() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0004);
+  p += 0x02, 0x01, 0x01, 0x00;
+  return p;
+}
+
+Bytes audioCfgInfo() {
+  Bytes p;
+  p += 0x01, 0x01, 0x10, 0x04, 0x01, 0x04, 0x02, 0x01, 0x06;
+  for (Byte block = 1; block <= 6; ++block) {
+    p += block, 0x02, block, 0x08;
+  }
+  return p;
+}
+
+Bytes audioPortInfo() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x02, 0x01, 0x00, 0x00, 0x00;
+  p += 0x14, 0x00, 0x00, 0x00, 0x03;
+  appendString(p, "USB Device 1");
+  return p;
+}
+
+Bytes audioPortCfgInfo() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x08, 0x08, 0x06;
+  for (Byte block = 1; block <= 6; ++block) {
+    p += block, 0x00, 0x08, 0x00, 0x08;
+  }
+  return p;
+}
+
+Bytes audioPatchbay() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x10;
+  for (Byte channel = 1; channel <= 16; ++channel) {
+    p += channel, channel;
+    appendMidiWord(p, 0x0002);
+  }
+  return p;
+}
+
+Bytes audioClock() {
+  Bytes p;
+  p += 0x01, 0x01, 0x03;
+  for (Byte block = 1; block <= 3; ++block) {
+    p += block, block, 0x01, 0x00;
+  }
+  return p;
+}
+
+// a V2 audio device clocked from its second USB port, with the internal
+// clock and the clock of each of its three audio ports to choose from
+Bytes audioClockParm() {
+  Bytes p;
+  p += 0x01, 0x03, 0x04;
+  p += 0x01, 0x01, 0x00, 0x00;
+  for (Byte port = 1; port <= 3; ++port) {
+    p += port + 1, 0x02, port, 0x00;
+  }
+  return p;
+}
+
+// the patchbay of a V2 audio port with 24 inputs, each routed to an output
+// channel of one of the other two audio ports
+Bytes audioPatchbayParm() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0002);
+  p += 0x18;
+  for (Byte channel = 1; channel <= 24; ++channel) {
+    p += channel, (channel - 1) % 12 + 1;
+    appendMidiWord(p, (channel <= 12) ? 0x0001 : 0x0003);
+  }
+  return p;
+}
+
+Bytes audioGlobalParm() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0004);
+  p += 0x01, 0x10, 0x04, 0x01, 0x04, 0x02, 0x01, 0x06;
+  for (Byte block = 1; block <= 6; ++block) {
+    p += block, 0x02, block;
+  }
+  return p;
+}
+
+Bytes audioPortParm() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0003);
+  p += 0x03, 0x08, 0x08, 0x06;
+  for (Byte block = 1; block <= 6; ++block) {
+    p += block, 0x08, 0x00, 0x08, 0x00, 0x08;
+  }
+  p += 0x14;
+  appendName(p, "USB Host 1");
+  p += 0x01, 0x01;
+  return p;
+}
+
+Bytes audioDeviceParm() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0003);
+  p += 0x03, 0x04;
+  p += 0x01, 0x08, 0x08;
+  p += 0x08;
+  for (Byte channel = 1; channel <= 8; ++channel) {
+    p += channel, channel;
+  }
+  p += 0x08;
+  for (Byte channel = 1; channel <= 8; ++channel) {
+    p += channel, channel;
+  }
+  appendMidiWord3Byte(p, 0x0582);
+  appendMidiWord3Byte(p, 0x0164);
+  appendName(p, "Roland");
+  appendName(p, "OCTA-CAPTURE");
+  return p;
+}
+
+Bytes audioControlParm() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01, 0x06;
+  p += 0x08;
+  appendName(p, "Analog Inputs");
+  return p;
+}
+
+Bytes audioControlDetail() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01, 0x01, 0x06;
+  p += 0x01, 0x01, 0x1F, 0x1F;
+  for (int i = 0; i < 6; ++i) {
+    appendMidiWord3Byte(p, 0x2000 + i);
+  }
+  appendName(p, "Input 1");
+  return p;
+}
+
+Bytes audioControlDetailValue() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01, 0x01, 0x06;
+  p += 0x1F;
+  appendMidiWord3Byte(p, 0x3F00);
+  appendMidiWord3Byte(p, 0x0100);
+  p += 0x00, 0x01, 0x00, 0x01;
+  return p;
+}
+
+Bytes audioPortMeterValue() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  appendMeterBlocks(p, kMeterBlockCapacity, kMeterValueCapacity);
+  return p;
+}
+
+Bytes mixerParm() {
+  Bytes p;
+  p += 0x01, 0x01, 0x01, 0x04;
+  for (Byte block = 1; block <= 4; ++block) {
+    p += block, 0x10, 0x08;
+  }
+  return p;
+}
+
+Bytes mixerPortParm() {
+  Bytes p;
+  p += 0x01, 0x04;
+  for (Word port = 1; port <= 4; ++port) {
+    appendMidiWord(p, port);
+    p += 0x10, 0x08;
+  }
+  return p;
+}
+
+Bytes mixerInputParm() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01;
+  appendMidiWord(p, 0x0002);
+  p += 0x03;
+  return p;
+}
+
+Bytes mixerOutputParm() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01, 0x02, 0x01, 0x02;
+  p += 0x14;
+  appendName(p, "Main Mix");
+  return p;
+}
+
+Bytes mixerControl() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x7F, 0x7F;
+  appendMidiWord3Byte(p, 0x0100);
+  p += 0x04, 0x00, 0x01, 0x02, 0x03;
+  appendMidiWord3Byte(p, 0x0000);
+  appendMidiWord3Byte(p, 0x3F00);
+  appendMidiWord3Byte(p, 0x0100);
+  return p;
+}
+
+Bytes mixerInputControlValue() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01, 0x01, 0x7F;
+  appendMidiWord3Byte(p, 0x3F00);
+  p += 0x00, 0x01, 0x00, 0x01, 0x00;
+  appendMidiWord3Byte(p, 0x0080);
+  p += 0x01;
+  return p;
+}
+
+Bytes mixerOutputControlValue() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01, 0x7F;
+  appendMidiWord3Byte(p, 0x3F00);
+  p += 0x00;
+  appendMidiWord3Byte(p, 0x2000);
+  p += 0x00, 0x01, 0x00;
+  appendMidiWord3Byte(p, 0x0080);
+  p += 0x01;
+  return p;
+}
+
+Bytes mixerMeterValue() {
+  Bytes p;
+  p += 0x01;
+  appendMidiWord(p, 0x0001);
+  p += 0x01;
+  appendMeterBlocks(p, kMeterBlockCapacity, kMeterValueCapacity);
+  return p;
+}
+
+struct Case {
+  const char *name;
+  CmdEnum command;
+  Bytes (*payload)();
+};
+
+const Case cases[] = {
+    {"Device", Command::RetDevice, device},
+    {"CommandList", Command::RetCommandList, commandList},
+    {"InfoList", Command::RetInfoList, infoList},
+    {"Info", Command::RetInfo, info},
+    {"ResetList", Command::RetResetList, resetList},
+    {"SaveRestoreList", Command::RetSaveRestoreList, saveRestoreList},
+    {"EthernetPortInfo", Command::RetEthernetPortInfo, ethernetPortInfo},
+    {"ACK", Command::ACK, ack},
+    {"GizmoCount", Command::RetGizmoCount, gizmoCount},
+    {"GizmoInfo", Command::RetGizmoInfo, gizmoInfo},
+    {"MIDIInfo", Command::RetMIDIInfo, midiInfo},
+    {"MIDIPortInfo", Command::RetMIDIPortInfo, midiPortInfo},
+    {"MIDIPortFilter", Command::RetMIDIPortFilter, midiPortFilter},
+    {"MIDIPortRemap", Command::RetMIDIPortRemap, midiPortRemap},
+    {"MIDIPortRoute", Command::RetMIDIPortRoute, midiPortRoute},
+    {"MIDIPortDetail", Command::RetMIDIPortDetail, midiPortDetail},
+    {"RTPMIDIConnectionDetail", Command::RetRTPMIDIConnectionDetail,
+     rtpMIDIConnectionDetail},
+    {"USBHostMIDIDeviceDetail", Command::RetUSBHostMIDIDeviceDetail,
+     usbHostMIDIDeviceDetail},
+    {"AudioInfo", Command::RetAudioInfo, audioInfo},
+    {"AudioCfgInfo", Command::RetAudioCfgInfo, audioCfgInfo},
+    {"AudioPortInfo", Command::RetAudioPortInfo, audioPortInfo},
+    {"AudioPortCfgInfo", Command::RetAudioPortCfgInfo, audioPortCfgInfo},
+    {"AudioPortPatchbay", Command::RetAudioPortPatchbay, audioPatchbay},
+    {"AudioClockInfo", Command::RetAudioClockInfo, audioClock},
+    {"AudioGlobalParm", Command::RetAudioGlobalParm, audioGlobalParm},
+    {"AudioPortParm", Command::RetAudioPortParm, audioPortParm},
+    {"AudioDeviceParm", Command::RetAudioDeviceParm, audioDeviceParm},
+    {"AudioControlParm", Command::RetAudioControlParm, audioControlParm},
+    {"AudioControlDetail", Command::RetAudioControlDetail, audioControlDetail},
+    {"AudioControlDetailValue", Command::RetAudioControlDetailValue,
+     audioControlDetailValue},
+    {"AudioClockParm", Command::RetAudioClockParm, audioClockParm},
+    {"AudioPatchbayParm", Command::RetAudioPatchbayParm,
+     audioPatchbayParm},
+    {"AudioPortMeterValue", Command::RetAudioPortMeterValue,
+     audioPortMeterValue},
+    {"MixerParm", Command::RetMixerParm, mixerParm},
+    {"MixerPortParm", Command::RetMixerPortParm, mixerPortParm},
+    {"MixerInputParm", Command::RetMixerInputParm, mixerInputParm},
+    {"MixerOutputParm", Command::RetMixerOutputParm, mixerOutputParm},
+    {"MixerInputControl", Command::RetMixerInputControl, mixerControl},
+    {"MixerOutputControl", Command::RetMixerOutputControl, mixerControl},
+    {"MixerInputControlValue", Command::RetMixerInputControlValue,
+     mixerInputControlValue},
+    {"MixerOutputControlValue", Command::RetMixerOutputControlValue,
+     mixerOutputControlValue},
+    {"MixerMeterValue", Command::RetMixerMeterValue, mixerMeterValue}};
+
+////////////////////////////////////////////////////////////////////////////////
+// measuring
+
+struct Result {
+  double nsPerOp;
+  double allocationsPerOp;
+};
+
+volatile size_t sink = 0;
+
+template <typename Operation>
+Result measure(long iterations, Operation operation) {
+  // one run outside the measurement to warm the caches up
+  operation();
+
+  const auto startAllocations = allocations;
+  const auto start = chrono::steady_clock::now();
+  for (long i = 0; i < iterations; ++i) {
+    operation();
+  }
+  const auto elapsed = chrono::steady_clock::now() - start;
+
+  Result result;
+  result.nsPerOp =
+      (double)chrono::duration_cast<chrono::nanoseconds>(elapsed).count() /
+      iterations;
+  result.allocationsPerOp = (double)(allocations - startAllocations) / iterations;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const long iterations = (argc > 1) ? max(atol(argv[1]), 1L) : 100000L;
+
+  printf("%-24s %5s %12s %8s %12s %8s %12s %8s\n", "answer", "bytes",
+         "decode ns", "allocs", "parse ns", "allocs", "generate ns", "allocs");
+
+  for (const auto &c : cases) {
+    Bytes sysex = frame(c.command, c.payload());
+
+    DeviceID deviceID;
+    Word transID;
+    CmdEnum command;
+    commandData_t commandData;
+    if (!SysexParser::decode(sysex.begin(), sysex.end(), deviceID, transID,
+                             command, commandData)) {
+      fprintf(stderr, "%s: the answer does not decode\n", c.name);
+      return 1;
+    }
+
+    // a new object for every answer, as the MIDI thread does
+    const Result decode = measure(iterations, [&]() {
+      DeviceID d;
+      Word t;
+      CmdEnum cmd;
+      commandData_t data;
+      SysexParser::decode(sysex.begin(), sysex.end(), d, t, cmd, data);
+      sink = sink + t;
+    });
+
+    // the payload alone into the object decoded above
+    const Result parse = measure(iterations, [&]() {
+      BytesIter beginIter = sysex.begin() + 18;
+      BytesIter endIter = sysex.end() - 2;
+      commandData.parse(beginIter, endIter);
+      sink = sink + distance(sysex.begin(), beginIter);
+    });
+
+    const Result generate = measure(iterations, [&]() {
+      const Bytes bytes = commandData.generate();
+      sink = sink + bytes.size();
+    });
+
+    printf("%-24s %5lu %12.1f %8.2f %12.1f %8.2f %12.1f %8.2f\n", c.name,
+           (unsigned long)sysex.size(), decode.nsPerOp,
+           decode.allocationsPerOp, parse.nsPerOp, parse.allocationsPerOp,
+           generate.nsPerOp, generate.allocationsPerOp);
+  }
+
+  return 0;
+}
@@ -0,0 +1,49 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += release
+
+QT += core gui network
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET="GeneSysLibBenchmarks"
+
+DEFINES += BOOST_RESULT_OF_USE_DECLTYPE
+
+mac: QMAKE_CXXFLAGS = -std=c++11 -stdlib=libstdc++ -Wno-unused-parameter -mmacosx-version-min=10.6
+mac: QMAKE_LFLAGS = -std=c++11 -stdlib=libstdc++ -Wno-unused-parameter -mmacosx-version-min=10.6
+mac: QMAKE_CXXFLAGS += -isystem /opt/local/include
+unix:!mac: QMAKE_CXXFLAGS += -std=c++11
+
+mac: LIBS           += -framework CoreMIDI
+mac: LIBS           += -framework CoreFoundation
+mac: LIBS           += -framework CoreAudio
+
+win32: INCLUDEPATH  += C:/boost_1_57_0/
+win32: DEPENDPATH   += C:/boost_1_57_0/
+
+mac: INCLUDEPATH += /opt/local/include/
+mac: DEPENDPATH += /opt/local/include/
+
+SOURCES += \
+    Bench_Protocol.cpp
+
+DEPENDPATH += $$PWD/../
+INCLUDEPATH += $$PWD/../
+INCLUDEPATH += \
+    $$PWD/../Audio \
+    $$PWD/../Audio/Mixer \
+    $$PWD/../Audio/AudioV1 \
+    $$PWD/../Audio/AudioV2 \
+    $$PWD/../Base \
+    $$PWD/../Device \
+    $$PWD/../MIDI
+INCLUDEPATH += $$PWD/../../rtmidi-2.1.1
+DEPENDPATH += $$PWD/../../rtmidi-2.1.1
+
+win32: LIBS += -LC:/boost_1_57_0/lib32-msvc-12.0/
+
+win32:CONFIG(release, debug|release): LIBS += -L$$PWD/../build-GeneSysLib-Desktop-Release/release/ -lGeneSysLib
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/../build-GeneSysLib-Desktop-Debug/debug/ -lGeneSysLib
+else:unix: LIBS += -L$$PWD/../build-GeneSysLib-Desktop-Release/ -lGeneSysLib
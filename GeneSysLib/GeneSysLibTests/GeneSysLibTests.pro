@@ -8,14 +8,48 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET="GeneSysLibTests"
 
+DEFINES += BOOST_RESULT_OF_USE_DECLTYPE
+
+mac: QMAKE_CXXFLAGS = -std=c++11 -stdlib=libstdc++ -Wno-unused-parameter -mmacosx-version-min=10.6
+mac: QMAKE_LFLAGS = -std=c++11 -stdlib=libstdc++ -Wno-unused-parameter -mmacosx-version-min=10.6
+mac: QMAKE_CXXFLAGS += -isystem /opt/local/include
+unix:!mac: QMAKE_CXXFLAGS += -std=c++11
+
+mac: LIBS           += -framework CoreMIDI
+mac: LIBS           += -framework CoreFoundation
+mac: LIBS           += -framework CoreAudio
+
+mac: INCLUDEPATH += /opt/local/include/
+mac: DEPENDPATH += /opt/local/include/
 
 SOURCES += \
     Test_Device.cpp \
-    main.cpp
+    Test_FirmwareTransfer.cpp \
+    Test_MPSCQueue.cpp \
+    Test_PresetFile.cpp \
+    Test_QueryPlan.cpp \
+    Test_VirtualDevice.cpp \
+    Test_WireSchema.cpp \
+    main.cpp \
+    ../../iConfig/Presets/PresetFile.cpp
 
 macx: LIBS += -lboost_unit_test_framework
+unix:!macx: LIBS += -lboost_unit_test_framework
 
 DEPENDPATH += $$PWD/../
 INCLUDEPATH += $$PWD/../
+INCLUDEPATH += \
+    $$PWD/../Audio \
+    $$PWD/../Audio/Mixer \
+    $$PWD/../Audio/AudioV1 \
+    $$PWD/../Audio/AudioV2 \
+    $$PWD/../Base \
+    $$PWD/../Device \
+    $$PWD/../MIDI \
+    $$PWD/../../iConfig/Presets
 INCLUDEPATH += $$PWD/../../../../rtmidi-2.0.1
 DEPENDPATH += $$PWD/../../../../rtmidi-2.0.1
+
+win32:CONFIG(release, debug|release): LIBS += -L$$PWD/../build-GeneSysLib-Desktop-Release/release/ -lGeneSysLib
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/../build-GeneSysLib-Desktop-Debug/debug/ -lGeneSysLib
+else:unix: LIBS += -L$$PWD/../build-GeneSysLib-Desktop-Release/ -lGeneSysLib
@@ -0,0 +1,274 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include "FirmwareTransfer.h"
+#include "StreamHelpers.h"
+#include "VirtualDevice.h"
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QThread>
+
+using namespace GeneSysLib;
+
+namespace {
+
+const size_t kFrames = 8;
+
+// QThread::msleep is protected in Qt 4
+struct Sleeper : public QThread {
+  static void msleep(unsigned long msec) { QThread::msleep(msec); }
+};
+
+// a write the bootloader ACKs, as the frames of a firmware file are
+Bytes frame(Word transID) {
+  Bytes result;
+  result += 0xF0, 0x00, 0x01, 0x73, 0x7E;
+  result.resize(12, 0x00);  // the PID and serial number
+  appendMidiWord(result, transID);
+  appendMidiWord(result, Command::SetInfo);
+  appendMidiWord(result, 4);
+  result += 0x01, 0x02, 0x03, 0x04;
+
+  int sum = 0;
+  for (size_t i = 5; i < result.size(); ++i) {
+    sum += result[i];
+  }
+  result += (~sum + 1) & 0x7F, 0xF7;
+  return result;
+}
+
+Bytes frames(size_t count, Word firstTransID = 1) {
+  Bytes result;
+  for (size_t i = 0; i < count; ++i) {
+    const Bytes sysex = frame((Word)(firstTransID + i));
+    result.insert(result.end(), sysex.begin(), sysex.end());
+  }
+  return result;
+}
+
+void appendLong(Bytes &data, quint32 value) {
+  data += (value >> 24) & 0xFF, (value >> 16) & 0xFF, (value >> 8) & 0xFF,
+      value & 0xFF;
+}
+
+// A format 0 MIDI file of the frames as sysex events, with the MD5 of those
+// events when md5 is set. Frames are shorter than 128 bytes so each length
+// is a single byte.
+Bytes midiFile(const Bytes &sysex, bool md5 = false, bool damageMD5 = false) {
+  Bytes events;
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  for (auto begin = sysex.begin(); begin != sysex.end();) {
+    const auto end = std::find(begin, sysex.end(), (Byte)0xF7) + 1;
+    const size_t start = events.size() + 1;
+    events += 0x00, 0xF0, (Byte)(end - begin - 1);
+    events.insert(events.end(), begin + 1, end);
+    hash.addData((const char *)&events[start], (int)(events.size() - start));
+    begin = end;
+  }
+
+  if (md5) {
+    QByteArray result = hash.result();
+    if (damageMD5) {
+      result[0] = result[0] ^ 0x01;
+    }
+    events += 0x00, 0xFF, 0x7F, 0x14, 0x00, 0x01, 0x73, 0x00;
+    events.insert(events.end(), result.begin(), result.end());
+  }
+  events += 0x00, 0xFF, 0x2F, 0x00;
+
+  Bytes result;
+  result += 'M', 'T', 'h', 'd';
+  appendLong(result, 6);
+  result += 0x00, 0x00, 0x00, 0x01, 0x00, 0x60;
+  result += 'M', 'T', 'r', 'k';
+  appendLong(result, events.size());
+  result.insert(result.end(), events.begin(), events.end());
+  return result;
+}
+
+bool load(FirmwareTransfer &transfer, const Bytes &data) {
+  return transfer.load(data.data(), data.size());
+}
+
+// a virtual device without bandwidth limit behind a Communicator
+struct Rig {
+  Rig() : device(new VirtualDevice()), comm(new Communicator()) {
+    device->setBandwidth(0);
+    comm->setTransport(device);
+    comm->openAllInputs();
+    comm->openAllOutputs();
+  }
+
+  VirtualDevicePtr device;
+  CommPtr comm;
+};
+
+// polls the transfer until it is no longer sending or msec have passed
+void run(FirmwareTransfer &transfer, qint64 msec) {
+  QElapsedTimer clock;
+  clock.start();
+  while ((transfer.poll()) && (clock.elapsed() < msec)) {
+    Sleeper::msleep(5);
+  }
+}
+
+// sends the file to a virtual device until it is done or a second has passed
+FirmwareTransfer::Progress upload(unsigned int maxWindow,
+                                  const Bytes &sysex = frames(kFrames)) {
+  Rig rig;
+  FirmwareTransfer transfer(rig.comm);
+  BOOST_REQUIRE(load(transfer, midiFile(sysex)));
+  if (maxWindow > 0) {
+    transfer.setMaxWindow(maxWindow);
+  }
+
+  transfer.start();
+  run(transfer, 1000);
+
+  BOOST_CHECK_EQUAL(transfer.state(), FirmwareTransfer::Complete);
+  return transfer.progress();
+}
+
+}  // namespace
+
+// Test that the sysex events of a MIDI file become one frame each
+BOOST_AUTO_TEST_CASE(firmware_load_midi_file) {
+  FirmwareTransfer transfer((CommPtr()));
+  const Bytes sysex = frames(3);
+  BOOST_REQUIRE(load(transfer, midiFile(sysex)));
+
+  const auto progress = transfer.progress();
+  BOOST_CHECK_EQUAL(progress.frames, 3u);
+  BOOST_CHECK_EQUAL(progress.bytes, sysex.size());
+  BOOST_CHECK_EQUAL(progress.framesAcked, 0u);
+  BOOST_CHECK_EQUAL(transfer.state(), FirmwareTransfer::Idle);
+}
+
+// Test that a file of bare sysex messages loads the same frames
+BOOST_AUTO_TEST_CASE(firmware_load_sysex_file) {
+  FirmwareTransfer transfer((CommPtr()));
+  const Bytes sysex = frames(3);
+  BOOST_REQUIRE(load(transfer, sysex));
+  BOOST_CHECK_EQUAL(transfer.progress().frames, 3u);
+  BOOST_CHECK_EQUAL(transfer.progress().bytes, sysex.size());
+}
+
+// Test that the MD5 a file carries is checked against its sysex events
+BOOST_AUTO_TEST_CASE(firmware_load_md5) {
+  FirmwareTransfer transfer((CommPtr()));
+  BOOST_CHECK(load(transfer, midiFile(frames(3), true)));
+  BOOST_CHECK(!load(transfer, midiFile(frames(3), true, true)));
+  BOOST_CHECK_EQUAL(transfer.progress().frames, 0u);
+}
+
+// Test that files without frames are refused
+BOOST_AUTO_TEST_CASE(firmware_load_refused) {
+  FirmwareTransfer transfer((CommPtr()));
+  BOOST_CHECK(!load(transfer, midiFile(Bytes())));
+
+  // a track running past the end of the file keeps nothing of it
+  Bytes truncated = midiFile(frames(2));
+  truncated.resize(truncated.size() - 4);
+  BOOST_CHECK(!load(transfer, truncated));
+}
+
+// Test that by default one frame is sent at a time
+BOOST_AUTO_TEST_CASE(firmware_window_default) {
+  const auto progress = upload(0);
+  BOOST_CHECK_EQUAL(progress.framesAcked, kFrames);
+  BOOST_CHECK_EQUAL(progress.window, 1u);
+  BOOST_CHECK_EQUAL(progress.stalls, 0);
+}
+
+// Test that the window opens by one frame with each ACK up to the maximum
+BOOST_AUTO_TEST_CASE(firmware_window_opens) {
+  const auto progress = upload(4);
+  BOOST_CHECK_EQUAL(progress.framesAcked, kFrames);
+  BOOST_CHECK_EQUAL(progress.bytesAcked, progress.bytes);
+  BOOST_CHECK_EQUAL(progress.window, 4u);
+  BOOST_CHECK_EQUAL(progress.stalls, 0);
+}
+
+// Test that frames sharing a transaction ID load and are sent one at a time
+BOOST_AUTO_TEST_CASE(firmware_window_repeated_transIDs) {
+  Bytes sysex;
+  for (size_t i = 0; i < kFrames; ++i) {
+    const Bytes again = frame((Word)(1 + i % 2));
+    sysex.insert(sysex.end(), again.begin(), again.end());
+  }
+
+  FirmwareTransfer transfer((CommPtr()));
+  BOOST_CHECK(load(transfer, midiFile(sysex)));
+  BOOST_CHECK(load(transfer, sysex));
+
+  const auto progress = upload(4, sysex);
+  BOOST_CHECK_EQUAL(progress.framesAcked, kFrames);
+  BOOST_CHECK_EQUAL(progress.bytesAcked, progress.bytes);
+  BOOST_CHECK_EQUAL(progress.stalls, 0);
+}
+
+// Test that lost ACKs stall the transfer, which goes back to the first frame
+// not acknowledged and still completes
+BOOST_AUTO_TEST_CASE(firmware_stall_goes_back) {
+  Rig rig;
+  rig.device->setSeed(1);  // the first ACK is lost
+  rig.device->setDropRate(0.2);
+
+  FirmwareTransfer transfer(rig.comm);
+  BOOST_REQUIRE(load(transfer, midiFile(frames(kFrames))));
+  transfer.setMaxWindow(4);
+  transfer.setStallTimeout(50);
+  transfer.setMaxRetries(4);
+
+  transfer.start();
+  run(transfer, 3000);
+
+  const auto progress = transfer.progress();
+  BOOST_CHECK_EQUAL(transfer.state(), FirmwareTransfer::Complete);
+  BOOST_CHECK_EQUAL(progress.framesAcked, kFrames);
+  BOOST_CHECK_EQUAL(progress.bytesAcked, progress.bytes);
+  BOOST_CHECK(progress.stalls > 0);
+}
+
+// Test that a failed transfer resumes from the first frame not acknowledged
+BOOST_AUTO_TEST_CASE(firmware_resume_after_failed) {
+  Rig rig;
+  rig.device->setLatency(20);
+
+  FirmwareTransfer transfer(rig.comm);
+  BOOST_REQUIRE(load(transfer, midiFile(frames(kFrames))));
+  transfer.setStallTimeout(50);
+  transfer.setMaxRetries(1);
+
+  // the device stops answering part way through
+  QElapsedTimer clock;
+  clock.start();
+  transfer.start();
+  while ((transfer.poll()) && (transfer.progress().framesAcked < 3) &&
+         (clock.elapsed() < 1000)) {
+    Sleeper::msleep(1);
+  }
+  rig.device->setDropRate(1.0);
+  run(transfer, 1000);
+
+  BOOST_REQUIRE_EQUAL(transfer.state(), FirmwareTransfer::Failed);
+  const auto failed = transfer.progress();
+  BOOST_CHECK(failed.framesAcked >= 3u);
+  BOOST_CHECK(failed.framesAcked < kFrames);
+
+  rig.device->setDropRate(0.0);
+  transfer.resume();
+  BOOST_CHECK_EQUAL(transfer.progress().framesAcked, failed.framesAcked);
+  BOOST_CHECK_EQUAL(transfer.progress().bytesAcked, failed.bytesAcked);
+  run(transfer, 1000);
+
+  BOOST_CHECK_EQUAL(transfer.state(), FirmwareTransfer::Complete);
+  BOOST_CHECK_EQUAL(transfer.progress().framesAcked, kFrames);
+}
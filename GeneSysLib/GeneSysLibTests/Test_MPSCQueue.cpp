@@ -0,0 +1,131 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include "MPSCQueue.h"
+
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+using namespace GeneSysLib;
+
+namespace {
+
+const int kProducers = 4;
+const int kItemsEach = 20000;
+
+// pushes its number and a running count, so the consumer can tell the
+// producers apart and check each one's order
+struct Producer : public QThread {
+  Producer(MPSCQueue<int> &queue, int number)
+      : m_queue(queue), m_number(number) {}
+
+ protected:
+  void run() {
+    for (int i = 0; i < kItemsEach; ++i) {
+      m_queue.push(m_number * kItemsEach + i);
+    }
+  }
+
+ private:
+  MPSCQueue<int> &m_queue;
+  int m_number;
+};
+
+}  // namespace
+
+// Test that items come out in the order they were pushed
+BOOST_AUTO_TEST_CASE(mpsc_queue_fifo) {
+  MPSCQueue<int> queue;
+  BOOST_CHECK(queue.empty());
+
+  int item = -1;
+  BOOST_CHECK(!queue.pop(item));
+  BOOST_CHECK_EQUAL(item, -1);
+
+  for (int i = 0; i < 5; ++i) {
+    queue.push(i);
+  }
+  BOOST_CHECK(!queue.empty());
+
+  for (int i = 0; i < 5; ++i) {
+    BOOST_REQUIRE(queue.pop(item));
+    BOOST_CHECK_EQUAL(item, i);
+  }
+  BOOST_CHECK(queue.empty());
+  BOOST_CHECK(!queue.pop(item));
+}
+
+// Test that items which can only be moved get through, and that the queue
+// frees what is left in it
+BOOST_AUTO_TEST_CASE(mpsc_queue_move_only) {
+  std::weak_ptr<int> left;
+  {
+    MPSCQueue<std::shared_ptr<int> > queue;
+    std::shared_ptr<int> first(new int(1));
+    std::shared_ptr<int> second(new int(2));
+    left = second;
+
+    queue.push(std::move(first));
+    queue.push(std::move(second));
+    BOOST_CHECK(!first);
+
+    std::shared_ptr<int> item;
+    BOOST_REQUIRE(queue.pop(item));
+    BOOST_CHECK_EQUAL(*item, 1);
+    BOOST_CHECK(!left.expired());
+  }
+  BOOST_CHECK(left.expired());
+}
+
+// Test that nothing is lost or reordered with several producers pushing
+// while the consumer pops
+BOOST_AUTO_TEST_CASE(mpsc_queue_producers) {
+  MPSCQueue<int> queue;
+
+  std::vector<std::shared_ptr<Producer> > producers;
+  for (int number = 0; number < kProducers; ++number) {
+    producers.push_back(std::make_shared<Producer>(queue, number));
+  }
+  for (auto &producer : producers) {
+    producer->start();
+  }
+
+  // the next item expected of each producer
+  std::vector<int> next(kProducers, 0);
+  int received = 0;
+  bool ordered = true;
+  int item = 0;
+  while (received < kProducers * kItemsEach) {
+    if (!queue.pop(item)) {
+      bool running = false;
+      for (auto &producer : producers) {
+        running = running || producer->isRunning();
+      }
+      if ((!running) && (queue.empty())) {
+        break;
+      }
+      continue;
+    }
+
+    const int number = item / kItemsEach;
+    ordered = ordered && (item % kItemsEach == next[number]);
+    next[number] = item % kItemsEach + 1;
+    ++received;
+  }
+
+  for (auto &producer : producers) {
+    producer->wait();
+  }
+
+  BOOST_CHECK(ordered);
+  BOOST_CHECK_EQUAL(received, kProducers * kItemsEach);
+  BOOST_CHECK(queue.empty());
+}
@@ -0,0 +1,144 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include "PresetFile.h"
+
+#include <QTemporaryFile>
+
+#ifndef Q_MOC_RUN
+#include <boost/assign/std/vector.hpp>
+#endif
+
+using namespace GeneSysLib;
+using namespace boost::assign;
+
+namespace {
+
+const Byte kPID = 0x05;
+
+PresetFile::Content content(CmdEnum family, PresetFile::Stage stage,
+                            Byte fill) {
+  PresetFile::Content result;
+  result.family = family;
+  result.stage = stage;
+  result.frames += 0xF0, fill, fill, fill, 0xF7;
+  return result;
+}
+
+// MIDI info before the reboot, the device name after it
+std::vector<PresetFile::Content> contents() {
+  std::vector<PresetFile::Content> result;
+  result.push_back(
+      content(Command::RetMIDIInfo, PresetFile::PreReboot, 0x11));
+  result.push_back(content(Command::RetInfo, PresetFile::PostReboot, 0x22));
+  return result;
+}
+
+// a file holding data, removed when the test is done with it
+struct PresetData {
+  explicit PresetData(const Bytes &data) : file() {
+    file.open();
+    file.write((const char *)data.data(), data.size());
+    file.close();
+  }
+
+  QString fileName() const { return file.fileName(); }
+
+  QTemporaryFile file;
+};
+
+}  // namespace
+
+// Test that a built preset opens with its header and section table
+BOOST_AUTO_TEST_CASE(preset_file_build_parse) {
+  PresetData data(PresetFile::build(kPID, "Studio", contents()));
+
+  PresetFile preset(data.fileName());
+  BOOST_REQUIRE(preset.open());
+  BOOST_CHECK_EQUAL(preset.pid(), kPID);
+  BOOST_CHECK_EQUAL(preset.version(), kPresetVersion3);
+  BOOST_CHECK(preset.description() == "Studio");
+  BOOST_CHECK_EQUAL(preset.hash().size(), 16);
+
+  BOOST_REQUIRE_EQUAL(preset.sections().size(), 2u);
+  BOOST_CHECK_EQUAL(preset.sections()[0].family, Command::RetMIDIInfo);
+  BOOST_CHECK_EQUAL(preset.sections()[1].stage, PresetFile::PostReboot);
+  BOOST_CHECK_EQUAL(preset.families().size(), 2u);
+  BOOST_CHECK(preset.hasStage(PresetFile::PreReboot));
+  BOOST_CHECK(preset.hasStage(PresetFile::PostReboot));
+  BOOST_CHECK(preset.verify());
+}
+
+// Test that reading a stage returns only its sections' frames
+BOOST_AUTO_TEST_CASE(preset_file_read_stage) {
+  const auto sections = contents();
+  PresetData data(PresetFile::build(kPID, "", sections));
+
+  PresetFile preset(data.fileName());
+  BOOST_REQUIRE(preset.open());
+
+  Bytes frames;
+  BOOST_CHECK(preset.read(PresetFile::PostReboot, std::set<CmdEnum>(), frames));
+  BOOST_CHECK(frames == sections[1].frames);
+
+  // a family filter leaves out the other sections of the stage
+  std::set<CmdEnum> families;
+  families.insert(Command::RetInfo);
+  frames.clear();
+  BOOST_CHECK(preset.read(PresetFile::PreReboot, families, frames));
+  BOOST_CHECK(frames.empty());
+}
+
+// Test that a damaged section fails alone and a damaged table fails to open
+BOOST_AUTO_TEST_CASE(preset_file_damaged) {
+  const auto sections = contents();
+  Bytes built = PresetFile::build(kPID, "Studio", sections);
+
+  // the last byte belongs to the post-reboot section
+  Bytes damagedSection = built;
+  damagedSection[damagedSection.size() - 2] ^= 0x01;
+  PresetData sectionData(damagedSection);
+
+  PresetFile preset(sectionData.fileName());
+  BOOST_REQUIRE(preset.open());
+  BOOST_CHECK(!preset.verify());
+
+  Bytes frames;
+  BOOST_CHECK(preset.read(PresetFile::PreReboot, std::set<CmdEnum>(), frames));
+  BOOST_CHECK(frames == sections[0].frames);
+  BOOST_CHECK(
+      !preset.read(PresetFile::PostReboot, std::set<CmdEnum>(), frames));
+
+  // the description is covered by the table's hash
+  Bytes damagedTable = built;
+  damagedTable[6] ^= 0x01;
+  PresetData tableData(damagedTable);
+  BOOST_CHECK(!PresetFile(tableData.fileName()).open());
+
+  // a table running past the end of the file
+  Bytes truncated(built.begin(), built.end() - 1);
+  PresetData truncatedData(truncated);
+  BOOST_CHECK(!PresetFile(truncatedData.fileName()).open());
+}
+
+// Test that a version 2 preset opens with its description and no sections
+BOOST_AUTO_TEST_CASE(preset_file_version_2) {
+  Bytes built;
+  built += 0x69, 0x43, 0x4D, kPID, 0x02, 0x03, 'O', 'l', 'd';
+  built += 0xF0, 0x01, 0xF7;
+  built.resize(built.size() + 16, 0x00);
+  PresetData data(built);
+
+  PresetFile preset(data.fileName());
+  BOOST_REQUIRE(preset.open());
+  BOOST_CHECK_EQUAL(preset.version(), 0x02);
+  BOOST_CHECK(preset.description() == "Old");
+  BOOST_CHECK(preset.sections().empty());
+  BOOST_CHECK(!preset.hasStage(PresetFile::PreReboot));
+}
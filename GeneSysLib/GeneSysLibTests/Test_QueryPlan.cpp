@@ -0,0 +1,105 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include "QueryPlan.h"
+
+#include <boost/assign/list_of.hpp>
+
+using namespace GeneSysLib;
+using namespace boost::assign;
+
+namespace {
+
+bool nothingAnswered(CmdEnum) { return false; }
+
+bool deviceAnswered(CmdEnum command) {
+  return (command == Command::RetDevice) ||
+         (command == Command::RetCommandList);
+}
+
+// RetInfo needs RetInfoList, which needs RetCommandList, which needs RetInfo
+std::set<CmdEnum> cyclicDependencies(CmdEnum command) {
+  std::set<CmdEnum> result;
+  switch (command) {
+  case Command::RetInfo:
+    result.insert(Command::RetDevice);
+    result.insert(Command::RetInfoList);
+    break;
+  case Command::RetInfoList:
+    result.insert(Command::RetCommandList);
+    break;
+  case Command::RetCommandList:
+    result.insert(Command::RetInfo);
+    break;
+  default:
+    break;
+  }
+  return result;
+}
+
+}  // namespace
+
+// Test that every prerequisite is planned a level before what needs it
+BOOST_AUTO_TEST_CASE(query_plan_levels) {
+  QueryPlan plan(list_of(Command::RetInfo), &nothingAnswered);
+
+  BOOST_REQUIRE_EQUAL(plan.levelCount(), 4u);
+  BOOST_CHECK(plan.level(0) == QueryPlan::Level(1, Command::RetDevice));
+  BOOST_CHECK(plan.level(1) == QueryPlan::Level(1, Command::RetCommandList));
+  BOOST_CHECK(plan.level(2) == QueryPlan::Level(1, Command::RetInfoList));
+  BOOST_CHECK(plan.level(3) == QueryPlan::Level(1, Command::RetInfo));
+}
+
+// Test that independent families share a level in the order queried
+BOOST_AUTO_TEST_CASE(query_plan_siblings) {
+  QueryPlan plan(list_of(Command::RetResetList)(Command::RetInfoList),
+                 &nothingAnswered);
+
+  BOOST_REQUIRE_EQUAL(plan.levelCount(), 3u);
+  const QueryPlan::Level siblings =
+      list_of(Command::RetResetList)(Command::RetInfoList);
+  BOOST_CHECK(plan.level(2) == siblings);
+}
+
+// Test that answered prerequisites are left out and each family comes once
+BOOST_AUTO_TEST_CASE(query_plan_answered) {
+  QueryPlan plan(list_of(Command::RetInfo)(Command::RetInfoList)(
+                     Command::RetInfo),
+                 &deviceAnswered);
+
+  const QueryPlan::Level order =
+      list_of(Command::RetInfoList)(Command::RetInfo);
+  BOOST_CHECK(plan.order() == order);
+
+  BOOST_CHECK(plan.takeLevel() == QueryPlan::Level(1, Command::RetInfoList));
+  BOOST_CHECK(plan.takeLevel() == QueryPlan::Level(1, Command::RetInfo));
+  BOOST_CHECK(plan.empty());
+  BOOST_CHECK(plan.takeLevel().empty());
+}
+
+// Test that a family depending on itself in the table is planned once
+BOOST_AUTO_TEST_CASE(query_plan_self_dependency) {
+  QueryPlan plan(list_of(Command::RetMIDIInfo), &deviceAnswered);
+
+  BOOST_CHECK(plan.order() == QueryPlan::Level(1, Command::RetMIDIInfo));
+}
+
+// Test that a cycle in the dependencies is broken where it closes and every
+// family is still planned once
+BOOST_AUTO_TEST_CASE(query_plan_cycle_guard) {
+  QueryPlan plan(list_of(Command::RetInfo), &nothingAnswered,
+                 &cyclicDependencies);
+
+  BOOST_REQUIRE_EQUAL(plan.levelCount(), 3u);
+  const QueryPlan::Level first =
+      list_of(Command::RetDevice)(Command::RetCommandList);
+  BOOST_CHECK(plan.level(0) == first);
+  BOOST_CHECK(plan.level(1) == QueryPlan::Level(1, Command::RetInfoList));
+  BOOST_CHECK(plan.level(2) == QueryPlan::Level(1, Command::RetInfo));
+}
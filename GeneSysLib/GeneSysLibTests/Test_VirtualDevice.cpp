@@ -0,0 +1,381 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include "ACK.h"
+#include "CommandList.h"
+#include "Device.h"
+#include "DeviceStateCache.h"
+#include "Generator.h"
+#include "Info.h"
+#include "InfoList.h"
+#include "PresetFile.h"
+#include "QueryPlan.h"
+#include "SysexParser.h"
+#include "VirtualDevice.h"
+#include "WriteCoalescer.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QWaitCondition>
+
+#ifndef Q_MOC_RUN
+#include <boost/assign/list_of.hpp>
+#include <boost/bind.hpp>
+#endif
+
+using namespace GeneSysLib;
+using namespace boost::assign;
+
+namespace {
+
+const Word kPID = 0x0005;
+const SerialNumber kSerial = {{0x00, 0x00, 0x00, 0x00, 0x2A}};
+const int kAnswerTimeout = 2000;  // msec
+
+// QThread::msleep is protected in Qt 4
+struct Sleeper : public QThread {
+  static void msleep(unsigned long msec) { QThread::msleep(msec); }
+};
+
+// what arrived from the device, in order
+struct Answers {
+  Answers() : commands(), store(), deviceName(), errors(0) {}
+
+  void handle(CmdEnum command, DeviceID, Word,
+              const commandData_t &commandData) {
+    QMutexLocker locker(&mutex);
+    if (command == Command::RetInfo) {
+      deviceName = commandData.get<Info>().infoString();
+    } else if ((command == Command::ACK) &&
+               (commandData.get<ACK>().errorCode() != 0)) {
+      ++errors;
+    }
+    if (command != Command::ACK) {
+      store[commandData.key()] = commandData;
+    }
+    commands.push_back(command);
+    arrived.wakeAll();
+  }
+
+  bool has(CmdEnum command) {
+    QMutexLocker locker(&mutex);
+    return std::find(commands.begin(), commands.end(), command) !=
+           commands.end();
+  }
+
+  // false if fewer than count answers came within the timeout
+  bool waitFor(size_t count) {
+    QMutexLocker locker(&mutex);
+    while (commands.size() < count) {
+      if (!arrived.wait(&mutex, kAnswerTimeout)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  QMutex mutex;
+  QWaitCondition arrived;
+  std::vector<CmdEnum> commands;
+  CommandDataStore store;  // the answers, as DeviceInfo keeps them
+  std::string deviceName;
+  int errors;
+};
+
+// a device answering with the header families and its name, talked to
+// through a communicator as the application does
+struct VirtualSetup {
+  VirtualSetup()
+      : deviceID(kPID, kSerial),
+        transID(0),
+        answers(),
+        device(new VirtualDevice()),
+        comm(new Communicator()) {
+    const CmdEnumVector commands = list_of(Command::GetDevice)(
+        Command::GetCommandList)(Command::GetInfoList)(Command::GetInfo)(
+        Command::SetInfo);
+    Bytes records;
+    records += InfoID::DeviceName, 0x20;
+    BytesIter begin = records.begin();
+    BytesIter end = records.end();
+    InfoList infoList;
+    infoList.parse(begin, end);
+
+    device->addAnswer(
+        generate(deviceID, 0, Command::RetDevice, Device(0x01, 0x00, 0x0200)));
+    device->addAnswer(generate(deviceID, 0, Command::RetCommandList,
+                               CommandList(commands)));
+    device->addAnswer(generate(deviceID, 0, Command::RetInfoList, infoList));
+    device->addAnswer(generate(deviceID, 0, Command::RetInfo,
+                               Info(InfoID::DeviceName, "Virtual")));
+    device->setBandwidth(0);
+
+    comm->setTransport(device);
+    comm->openAllInputs();
+    comm->openAllOutputs();
+
+    const Handler handler = boost::bind(&Answers::handle, &answers, _1, _2,
+                                        _3, _4);
+    for (auto command : list_of(Command::RetDevice)(Command::RetCommandList)(
+             Command::RetInfoList)(Command::RetInfo)(Command::ACK)
+             .convert_to_container<CmdEnumVector>()) {
+      comm->registerHandler(command, handler);
+    }
+  }
+
+  // the Get query of a family
+  Bytes query(CmdEnum family) {
+    switch (family) {
+    case Command::RetDevice:
+      return GetDeviceCommand(deviceID, ++transID).sysex();
+    case Command::RetCommandList:
+      return GetCommandListCommand(deviceID, ++transID).sysex();
+    case Command::RetInfoList:
+      return GetInfoListCommand(deviceID, ++transID).sysex();
+    default:
+      return GetInfoCommand(deviceID, ++transID, InfoID::DeviceName).sysex();
+    }
+  }
+
+  // Asks for the device name level by level as DeviceInfo does, a family
+  // the cache answers is not queried. Returns the number of queries sent.
+  int queryName(const DeviceStateCache &cache) {
+    QueryPlan plan(list_of(Command::RetInfo),
+                   boost::bind(&Answers::has, &answers, _1));
+    int sent = 0;
+    while (!plan.empty()) {
+      size_t expected;
+      {
+        QMutexLocker locker(&answers.mutex);
+        expected = answers.commands.size();
+      }
+      for (auto family : plan.takeLevel()) {
+        bool cached;
+        {
+          QMutexLocker locker(&answers.mutex);
+          cached = cache.answer(family, answers.store);
+        }
+        if (!cached) {
+          BOOST_REQUIRE(
+              comm->sendSysex(query(family), RequestPriority::Background));
+          ++expected;
+          ++sent;
+        }
+      }
+      BOOST_REQUIRE(answers.waitFor(expected));
+    }
+    return sent;
+  }
+
+  // forgets what the device answered, as a new connection would
+  void disconnect() {
+    QMutexLocker locker(&answers.mutex);
+    answers.commands.clear();
+    answers.store.clear();
+    answers.deviceName.clear();
+  }
+
+  DeviceID deviceID;
+  Word transID;
+  Answers answers;  // outlives the communicator calling into it
+  VirtualDevicePtr device;
+  CommPtr comm;
+};
+
+bool isInfo(CmdEnum command) { return command == Command::RetInfo; }
+
+}  // namespace
+
+// Test that a query planned over the dependencies is answered level by level
+BOOST_AUTO_TEST_CASE(virtual_device_query_plan) {
+  VirtualSetup setup;
+
+  QueryPlan plan(list_of(Command::RetInfo),
+                 boost::bind(&Answers::has, &setup.answers, _1));
+  BOOST_REQUIRE_EQUAL(plan.levelCount(), 4u);
+
+  size_t expected = 0;
+  while (!plan.empty()) {
+    for (auto family : plan.takeLevel()) {
+      BOOST_REQUIRE(setup.comm->sendSysex(setup.query(family),
+                                          RequestPriority::Background));
+      ++expected;
+    }
+    // the next level is only asked for once this one is answered
+    BOOST_REQUIRE(setup.answers.waitFor(expected));
+  }
+
+  const std::vector<CmdEnum> order = list_of(Command::RetDevice)(
+      Command::RetCommandList)(Command::RetInfoList)(Command::RetInfo);
+  QMutexLocker locker(&setup.answers.mutex);
+  BOOST_CHECK(setup.answers.commands == order);
+  BOOST_CHECK_EQUAL(setup.answers.deviceName, "Virtual");
+}
+
+// Test that restoring a preset writes its settings to the device, which then
+// answers with them
+BOOST_AUTO_TEST_CASE(virtual_device_restore) {
+  VirtualSetup setup;
+
+  PresetFile::Content content;
+  content.family = Command::RetInfo;
+  content.stage = PresetFile::PreReboot;
+  content.frames = generate(DeviceID(kPID), 0, Command::RetInfo,
+                            Info(InfoID::DeviceName, "Restored"));
+  const Bytes built =
+      PresetFile::build((Byte)kPID, "Restore", std::vector<PresetFile::Content>(
+                                                    1, content));
+
+  QTemporaryFile file;
+  BOOST_REQUIRE(file.open());
+  file.write((const char *)built.data(), built.size());
+  file.close();
+
+  PresetFile preset(file.fileName());
+  BOOST_REQUIRE(preset.open());
+  BOOST_REQUIRE_EQUAL(preset.pid(), (Byte)kPID);
+  Bytes frames;
+  BOOST_REQUIRE(
+      preset.read(PresetFile::PreReboot, std::set<CmdEnum>(), frames));
+
+  // each stored answer goes back to the device as the write of its setting
+  DeviceID deviceID;
+  Word transID;
+  CmdEnum command;
+  commandData_t commandData;
+  BOOST_REQUIRE(SysexParser::decode(frames.begin(), frames.end(), deviceID,
+                                    transID, command, commandData));
+  BOOST_REQUIRE(setup.comm->sendSysex(
+      generate(setup.deviceID, ++setup.transID,
+               (CmdEnum)(command | WRITE_BIT), commandData),
+      RequestPriority::Background));
+  BOOST_REQUIRE(setup.answers.waitFor(1));
+  BOOST_CHECK(setup.answers.has(Command::ACK));
+
+  BOOST_REQUIRE(setup.comm->sendSysex(setup.query(Command::RetInfo),
+                                      RequestPriority::Background));
+  BOOST_REQUIRE(setup.answers.waitFor(2));
+
+  QMutexLocker locker(&setup.answers.mutex);
+  BOOST_CHECK_EQUAL(setup.answers.errors, 0);
+  BOOST_CHECK_EQUAL(setup.answers.deviceName, "Restored");
+}
+
+// Test that a coalesced write whose ACK was lost is not sent again by the
+// communicator over the newer value that replaced it
+BOOST_AUTO_TEST_CASE(virtual_device_coalesced_write_lost_ack) {
+  VirtualSetup setup;
+  setup.comm->setRequestTimeout(200);
+
+  WriteCoalescer writes(setup.comm);
+  writes.setTimeout(50);
+
+  const Info stale(InfoID::DeviceName, "Stale");
+  const Info latest(InfoID::DeviceName, "Latest");
+
+  // the device takes the first value but its ACK is lost
+  setup.device->setDropRate(1.0);
+  writes.write(stale.key(),
+               generate(setup.deviceID, 0, Command::SetInfo, stale));
+  Sleeper::msleep(30);
+  setup.device->setDropRate(0.0);
+
+  // given up on, so the newer value goes out at once
+  Sleeper::msleep(40);
+  writes.write(latest.key(),
+               generate(setup.deviceID, 0, Command::SetInfo, latest));
+
+  // well past the communicator's retry of the first write
+  QElapsedTimer clock;
+  clock.start();
+  while (clock.elapsed() < 600) {
+    writes.poll();
+    Sleeper::msleep(10);
+  }
+  BOOST_CHECK(!writes.pending());
+
+  size_t count;
+  {
+    QMutexLocker locker(&setup.answers.mutex);
+    count = setup.answers.commands.size();
+  }
+  BOOST_REQUIRE(setup.comm->sendSysex(setup.query(Command::RetInfo),
+                                      RequestPriority::Background));
+  BOOST_REQUIRE(setup.answers.waitFor(count + 1));
+
+  QMutexLocker locker(&setup.answers.mutex);
+  BOOST_CHECK_EQUAL(setup.answers.errors, 0);
+  BOOST_CHECK_EQUAL(setup.answers.deviceName, "Latest");
+}
+
+// Test that a full Interactive queue drops its oldest request for the newest
+// and that clearing one sender's requests leaves the others alone
+BOOST_AUTO_TEST_CASE(virtual_device_interactive_queue_bounded) {
+  VirtualSetup setup;
+  setup.device->setDropRate(1.0);
+  setup.comm->setWindowSize(1);
+
+  // one in the window, the rest queued
+  for (int i = 0; i < 100; ++i) {
+    BOOST_CHECK(setup.comm->sendSysex(setup.query(Command::RetInfo)));
+  }
+  const unsigned int interactive =
+      setup.comm->pendingCount(RequestPriority::Interactive);
+  BOOST_CHECK_GT(interactive, 1u);
+  BOOST_CHECK_LT(interactive, 100u);
+
+  const Word background = setup.transID + 1;
+  BOOST_REQUIRE(setup.comm->sendSysex(setup.query(Command::RetInfo),
+                                      RequestPriority::Background));
+  BOOST_CHECK_EQUAL(setup.comm->pendingCount(RequestPriority::Background), 1u);
+
+  setup.comm->clearInFlight(RequestPriority::Background, background);
+  BOOST_CHECK_EQUAL(setup.comm->pendingCount(RequestPriority::Background), 0u);
+  BOOST_CHECK_EQUAL(setup.comm->pendingCount(RequestPriority::Interactive),
+                    interactive);
+}
+
+// Test that a family answered from the device state cache is not queried,
+// and that it is again once an answer it was built on has changed
+BOOST_AUTO_TEST_CASE(virtual_device_cache_hit_skips_query) {
+  VirtualSetup setup;
+
+  DeviceStateCache cache;
+  BOOST_CHECK_EQUAL(setup.queryName(cache), 4);
+
+  Bytes file;
+  {
+    QMutexLocker locker(&setup.answers.mutex);
+    file = DeviceStateCache::build(setup.deviceID, "1.0",
+                                   setup.answers.store, &isInfo);
+  }
+  BOOST_CHECK(!cache.load(file, setup.deviceID, "1.1", &isInfo));
+  BOOST_REQUIRE(cache.load(file, setup.deviceID, "1.0", &isInfo));
+
+  setup.disconnect();
+  BOOST_CHECK_EQUAL(setup.queryName(cache), 3);
+  BOOST_CHECK(!setup.answers.has(Command::RetInfo));
+  {
+    QMutexLocker locker(&setup.answers.mutex);
+    BOOST_REQUIRE_EQUAL(setup.answers.store.count(Command::RetInfo), 1u);
+    setup.answers.store.for_each(
+        Command::RetInfo, [](const commandData_t &data) {
+          BOOST_CHECK_EQUAL(data.get<Info>().infoString(), "Virtual");
+        });
+  }
+
+  // the device now reports another maximum message length
+  setup.device->addAnswer(generate(setup.deviceID, 0, Command::RetDevice,
+                                   Device(0x01, 0x00, 0x0300)));
+  setup.disconnect();
+  BOOST_CHECK_EQUAL(setup.queryName(cache), 4);
+  BOOST_CHECK(setup.answers.has(Command::RetInfo));
+}
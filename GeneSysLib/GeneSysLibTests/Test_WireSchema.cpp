@@ -0,0 +1,159 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include "WireSchema.h"
+#include "MIDIInfo.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/assign/std/vector.hpp>
+#endif
+
+using namespace GeneSysLib;
+using namespace boost::assign;
+
+namespace {
+
+// one field of each codec and of each kind of member
+struct Sample {
+  struct Layout;
+  struct Block;
+
+  Sample() : flags(0), count(0), wide(0), name(0) {}
+
+  Byte flags;
+  Word count;
+  Word wide;
+  rwByte name;
+};
+
+struct Sample::Layout
+    : Wire::Schema<Wire::Version<0x02>, WIRE_FIELD(Byte, Sample, flags),
+                   WIRE_FIELD(MidiWord, Sample, count),
+                   WIRE_FIELD(MidiWord3, Sample, wide),
+                   WIRE_FIELD(MidiByte, Sample, name)> {};
+
+struct Sample::Block {
+  struct Layout;
+
+  Block() : jack(0), port() {}
+
+  Byte jack;
+  roWord port;
+};
+
+struct Sample::Block::Layout
+    : Wire::Schema<WIRE_FIELD(MidiByte, Sample::Block, jack),
+                   WIRE_FIELD(MidiWord, Sample::Block, port)> {};
+
+Sample sample() {
+  Sample result;
+  result.flags = 0x85;
+  result.count = 0x1234;
+  result.wide = 0xBEEF;
+  result.name(0x41);
+  return result;
+}
+
+}  // namespace
+
+// Test that the fields are laid out in order with their codecs
+BOOST_AUTO_TEST_CASE(wire_schema_generate) {
+  BOOST_CHECK_EQUAL((int)Sample::Layout::size, 8);
+
+  Bytes result;
+  result += 0x7E;
+  Sample::Layout::generate(sample(), result);
+
+  Bytes expected;
+  expected += 0x7E, 0x02, 0x85, 0x24, 0x34, 0x02, 0x7D, 0x6F, 0x41;
+  BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), expected.begin(),
+                                expected.end());
+}
+
+// Test that parsing what was generated gives back every field
+BOOST_AUTO_TEST_CASE(wire_schema_round_trip) {
+  Bytes data;
+  Sample::Layout::generate(sample(), data);
+  data += 0x55;
+
+  Sample parsed;
+  BytesIter begin = data.begin();
+  BOOST_REQUIRE(Sample::Layout::parse(parsed, begin, data.end()));
+  BOOST_CHECK(begin == data.end() - 1);
+  BOOST_CHECK_EQUAL(parsed.flags, 0x85);
+  BOOST_CHECK_EQUAL(parsed.count, 0x1234);
+  BOOST_CHECK_EQUAL(parsed.wide, 0xBEEF);
+  BOOST_CHECK_EQUAL(parsed.name(), 0x41);
+}
+
+// Test that a message one byte short, or of another version, is left alone
+BOOST_AUTO_TEST_CASE(wire_schema_short_message) {
+  Bytes data;
+  Sample::Layout::generate(sample(), data);
+
+  Bytes shortData(data.begin(), data.end() - 1);
+  Sample parsed;
+  BytesIter begin = shortData.begin();
+  BOOST_CHECK(!Sample::Layout::parse(parsed, begin, shortData.end()));
+  BOOST_CHECK(begin == shortData.begin());
+  BOOST_CHECK_EQUAL(parsed.count, 0);
+
+  data[0] = 0x01;
+  begin = data.begin();
+  BOOST_CHECK(!Sample::Layout::parse(parsed, begin, data.end()));
+  BOOST_CHECK(begin == data.begin());
+  BOOST_CHECK_EQUAL(parsed.flags, 0);
+}
+
+// Test that blocks are taken all or none
+BOOST_AUTO_TEST_CASE(wire_schema_blocks) {
+  Sample::Block block;
+  block.jack = 0x03;
+  block.port = roWord(0x0101);
+
+  Bytes data;
+  Wire::generateBlocks<Sample::Block::Layout>(
+      std::vector<Sample::Block>(3, block), data);
+  BOOST_CHECK_EQUAL(data.size(), 9u);
+
+  std::vector<Sample::Block> blocks;
+  BytesIter begin = data.begin();
+  BOOST_REQUIRE(Wire::parseBlocks<Sample::Block::Layout>(blocks, 3, begin,
+                                                         data.end()));
+  BOOST_CHECK(begin == data.end());
+  BOOST_REQUIRE_EQUAL(blocks.size(), 3u);
+  BOOST_CHECK_EQUAL(blocks[2].jack, 0x03);
+  BOOST_CHECK_EQUAL(blocks[2].port(), 0x0101);
+
+  begin = data.begin();
+  BOOST_CHECK(!Wire::parseBlocks<Sample::Block::Layout>(blocks, 4, begin,
+                                                        data.end()));
+  BOOST_CHECK(begin == data.begin());
+  BOOST_CHECK(blocks.empty());
+}
+
+// Test that a command declared with a schema parses what it generates
+BOOST_AUTO_TEST_CASE(wire_schema_midi_info) {
+  const MIDIInfo info(0x0105, 0x0003, 2, 1, 4, 1, 16, 8, 4, 12, 8, 0x03);
+  Bytes data = info.generate();
+  BOOST_CHECK_EQUAL(data.size(), 15u);
+
+  MIDIInfo parsed;
+  BytesIter begin = data.begin();
+  BytesIter end = data.end();
+  parsed.parse(begin, end);
+  BOOST_CHECK(begin == end);
+  BOOST_CHECK_EQUAL(parsed.numMIDIPorts(), 0x0105);
+  BOOST_CHECK_EQUAL(parsed.hostMIDIPort(), 0x0003);
+  BOOST_CHECK_EQUAL(parsed.numUSBHostJacks(), 4);
+  BOOST_CHECK_EQUAL(parsed.numRTPMIDIConnectionsPerSession(), 12);
+  BOOST_CHECK_EQUAL(parsed.maxPortsOnMultiPortUSBDevice(), 8);
+  BOOST_CHECK_EQUAL(parsed.globalMIDIFlags(), 0x03);
+  BOOST_CHECK(parsed.generate() == data);
+}
@@ -8,9 +8,25 @@
 #include "stdafx.h"
 #include "MIDIInfo.h"
 #include "Generator.h"
+#include "WireSchema.h"
 
 namespace GeneSysLib {
 
+struct MIDIInfo::Layout
+    : Wire::Schema<
+          Wire::Version<0x01>, WIRE_FIELD(MidiWord, MIDIInfo, numMIDIPorts),
+          WIRE_FIELD(MidiWord, MIDIInfo, hostMIDIPort),
+          WIRE_FIELD(Byte, MIDIInfo, numDINPairs),
+          WIRE_FIELD(Byte, MIDIInfo, numUSBDeviceJacks),
+          WIRE_FIELD(Byte, MIDIInfo, numUSBHostJacks),
+          WIRE_FIELD(Byte, MIDIInfo, numEthernetJacks),
+          WIRE_FIELD(Byte, MIDIInfo, numUSBMIDIPortPerDeviceJack),
+          WIRE_FIELD(Byte, MIDIInfo, numUSBMIDIPortPerHostJack),
+          WIRE_FIELD(Byte, MIDIInfo, numRTPMIDISessionsPerEthernetJack),
+          WIRE_FIELD(Byte, MIDIInfo, numRTPMIDIConnectionsPerSession),
+          WIRE_FIELD(Byte, MIDIInfo, m_globalMIDIFlags),
+          WIRE_FIELD(Byte, MIDIInfo, maxPortsOnMultiPortUSBDevice)> {};
+
 CmdEnum MIDIInfo::retCommand() { return Command::RetMIDIInfo; }
 CmdEnum MIDIInfo::setCommand() { return Command::SetMIDIInfo; }
 
@@ -68,40 +84,12 @@ const commandDataKey_t MIDIInfo::key() const {
 
 Bytes MIDIInfo::generate() const {
   Bytes result;
-
-  result += versionNumber();
-  appendMidiWord(result, numMIDIPorts());
-  appendMidiWord(result, hostMIDIPort());
-  result += numDINPairs();
-  result += numUSBDeviceJacks();
-  result += numUSBHostJacks();
-  result += numEthernetJacks();
-  result += numUSBMIDIPortPerDeviceJack();
-  result += numUSBMIDIPortPerHostJack();
-  result += numRTPMIDISessionsPerEthernetJack();
-  result += numRTPMIDIConnectionsPerSession();
-  result += m_globalMIDIFlags;
-  result += maxPortsOnMultiPortUSBDevice();
-
+  Layout::generate(*this, result);
   return result;
 }
 
 void MIDIInfo::parse(BytesIter &begin, BytesIter &end) {
-  auto version = nextMidiByte(begin, end);
-  if (version == versionNumber()) {
-    numMIDIPorts = roWord(nextMidiWord(begin, end));
-    hostMIDIPort = roWord(nextMidiWord(begin, end));
-    numDINPairs = roByte(nextMidiByte(begin, end));
-    numUSBDeviceJacks = roByte(nextMidiByte(begin, end));
-    numUSBHostJacks = roByte(nextMidiByte(begin, end));
-    numEthernetJacks = roByte(nextMidiByte(begin, end));
-    numUSBMIDIPortPerDeviceJack = roByte(nextMidiByte(begin, end));
-    numUSBMIDIPortPerHostJack = roByte(nextMidiByte(begin, end));
-    numRTPMIDISessionsPerEthernetJack = roByte(nextMidiByte(begin, end));
-    numRTPMIDIConnectionsPerSession = roByte(nextMidiByte(begin, end));
-    m_globalMIDIFlags = nextMidiByte(begin, end);
-    maxPortsOnMultiPortUSBDevice = rwByte(nextMidiByte(begin, end));
-  }
+  Layout::parse(*this, begin, end);
 }
 
 Byte MIDIInfo::versionNumber() const { return 0x01; }
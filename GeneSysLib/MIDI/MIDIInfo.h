@@ -60,6 +60,8 @@ struct MIDIInfo {
   void setFlag(GlobalMIDIFlags::Enum globalFlag, bool value);
 
  private:
+  struct Layout;
+
   Word m_numMIDIPorts;
   Byte m_globalMIDIFlags;
 };  // struct MIDIInfo
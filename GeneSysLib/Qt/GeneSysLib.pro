@@ -67,15 +67,23 @@ SOURCES += \
 #    ../Base/ByteCommandData.cpp \
 #    ../Base/BytesCommandData.cpp \
 #    ../Base/CommandData.cpp \
+    ../Base/CommandDataStore.cpp \
     ../Base/CommandDefines.cpp \
     ../Base/CommandList.cpp \
+    ../Base/CommandMetrics.cpp \
     ../Base/Communicator.cpp \
+    ../Base/DeviceStateCache.cpp \
+    ../Base/FirmwareTransfer.cpp \
     ../Base/Generator.cpp \
     ../Base/Lookup.cpp \
     ../Base/MyAlgorithms.cpp \
+    ../Base/QueryPlan.cpp \
     ../Base/stdafx.cpp \
     ../Base/SysexParser.cpp \
+    ../Base/SysexFramer.cpp \
     ../Base/TimerThread.cpp \
+    ../Base/VirtualDevice.cpp \
+    ../Base/WriteCoalescer.cpp \
     ../Device/Device.cpp \
     ../Device/DeviceID.cpp \
     ../Device/EthernetPortInfo.cpp \
@@ -130,6 +138,7 @@ HEADERS += \
     ../Audio/ChannelBitmapBit.h \
     ../Audio/ChannelFilterStatusBit.h \
     ../Audio/HostType.h \
+    ../Audio/MeterBlocks.h \
     ../Audio/PortSpecificOptionsBit.h \
     ../Audio/SampleRateCode.h \
     ../Base/ACK.h \
@@ -138,22 +147,33 @@ HEADERS += \
     ../Base/BytesCommandData.h \
     ../Base/CommandData.h \
     ../Base/CommandDataKey.h \
+    ../Base/CommandDataStore.h \
     ../Base/CommandDefines.h \
     ../Base/CommandList.h \
+    ../Base/CommandMetrics.h \
     ../Base/Communicator.h \
     ../Base/ErrorCode.h \
+    ../Base/DeviceStateCache.h \
+    ../Base/FirmwareTransfer.h \
     ../Base/Generator.h \
     ../Base/ICRunOnMain.h \
     ../Base/LibTypes.h \
     ../Base/Lookup.h \
+    ../Base/MPSCQueue.h \
     ../Base/MyAlgorithms.h \
     ../Base/PortType.h \
+    ../Base/QueryPlan.h \
     ../Base/property.h \
     ../Base/stdafx.h \
     ../Base/StreamHelpers.h \
     ../Base/SysexCommand.h \
     ../Base/SysexParser.h \
+    ../Base/SysexFramer.h \
     ../Base/TimerThread.h \
+    ../Base/Transport.h \
+    ../Base/VirtualDevice.h \
+    ../Base/WireSchema.h \
+    ../Base/WriteCoalescer.h \
     ../Device/BootMode.h \
     ../Device/Device.h \
     ../Device/DeviceID.h \
@@ -11,7 +11,7 @@
 #include "AudioControlDetail.h"
 #include "AudioControlDetailValue.h"
 #include "AudioControlDetailValueTypes.h"
-#include "AudioPortMeterValue.h"
+#include "MeterPoller.h"
 
 using namespace std;
 using namespace GeneSysLib;
@@ -86,18 +86,18 @@ void AudioControlFeatureSource::stereoLink(Byte channelID, bool value) {
   AudioControlDetailValue &audioControlDetailValue =
       device->get<AudioControlDetailValue>(audioPortID, controllerNumber,
                                            channelID);
-  audioControlDetailValue.feature().stereoLink(value);
-  device->send<SetAudioControlDetailValueCommand>(audioControlDetailValue);
-
   // and the partner!
-
   AudioControlDetailValue &audioControlDetailValue2 =
       device->get<AudioControlDetailValue>(audioPortID, controllerNumber,
                                            channelID + 1);
+  const vector<commandData_t> before = {audioControlDetailValue,
+                                        audioControlDetailValue2};
+
+  audioControlDetailValue.feature().stereoLink(value);
   audioControlDetailValue2.feature().stereoLink(value);
   audioControlDetailValue2.feature().volume(audioControlDetailValue.feature().volume());
   audioControlDetailValue2.feature().mute(audioControlDetailValue.feature().mute());
-  device->send<SetAudioControlDetailValueCommand>(audioControlDetailValue2);
+  device->writeTogether(before);
 }
 
 // High impedence methods
@@ -125,7 +125,7 @@ void AudioControlFeatureSource::highImpedance(Byte channelID, bool value) {
       device->get<AudioControlDetailValue>(audioPortID, controllerNumber,
                                            channelID);
   audioControlDetailValue.feature().highImpedance(value);
-  device->send<SetAudioControlDetailValueCommand>(audioControlDetailValue);
+  device->writeNow<SetAudioControlDetailValueCommand>(audioControlDetailValue);
 }
 
 // Phantom power methods
@@ -153,7 +153,7 @@ void AudioControlFeatureSource::phantomPower(Byte channelID, bool value) {
       device->get<AudioControlDetailValue>(audioPortID, controllerNumber,
                                            channelID);
   audioControlDetailValue.feature().phantomPower(value);
-  device->send<SetAudioControlDetailValueCommand>(audioControlDetailValue);
+  device->writeNow<SetAudioControlDetailValueCommand>(audioControlDetailValue);
 }
 
 // Mute methods
@@ -180,15 +180,22 @@ void AudioControlFeatureSource::mute(Byte channelID, bool value) {
   AudioControlDetailValue &audioControlDetailValue =
       device->get<AudioControlDetailValue>(audioPortID, controllerNumber,
                                            channelID);
-  audioControlDetailValue.feature().mute(value);
-  device->send<SetAudioControlDetailValueCommand>(audioControlDetailValue);
 
   if (stereoLink(channelID)) {
-    AudioControlDetailValue &audioControlDetailValue =
+    // both channels or neither
+    AudioControlDetailValue &audioControlDetailValue2 =
         device->get<AudioControlDetailValue>(audioPortID, controllerNumber,
                                              channelID + 1);
+    const vector<commandData_t> before = {audioControlDetailValue,
+                                          audioControlDetailValue2};
+
     audioControlDetailValue.feature().mute(value);
-    device->send<SetAudioControlDetailValueCommand>(audioControlDetailValue);
+    audioControlDetailValue2.feature().mute(value);
+    device->writeTogether(before);
+  } else {
+    audioControlDetailValue.feature().mute(value);
+    device->writeNow<SetAudioControlDetailValueCommand>(
+        audioControlDetailValue);
   }
 }
 
@@ -277,7 +284,7 @@ void AudioControlFeatureSource::volumeCurrent(Byte channelID, int16_t value) {
 
   if (audioControlDetailValue.feature().isVolumeIncluded()) {
     audioControlDetailValue.feature().volume(value);
-    device->send<SetAudioControlDetailValueCommand>(audioControlDetailValue);
+    device->write<SetAudioControlDetailValueCommand>(audioControlDetailValue);
   }
 
   // and partner
@@ -290,18 +297,14 @@ void AudioControlFeatureSource::volumeCurrent(Byte channelID, int16_t value) {
 
     if (audioControlDetailValue.feature().isVolumeIncluded()) {
       audioControlDetailValue.feature().volume(value);
-      device->send<SetAudioControlDetailValueCommand>(audioControlDetailValue);
+      device->write<SetAudioControlDetailValueCommand>(audioControlDetailValue);
     }
   }
 }
 
 int16_t AudioControlFeatureSource::meterCurrent(Byte channelID) {
-  if (device->contains(AudioPortMeterValue::queryKey(audioPortID))) {
-    ////printf("Contains <AudioPortMeterValue>\n");
-    const AudioPortMeterValue &audioPortMeterValues = device->get<AudioPortMeterValue>(audioPortID);
-    return audioPortMeterValues.meterValue(channelType(channelID) - 1, channelNumber(channelID) - 1);
-  }
-  return 0;
+  return device->meterPoller()->audioPortMeter(
+      audioPortID, channelType(channelID) - 1, channelNumber(channelID) - 1);
 }
 
 int16_t AudioControlFeatureSource::trimCurrent(Byte channelID) const {
@@ -328,6 +331,6 @@ void AudioControlFeatureSource::trimCurrent(Byte channelID, int16_t value) {
 
   if (audioControlDetailValue.feature().isVolumeIncluded()) {
     audioControlDetailValue.feature().trim(value);
-    device->send<SetAudioControlDetailValueCommand>(audioControlDetailValue);
+    device->write<SetAudioControlDetailValueCommand>(audioControlDetailValue);
   }
 }
@@ -153,6 +153,11 @@ void AudioFeatureControlWidget::panDialChanged(int value) {
   }
 }
 
+void AudioFeatureControlWidget::controlReleased() {
+  // send the final value now instead of when the device catches up
+  device->flushWrites();
+}
+
 void AudioFeatureControlWidget::volumeSliderChanged(int value) {
   if (audioFeatureSource->channelType(channelID) == 2 && value == volumeSlider->minimum()) {
     value = 0x8000;
@@ -544,6 +549,7 @@ void AudioFeatureControlWidget::buildPanDial() {
     updatePanValue();
     connect(panDial, SIGNAL(valueChanged(int)), this,
             SLOT(panDialChanged(int)));
+    connect(panDial, SIGNAL(sliderReleased()), this, SLOT(controlReleased()));
   }
 }
 
@@ -767,6 +773,8 @@ void AudioFeatureControlWidget::buildVolumeSlider() {
 
   connect(volumeSlider, SIGNAL(valueChanged(int)), this,
           SLOT(volumeSliderChanged(int)));
+  connect(volumeSlider, SIGNAL(sliderReleased()), this,
+          SLOT(controlReleased()));
 }
 
 void AudioFeatureControlWidget::buildMutePushButton() {
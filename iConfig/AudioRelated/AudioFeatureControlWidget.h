@@ -73,6 +73,7 @@ class AudioFeatureControlWidget : public QWidget, public IRefreshWidget, IQClick
 private slots:
   void volumeSliderChanged(int state);
   void panDialChanged(int state);
+  void controlReleased();
   void muteStateChanged(bool state);
   void stereoLinkStateChanged(bool state);
   void phantomPowerStateChanged(bool state);
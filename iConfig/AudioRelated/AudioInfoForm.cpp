@@ -882,7 +882,7 @@ void AudioInfoForm::queryCompleted(Screen sc, CommandQList) {
 }
 
 void AudioInfoForm::ackCallback(CmdEnum, DeviceID, Word,
-                                commandData_t _commandData) {
+                                const commandData_t &_commandData) {
   const auto &ackData = _commandData.get<ACK>();
 
   switch (ackData.commandID()) {
@@ -918,7 +918,10 @@ void AudioInfoForm::ackCallback(CmdEnum, DeviceID, Word,
           auto sysexBytes = sysexMessages.front();
           sysexMessages.pop();
 
-          device->send(sysexBytes);
+          if (!device->send(sysexBytes)) {
+            emit updateMessage(tr("Error committing changes."),
+                               kMessageTimeout);
+          }
         }
       } else {
         emit updateMessage(tr("Error committing changes."), kMessageTimeout);
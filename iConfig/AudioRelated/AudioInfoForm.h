@@ -148,7 +148,7 @@ signals:
   void addClockSourceV2(QTreeWidgetItem* treeItem);
 
   void ackCallback(GeneSysLib::CmdEnum command, GeneSysLib::DeviceID deviceID,
-                   Word transID, GeneSysLib::commandData_t commandData);
+                   Word transID, const GeneSysLib::commandData_t &commandData);
 
   //////////////////////////////////////////////////////////////////////////////
   /// properties
@@ -209,7 +209,7 @@ void AudioPatchbayForm::addPortComboBox(QTreeWidgetItem *parent,
 
 // update the status bar on successful writes to the patchbay
 void AudioPatchbayForm::ackCallback(CmdEnum, DeviceID, Word,
-                                    commandData_t _commandData) {
+                                    const commandData_t &_commandData) {
   const auto &ackData = _commandData.get<ACK>();
 
   if ((ackData.commandID() == Command::SetAudioPortPatchbay) &&
@@ -56,7 +56,7 @@ class AudioPatchbayForm : public RefreshObject {
                        const QStringList &outputOptions, int inChannel,
                        int &comboBoxID);
   void ackCallback(GeneSysLib::CmdEnum command, GeneSysLib::DeviceID deviceID,
-                   Word transID, GeneSysLib::commandData_t commandData);
+                   Word transID, const GeneSysLib::commandData_t &commandData);
   QStringList generateOutputOptions(GeneSysLib::AudioCfgInfo &audioCfgInfo);
 
   bool eventFilter(QObject *obj, QEvent *event);
@@ -46,11 +46,15 @@
 #include "MIDIPortFilter.h"
 #include "MIDIPortRemap.h"
 #include "MIDIPortRoute.h"
+#include "MeterPoller.h"
 #include "MyAlgorithms.h"
 #include "RTPMIDIConnectionDetail.h"
 #include "ResetList.h"
 #include "SaveRestoreList.h"
+#include "SysexParser.h"
 #include "USBHostMIDIDeviceDetail.h"
+#include "WriteCoalescer.h"
+#include "Presets/PresetFile.h"
 
 #ifndef Q_MOC_RUN
 #include <boost/bind.hpp>
@@ -63,8 +67,14 @@
 #include <numeric>
 #include <QObject>
 #include <QCryptographicHash>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QMetaType>
+#include <QRegExp>
 #include <QSet>
+#include <QTimer>
 
 using namespace GeneSysLib;
 using namespace MyAlgorithms;
@@ -81,6 +91,7 @@ QMutex currentQueryMutex;
 QMutex pendingQueriesMutex;
 QMutex queriedItemsMutex;
 QMutex attemptedQueriesMutex;
+QMutex cacheMutex;
 
 DeviceInfo::DeviceInfo(CommPtr _comm, QObject* _parent)
     : QObject(_parent),
@@ -91,7 +102,13 @@ DeviceInfo::DeviceInfo(CommPtr _comm, QObject* _parent)
       queryScreen(UnknownScreen),
       currentQuery(),
       pendingQueries(),
-      comm(_comm) {
+      sysexMessages(),
+      restoring(false),
+      comm(_comm),
+      cacheLoaded(false),
+      meters(new MeterPoller(_comm)),
+      writes(),
+      writeTimer(0) {
   Q_ASSERT(_comm);
   registerAllHandlers();
 
@@ -115,7 +132,13 @@ DeviceInfo::DeviceInfo(CommPtr _comm, DeviceID _deviceID, Word _transID,
       queryScreen(UnknownScreen),
       currentQuery(),
       pendingQueries(),
-      comm(_comm) {
+      sysexMessages(),
+      restoring(false),
+      comm(_comm),
+      cacheLoaded(false),
+      meters(new MeterPoller(_comm)),
+      writes(),
+      writeTimer(0) {
   Q_ASSERT(_comm);
   registerAllHandlers();
 
@@ -136,6 +159,10 @@ DeviceInfo::~DeviceInfo() {
   }
   sysexMutex.unlock();
   unRegisterHandlerAllHandlers();
+
+  // the last value of a control being moved still reaches the device
+  flushWrites();
+  delete writeTimer;
 }
 
 pair<DeviceID, Word> DeviceInfo::getInfo() const {
@@ -165,7 +192,7 @@ bool DeviceInfo::startQuery(Screen screen, const CommandQList& query) {
 
     // Queries before
     if (currentQuery.empty()) {
-      currentQuery = query.toStdList();
+      currentQuery = planQuery(query);
     }
     else {
       pendingQueriesMutex.lock();
@@ -218,6 +245,259 @@ bool DeviceInfo::rereadMeters() {
   return startQuery(Screen::RereadMeters, query);
 }
 
+MeterPoller *DeviceInfo::meterPoller() const { return meters.get(); }
+
+void DeviceInfo::startMeterPolling() {
+  const auto& commandList =
+      contains<CommandList>() ? get<CommandList>() : CommandList();
+
+  const auto& audioGlobalParm =
+      contains<AudioGlobalParm>() ? get<AudioGlobalParm>() : AudioGlobalParm();
+
+  const auto& mixerPortParm =
+      contains<MixerPortParm>() ? get<MixerPortParm>() : MixerPortParm();
+
+  // same requests rereadMeters() queues, sent with the meter transID
+  std::vector<MeterPoller::Request> requests;
+
+  if (commandList.contains(Command::GetAudioDeviceParm)) {
+    for (Word audioPortID = 1; audioPortID <= audioGlobalParm.numAudioPorts(); ++audioPortID) {
+      MeterPoller::Request request;
+      request.key = AudioPortMeterValue::queryKey(audioPortID);
+      request.sysex = GetAudioPortMeterValueCommand(deviceID, kMeterTransID,
+                                                    audioPortID).sysex();
+      requests.push_back(request);
+    }
+  }
+
+  if (commandList.contains(Command::GetMixerInputControlValue)) {
+    for (Byte audioPortID = 1; audioPortID <= mixerPortParm.audioPortMixerBlockCount(); ++audioPortID) {
+      for (Byte mixerOutputNumber = 1; mixerOutputNumber <= mixerPortParm.audioPortMixerBlocks.at(audioPortID - 1).numOutputs(); ++mixerOutputNumber) {
+        MeterPoller::Request request;
+        request.key = MixerMeterValue::queryKey(audioPortID, mixerOutputNumber);
+        request.sysex = GetMixerMeterValueCommand(
+            deviceID, kMeterTransID, audioPortID, mixerOutputNumber).sysex();
+        requests.push_back(request);
+      }
+    }
+  }
+
+  meters->startPolling(deviceID, requests);
+}
+
+void DeviceInfo::stopMeterPolling() { meters->stopPolling(); }
+
+QString DeviceInfo::cacheFileName() const {
+  if (!containsInfo(InfoID::FirmwareVersion)) {
+    return QString();
+  }
+
+  QString serial;
+  for (const auto& b : deviceID.serialNumber()) {
+    serial += QString("%1").arg(b, 2, 16, QChar('0'));
+  }
+
+  QString firmware = QString::fromStdString(
+      infoData(InfoID::FirmwareVersion).infoString());
+  firmware.replace(QRegExp("[^0-9A-Za-z.]"), "_");
+
+  return QDesktopServices::storageLocation(QDesktopServices::DataLocation) +
+         "/cache/" + QString("%1_%2_%3.icc")
+                         .arg(deviceID.pid(), 4, 16, QChar('0'))
+                         .arg(serial, firmware);
+}
+
+// Only the families that describe what the firmware can do are cached, they
+// change with it alone. The audio and mixer controls cost the most to read,
+// one answer per control and channel. Settings, meters and what is connected
+// to the device, such as RTP-MIDI sessions, USB host devices and gizmos, are
+// always read from it.
+bool DeviceInfo::isCacheable(CmdEnum command) const {
+  switch (command) {
+  case Command::RetCommandList:
+  case Command::RetInfoList:
+  case Command::RetResetList:
+  case Command::RetSaveRestoreList:
+  case Command::RetAudioInfo:
+  case Command::RetAudioControlParm:
+  case Command::RetAudioControlDetail:
+  case Command::RetMixerInputControl:
+  case Command::RetMixerOutputControl:
+    break;
+
+  default:
+    return false;
+  }
+
+  // not if this firmware lets the host change it after all
+  if (!contains<CommandList>()) {
+    return false;
+  }
+  const auto& commandList = get<CommandList>();
+  return !commandList.contains((CmdEnum)(WRITE_BIT | command));
+}
+
+bool DeviceInfo::isCached(CmdEnum command) const {
+  cacheMutex.lock();
+  bool result = cache.contains(command);
+  cacheMutex.unlock();
+  return result;
+}
+
+// false if the family has to be queried, its cached answers are only taken
+// while those it was built on are unchanged
+bool DeviceInfo::answerFromCache(CmdEnum command) {
+  cacheMutex.lock();
+  bool result = cache.answer(command, storedCommandData);
+  cacheMutex.unlock();
+  return result;
+}
+
+// Reads the cache file of this device and firmware, queries for its families
+// are answered from it from now on.
+bool DeviceInfo::loadCache() {
+  cacheLoaded = true;
+
+  cacheMutex.lock();
+  cache.clear();
+  cacheMutex.unlock();
+
+  const QString fileName = cacheFileName();
+  if (fileName.isEmpty()) {
+    return false;
+  }
+
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  QByteArray contents = file.readAll();
+  file.close();
+
+  cacheMutex.lock();
+  bool result =
+      cache.load(Bytes(contents.begin(), contents.end()), deviceID,
+                 infoData(InfoID::FirmwareVersion).infoString(),
+                 boost::bind(&DeviceInfo::isCacheable, this, _1));
+  cacheMutex.unlock();
+  return result;
+}
+
+bool DeviceInfo::saveCache() const {
+  const QString fileName = cacheFileName();
+  if ((!cacheLoaded) || (fileName.isEmpty())) {
+    return false;
+  }
+
+  const Bytes result = DeviceStateCache::build(
+      deviceID, infoData(InfoID::FirmwareVersion).infoString(),
+      storedCommandData, boost::bind(&DeviceInfo::isCacheable, this, _1));
+
+  QDir::root().mkpath(QFileInfo(fileName).path());
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  return file.write((const char*)result.data(), result.size()) ==
+         (qint64)result.size();
+}
+
+void DeviceInfo::createWrites() {
+  // created on first use by the GUI thread, device discovery creates
+  // DeviceInfo objects on the MIDI thread
+  if (!writes) {
+    writes.reset(new WriteCoalescer(comm));
+    writeTimer = new QTimer();
+    writeTimer->setInterval(writes->interval());
+    connect(writeTimer, SIGNAL(timeout()), this, SLOT(pollWrites()),
+            Qt::DirectConnection);
+  }
+}
+
+void DeviceInfo::write(const commandDataKey_t &key, const Bytes &sysex) {
+  createWrites();
+
+  writes->write(key, sysex);
+  if ((!writeTimer->isActive()) && (writes->pending())) {
+    writeTimer->start();
+  }
+}
+
+void DeviceInfo::writeNow(const commandDataKey_t &key, const Bytes &sysex) {
+  write(key, sysex);
+  writes->flush(key);
+}
+
+void DeviceInfo::writeTogether(const vector<commandData_t> &before) {
+  createWrites();
+
+  WriteCoalescer::Changes changes;
+  RollBack undo;
+  changes.reserve(before.size());
+  undo.reserve(before.size());
+  for (const auto &previous : before) {
+    const auto key = previous.key();
+    const auto command = (CmdEnum)(WRITE_BIT | keyToCommandID(key));
+    WriteCoalescer::Change change = {
+        key, generate(command, storedCommandData.at(key)),
+        generate(command, previous)};
+    changes.push_back(change);
+    undo.push_back(make_pair(previous, change.sysex));
+  }
+
+  // called on the MIDI thread when the last answer comes in, pollWrites()
+  // rolls back on the GUI thread; the coalescer goes before this object
+  writes->writeTogether(changes, [this, undo](bool committed) {
+    if (!committed) {
+      QMutexLocker locker(&rollBackMutex);
+      rollBacks.push_back(undo);
+    }
+  });
+
+  // polled for the transaction's timeout
+  if ((!writeTimer->isActive()) && (writes->pending())) {
+    writeTimer->start();
+  }
+}
+
+// a setting changed again since the transaction keeps the newer value
+void DeviceInfo::rollBack(const RollBack &changes) {
+  for (const auto &change : changes) {
+    const auto &previous = change.first;
+    const auto key = previous.key();
+    const auto command = (CmdEnum)(WRITE_BIT | keyToCommandID(key));
+    if ((storedCommandData.contains(key)) &&
+        (generate(command, storedCommandData.at(key)) != change.second)) {
+      continue;
+    }
+    addCommandData(previous);
+  }
+  emit writeRolledBack();
+}
+
+// the timer keeps polling until the writes are answered
+void DeviceInfo::flushWrites() {
+  if (writes) {
+    writes->flush();
+  }
+}
+
+void DeviceInfo::pollWrites() {
+  const bool remaining = writes->poll();
+
+  rollBackMutex.lock();
+  vector<RollBack> failed;
+  failed.swap(rollBacks);
+  rollBackMutex.unlock();
+  for (const auto &changes : failed) {
+    rollBack(changes);
+  }
+
+  if (!remaining) {
+    writeTimer->stop();
+  }
+}
+
 bool DeviceInfo::rereadAudioInfo() {
 
   CommandQList query;
@@ -252,7 +532,7 @@ bool DeviceInfo::rereadStored() {
 
 bool DeviceInfo::contains(const commandDataKey_t& key) const {
 
-  return MyAlgorithms::contains(storedCommandData, key);
+  return storedCommandData.contains(key);
 }
 
 #ifdef _WIN32
@@ -263,28 +543,26 @@ bool DeviceInfo::isNewWindowsDriver()
 #endif
 
 
-void DeviceInfo::addCommandData(commandData_t commandData) {
+void DeviceInfo::addCommandData(const commandData_t &commandData) {
 
   storedCommandData[commandData.key()] = commandData;
 }
 
 bool DeviceInfo::containsCommandDataType(CmdEnum command) const {
 
-  bool value = storedCommandData.lower_bound(generateKey(command)) !=
-               storedCommandData.end();
+  bool value = storedCommandData.count(command) > 0;
   return value;
 }
 
 bool DeviceInfo::containsCommandData(CmdEnum command) const {
 
-  bool value = MyAlgorithms::contains(storedCommandData, generateKey(command));
+  bool value = storedCommandData.contains(generateKey(command));
   return value;
 }
 
 bool DeviceInfo::containsInfo(InfoIDEnum infoID) const {
 
-  return MyAlgorithms::contains(storedCommandData,
-                                generateKey(Command::RetInfo, infoID));
+  return storedCommandData.contains(generateKey(Command::RetInfo, infoID));
 }
 
 Info& DeviceInfo::infoData(InfoIDEnum infoID) {
@@ -385,6 +663,10 @@ void DeviceInfo::registerAllHandlers() {
   auto midiHostDeviceHandler = bind(
       &DeviceInfo::handleUSBHostMIDIDeviceDetailData, this, _1, _2, _3, _4);
   addHandler(Command::RetUSBHostMIDIDeviceDetail, midiHostDeviceHandler);
+
+  auto queryACKHandler =
+      bind(&DeviceInfo::handleQueryACKData, this, _1, _2, _3, _4);
+  addHandler(Command::ACK, queryACKHandler);
 }
 
 void DeviceInfo::unRegisterHandlerAllHandlers() {
@@ -417,6 +699,8 @@ void DeviceInfo::timeout() {
   attemptedQueries.clear();
   attemptedQueriesMutex.unlock();
   queryScreen = UnknownScreen;
+  restoring = false;
+  comm->clearInFlight(RequestPriority::Background, transID);
 }
 
 void DeviceInfo::addCommand(const Bytes& _sysex) {
@@ -444,13 +728,7 @@ bool DeviceInfo::sendNextSysex() {
   bool send = !(sysexMessages.empty());
 
   if (send) {
-    // send the next sysex message
-    //printf("presend\n");
-    comm->sendSysex(sysexMessages.front());
-    //printf("postsend\n");
-
-    // remove the sysex message from the message queue
-    sysexMessages.pop();
+    fillRequestWindow();
   }
   sysexMutex.unlock();
 
@@ -461,67 +739,34 @@ bool DeviceInfo::sendNextSysex() {
     //  return sendNextSysex();
   }
 
+  // the next query may depend on answers that are still in flight so wait
+  // for them before expanding it
+  if (comm->pendingCount(RequestPriority::Background) > 0) {
+    return true;
+  }
+
   //printf("1: sysexMessages.size(): %d, currentQuery.size(): %d (%d)\n", sysexMessages.size(), currentQuery.size(), QThread::currentThreadId());
 
   if (!send) {
     currentQueryMutex.lock();
-    // get the front iterator for the current query
-    auto q = currentQuery.begin();
-
-    // loop through the current query
-    while (q != currentQuery.end()) {
-      auto D = commandDependancy(*q);
-
-      bool metDependancies = true;
-      for (auto d : D) {
-        if (!containsCommandDataType(d)) {
-          attemptedQueriesMutex.lock();
-          if (!MyAlgorithms::contains(attemptedQueries, d)) {
-            metDependancies = false;
-          }
-          attemptedQueriesMutex.unlock();
+    // everything asked for so far has been answered, ask for the next level
+    // of the plan, its families only depend on the levels before it
+    while ((!currentQuery.empty()) && (sysexMessages.empty())) {
+      for (auto q : currentQuery.takeLevel()) {
+        // add the query sysex to the sysex buffer, unless the family is
+        // answered from the device state cache
+        if (answerFromCache(q)) {
+          queriedItemsMutex.lock();
+          queriedItems.push_back(q);
+          queriedItemsMutex.unlock();
+        } else {
+          addQuerySysex(q);
         }
-      }
-
-      // if all dependancies are met
-      if ((D.empty()) || metDependancies) {
-
-        // add the query sysex to the sysex buffer
-        addQuerySysex(*q);
 
         // add query to the attempted queries
         attemptedQueriesMutex.lock();
-        attemptedQueries.insert(*q);
+        attemptedQueries.insert(q);
         attemptedQueriesMutex.unlock();
-
-        // remove query from list of pending commands and increment pointer
-
-        //printf("2: currentQuery.size(): %d, q: %d (%d)\n", currentQuery.size(), q, QThread::currentThreadId());
-        q = currentQuery.erase(q);
-        currentQueryMutex.unlock();
-        //printf("438\n");
-        return sendNextSysex();
-      } else {
-        // dependencies not met
-        // foreach dependencies
-        for (auto d : D) {
-          // if dependancy isn't in current query and dependancies is not
-          // alrealy being queried and dependancies has not been attempted
-          attemptedQueriesMutex.lock();
-          if ((!MyAlgorithms::contains(currentQuery, d)) &&
-              (!containsCommandDataType(d)) &&
-              (!MyAlgorithms::contains(attemptedQueries, d))) {
-            // add dependancy to current query
-            currentQuery.push_front(d); //push_back
-          }
-          else if (MyAlgorithms::contains(currentQuery, d)) {
-            currentQuery.remove(d);
-            currentQuery.push_front(d);
-          }
-          attemptedQueriesMutex.unlock();
-        }
-
-        q = currentQuery.begin();
       }
     }
 
@@ -557,9 +802,10 @@ bool DeviceInfo::sendNextSysex() {
         // set the query Screen
         queryScreen = boost::get<0>(nextQuery);
 
-        // set the currentQuery to the next query
+        // plan the next query
         currentQueryMutex.lock();
-        currentQuery = boost::get<1>(nextQuery);
+        currentQuery =
+            planQuery(CommandQList::fromStdList(boost::get<1>(nextQuery)));
         currentQueryMutex.unlock();
 
         // clear the list of queried items
@@ -574,10 +820,8 @@ bool DeviceInfo::sendNextSysex() {
     } else {
       // there are pending sysex messages
       sysexMutex.lock();
-      // send the next sysex message
-      comm->sendSysex(sysexMessages.front());
-      // remove the sent sysex message from the queue
-      sysexMessages.pop();
+      // send as many sysex messages as the request window allows
+      fillRequestWindow();
       sysexMutex.unlock();
 
       // we have sent a sysex message
@@ -590,8 +834,26 @@ bool DeviceInfo::sendNextSysex() {
   return send;
 }
 
+// queries and restores are background work, the Communicator lets writes
+// from the controls and meter polls ahead of them
+void DeviceInfo::fillRequestWindow() {
+  while ((!sysexMessages.empty()) &&
+         (comm->sendSysex(sysexMessages.front(),
+                          RequestPriority::Background))) {
+    sysexMessages.pop();
+  }
+}
+
 bool DeviceInfo::commonHandleCode(DeviceID _deviceID, Word _transID) {
 
+  // meter streaming answers belong to the MeterPoller, the ACKs of coalesced
+  // writes to the WriteCoalescer
+  if ((_transID == kMeterTransID) ||
+      ((_transID >= kWriteTransIDFirst) &&
+       (_transID < kWriteTransIDFirst + kWriteTransIDCount))) {
+    return false;
+  }
+
   if ((deviceID.serialNumber() == SerialNumber()) ||
       (deviceID.pid() == Word()) || (transID == Word())) {
     deviceID = _deviceID;
@@ -602,7 +864,7 @@ bool DeviceInfo::commonHandleCode(DeviceID _deviceID, Word _transID) {
 }
 
 void DeviceInfo::handleCommandData(CmdEnum _command, DeviceID _deviceID,
-                                   Word _transID, commandData_t _commandData) {
+                                   Word _transID, const commandData_t &_commandData) {
 
   if (commonHandleCode(_deviceID, _transID)) {
     auto key = _commandData.key();
@@ -620,7 +882,7 @@ void DeviceInfo::handleCommandData(CmdEnum _command, DeviceID _deviceID,
 void DeviceInfo::handleUSBHostMIDIDeviceDetailData(CmdEnum _command,
                                                    DeviceID _deviceID,
                                                    Word _transID,
-                                                   commandData_t _commandData) {
+                                                   const commandData_t &_commandData) {
 
   if (commonHandleCode(_deviceID, _transID)) {
     auto& foundUSBDetails = _commandData.get<USBHostMIDIDeviceDetail>();
@@ -645,19 +907,86 @@ void DeviceInfo::handleUSBHostMIDIDeviceDetailData(CmdEnum _command,
   }
 }
 
-void DeviceInfo::handleACKData(CmdEnum, DeviceID, Word, commandData_t) {
+void DeviceInfo::handleACKData(CmdEnum, DeviceID, Word, const commandData_t &) {
 
   if (!sysexMessages.empty()) {
     emit writingProgress(maxWriteItems - sysexMessages.size());
     //printf("576\n");
     sendNextSysex();
-  } else {
-    comm->unRegisterExclusiveHandler();
+  } else if (comm->pendingCount(RequestPriority::Background) == 0) {
+    restoring = false;
     emit writeCompleted();
   }
 }
 
+void DeviceInfo::handleQueryACKData(CmdEnum _command, DeviceID _deviceID,
+                                    Word _transID,
+                                    const commandData_t &_commandData) {
+
+  // ACKs of other writers, such as the write coalescer, keep arriving
+  // during a restore, only our own answer it
+  if (restoring) {
+    if ((deviceID == _deviceID) && (transID == _transID)) {
+      handleACKData(_command, _deviceID, _transID, _commandData);
+    }
+    return;
+  }
+
+  // a query the device could not answer is ACKed with an error, carry on
+  // with the rest of the query
+  if (commonHandleCode(_deviceID, _transID)) {
+    sendNextSysex();
+  }
+}
+
+bool DeviceInfo::isAnswered(CmdEnum command) const {
+  if (containsCommandDataType(command)) {
+    return true;
+  }
+
+  attemptedQueriesMutex.lock();
+  bool result = MyAlgorithms::contains(attemptedQueries, command);
+  attemptedQueriesMutex.unlock();
+  return result;
+}
+
+QueryPlan DeviceInfo::planQuery(const CommandQList &query) const {
+  return QueryPlan(query.toStdList(),
+                   boost::bind(&DeviceInfo::isAnswered, this, _1));
+}
+
+int DeviceInfo::estimateMessages(const QueryPlan &plan, int *unknownFamilies) {
+  int messages = 0;
+  int unknown = 0;
+
+  for (auto family : plan.order()) {
+    if (isCached(family)) {
+      continue;
+    }
+
+    const auto D = commandDependancy(family);
+    if (std::all_of(D.begin(), D.end(), [&](CmdEnum d) {
+          return containsCommandDataType(d);
+        })) {
+      std::queue<Bytes> scratch;
+      addQuerySysex(family, scratch);
+      messages += scratch.size();
+    } else {
+      ++unknown;
+    }
+  }
+
+  if (unknownFamilies) {
+    *unknownFamilies = unknown;
+  }
+  return messages;
+}
+
 void DeviceInfo::addQuerySysex(CmdEnum command) {
+  addQuerySysex(command, sysexMessages);
+}
+
+void DeviceInfo::addQuerySysex(CmdEnum command, std::queue<Bytes> &target) {
 
   sysexMutex.lock();
   static int count = 0;
@@ -680,20 +1009,20 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   switch (command) {
   case Command::GetDevice:
   case Command::RetDevice: {
-    addCommand<GetDeviceCommand>();
+    queueCommand<GetDeviceCommand>(target);
     break;
   }
 
   case Command::GetCommandList:
   case Command::RetCommandList: {
-    addCommand<GetDeviceCommand>();
+    queueCommand<GetDeviceCommand>(target);
     break;
   }
 
   case Command::GetInfoList:
   case Command::RetInfoList: {
     if (commandList.contains(Command::GetInfoList)) {
-      addCommand<GetInfoListCommand>();
+      queueCommand<GetInfoListCommand>(target);
     }
     break;
   }
@@ -704,7 +1033,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
       auto& infoListData = get<InfoList>();
 
       infoListData.for_each([&](const InfoList::InfoRecord & infoRecord) {
-        addCommand<GetInfoCommand>(infoRecord.infoID());
+        queueCommand<GetInfoCommand>(target, infoRecord.infoID());
       });
     }
     break;
@@ -713,7 +1042,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetResetList:
   case Command::RetResetList: {
     if (commandList.contains(Command::GetResetList)) {
-      addCommand<GetResetListCommand>();
+      queueCommand<GetResetListCommand>(target);
     }
     break;
   }
@@ -721,7 +1050,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetSaveRestoreList:
   case Command::RetSaveRestoreList: {
     if (commandList.contains(Command::GetSaveRestoreList)) {
-      addCommand<GetSaveRestoreListCommand>();
+      queueCommand<GetSaveRestoreListCommand>(target);
     }
     break;
   }
@@ -730,7 +1059,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::RetEthernetPortInfo: {
     if (commandList.contains(Command::GetEthernetPortInfo)) {
       for (auto portID = 1; portID <= midiInfo.numEthernetJacks(); ++portID) {
-        addCommand<GetEthernetPortInfoCommand>(portID);
+        queueCommand<GetEthernetPortInfoCommand>(target, portID);
       }
     }
     break;
@@ -739,7 +1068,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetGizmoCount:
   case Command::RetGizmoCount: {
     if (commandList.contains(Command::GetGizmoCount)) {
-      addCommand<GetGizmoCountCommand>();
+      queueCommand<GetGizmoCountCommand>(target);
     }
     break;
   }
@@ -748,7 +1077,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::RetGizmoInfo: {
     if (commandList.contains(Command::GetGizmoInfo)) {
       for (Word i = 1; i <= gizmoCount.gizmoCount(); ++i) {
-        addCommand<GetGizmoInfoCommand>(i);
+        queueCommand<GetGizmoInfoCommand>(target, i);
       }
     }
     break;
@@ -758,7 +1087,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetMIDIInfo:
   case Command::RetMIDIInfo: {
     if (commandList.contains(Command::GetMIDIInfo)) {
-      addCommand<GetMIDIInfoCommand>();
+      queueCommand<GetMIDIInfoCommand>(target);
     }
     break;
   }
@@ -767,7 +1096,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::RetMIDIPortInfo: {
     if (commandList.contains(Command::GetMIDIPortInfo)) {
       for (auto portID = 1; portID <= midiInfo.numMIDIPorts(); ++portID) {
-        addCommand<GetMIDIPortInfoCommand>(portID);
+        queueCommand<GetMIDIPortInfoCommand>(target, portID);
       }
     }
     break;
@@ -778,10 +1107,10 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetMIDIPortFilter)) {
       for (auto portID = 1; portID <= midiInfo.numMIDIPorts(); ++portID) {
         // Input filter
-        addCommand<GetMIDIPortFilterCommand>(portID, FilterID::InputFilter);
+        queueCommand<GetMIDIPortFilterCommand>(target, portID, FilterID::InputFilter);
 
         // Output filter
-        addCommand<GetMIDIPortFilterCommand>(portID, FilterID::OutputFilter);
+        queueCommand<GetMIDIPortFilterCommand>(target, portID, FilterID::OutputFilter);
       }
     }
     break;
@@ -792,10 +1121,10 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetMIDIPortRemap)) {
       for (auto portID = 1; portID <= midiInfo.numMIDIPorts(); ++portID) {
         // Input remap
-        addCommand<GetMIDIPortRemapCommand>(portID, RemapID::InputRemap);
+        queueCommand<GetMIDIPortRemapCommand>(target, portID, RemapID::InputRemap);
 
         // Output remap
-        addCommand<GetMIDIPortRemapCommand>(portID, RemapID::OutputRemap);
+        queueCommand<GetMIDIPortRemapCommand>(target, portID, RemapID::OutputRemap);
       }
     }
     break;
@@ -805,7 +1134,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::RetMIDIPortRoute: {
     if (commandList.contains(Command::GetMIDIPortRoute)) {
       for (auto portID = 1; portID <= midiInfo.numMIDIPorts(); ++portID) {
-        addCommand<GetMIDIPortRouteCommand>(portID);
+        queueCommand<GetMIDIPortRouteCommand>(target, portID);
       }
     }
     break;
@@ -815,7 +1144,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::RetMIDIPortDetail: {
     if (commandList.contains(Command::GetMIDIPortDetail)) {
       for (auto portID = 1; portID <= midiInfo.numMIDIPorts(); ++portID) {
-        addCommand<GetMIDIPortDetailCommand>(portID);
+        queueCommand<GetMIDIPortDetailCommand>(target, portID);
       }
     }
     break;
@@ -826,7 +1155,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     for (auto jackID = 1; jackID <= midiInfo.numUSBHostJacks(); ++jackID) {
       for (auto hostID = 1; hostID <= midiInfo.numUSBMIDIPortPerHostJack();
            ++hostID) {
-        addCommand<GetUSBHostMIDIDeviceDetailCommand>(jackID, hostID);
+        queueCommand<GetUSBHostMIDIDeviceDetailCommand>(target, jackID, hostID);
       }
     }
     break;
@@ -844,7 +1173,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
            ++portID) {
         for (auto connID = 1;
              connID <= midiInfo.numRTPMIDIConnectionsPerSession(); ++connID) {
-          addCommand<GetRTPMIDIConnectionDetailCommand>(portID, connID);
+          queueCommand<GetRTPMIDIConnectionDetailCommand>(target, portID, connID);
         }
       }
     }
@@ -854,7 +1183,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetAudioInfo:
   case Command::RetAudioInfo: {
     if (commandList.contains(Command::GetAudioInfo)) {
-      addCommand<GetAudioInfoCommand>();
+      queueCommand<GetAudioInfoCommand>(target);
     }
     break;
   }
@@ -862,7 +1191,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetAudioCfgInfo:
   case Command::RetAudioCfgInfo: {
     if (commandList.contains(Command::GetAudioCfgInfo)) {
-      addCommand<GetAudioCfgInfoCommand>();
+      queueCommand<GetAudioCfgInfoCommand>(target);
     }
     break;
   }
@@ -872,7 +1201,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetAudioPortInfo)) {
       for (auto portID = 1; portID <= audioInfo.numberOfAudioPorts();
            ++portID) {
-        addCommand<GetAudioPortInfoCommand>(portID);
+        queueCommand<GetAudioPortInfoCommand>(target, portID);
       }
     }
     break;
@@ -883,7 +1212,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetAudioPortCfgInfo)) {
       for (auto portID = 1; portID <= audioInfo.numberOfAudioPorts();
            ++portID) {
-        addCommand<GetAudioPortCfgInfoCommand>(portID);
+        queueCommand<GetAudioPortCfgInfoCommand>(target, portID);
       }
     }
     break;
@@ -894,7 +1223,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetAudioPortPatchbay)) {
       for (auto portID = 1; portID <= audioInfo.numberOfAudioPorts();
            ++portID) {
-        addCommand<GetAudioPortPatchbayCommand>(portID);
+        queueCommand<GetAudioPortPatchbayCommand>(target, portID);
       }
     }
 
@@ -904,7 +1233,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetAudioClockInfo:
   case Command::RetAudioClockInfo: {
     if (commandList.contains(Command::GetAudioClockInfo)) {
-      addCommand<GetAudioClockInfoCommand>();
+      queueCommand<GetAudioClockInfoCommand>(target);
     }
     break;
   }
@@ -913,7 +1242,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetAudioGlobalParm:
   case Command::RetAudioGlobalParm: {
     if (commandList.contains(Command::GetAudioGlobalParm)) {
-      addCommand<GetAudioGlobalParmCommand>();
+      queueCommand<GetAudioGlobalParmCommand>(target);
     }
     break;
   }
@@ -923,7 +1252,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetAudioPortParm)) {
       for (Word audioPortID = 1;
            audioPortID <= audioGlobalParm.numAudioPorts(); ++audioPortID) {
-        addCommand<GetAudioPortParmCommand>(audioPortID);
+        queueCommand<GetAudioPortParmCommand>(target, audioPortID);
       }
     }
     break;
@@ -934,7 +1263,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetAudioDeviceParm)) {
       for (Word audioPortID = 1;
            audioPortID <= audioGlobalParm.numAudioPorts(); ++audioPortID) {
-        addCommand<GetAudioDeviceParmCommand>(audioPortID);
+        queueCommand<GetAudioDeviceParmCommand>(target, audioPortID);
       }
     }
     break;
@@ -950,7 +1279,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
         for (auto controllerNumber = 1;
              controllerNumber <= audioDeviceParm.maxControllers();
              ++controllerNumber) {
-          addCommand<GetAudioControlParmCommand>(audioPortID,
+          queueCommand<GetAudioControlParmCommand>(target, audioPortID,
                                                  controllerNumber);
         }
       }
@@ -965,7 +1294,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
             [&](const AudioControlParm & audioControlParm) {
         for (Byte detailID = 1; detailID <= audioControlParm.numDetails();
              ++detailID) {
-          addCommand<GetAudioControlDetailCommand>(
+          queueCommand<GetAudioControlDetailCommand>(target, 
                 audioControlParm.audioPortID(),
                 audioControlParm.controllerNumber(), detailID);
         }
@@ -981,7 +1310,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
             [&](const AudioControlParm & audioControlParm) {
         for (Byte detailID = 1; detailID <= audioControlParm.numDetails();
              ++detailID) {
-          addCommand<GetAudioControlDetailValueCommand>(
+          queueCommand<GetAudioControlDetailValueCommand>(target, 
                 audioControlParm.audioPortID(),
                 audioControlParm.controllerNumber(), detailID);
         }
@@ -993,7 +1322,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetAudioClockParm:
   case Command::RetAudioClockParm: {
     if (commandList.contains(Command::GetAudioClockParm)) {
-      addCommand<GetAudioClockParmCommand>();
+      queueCommand<GetAudioClockParmCommand>(target);
     }
     break;
   }
@@ -1003,7 +1332,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetAudioPatchbayParm)) {
       for (Word audioPortID = 1;
            audioPortID <= audioGlobalParm.numAudioPorts(); ++audioPortID) {
-        addCommand<GetAudioPatchbayParmCommand>(audioPortID);
+        queueCommand<GetAudioPatchbayParmCommand>(target, audioPortID);
       }
     }
     break;
@@ -1013,7 +1342,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::RetAudioPortMeterValue: {
     if (commandList.contains(Command::GetAudioDeviceParm)) {
       for (Word audioPortID = 1; audioPortID <= audioGlobalParm.numAudioPorts(); ++audioPortID) {
-        addCommand<GetAudioPortMeterValueCommand>(
+        queueCommand<GetAudioPortMeterValueCommand>(target, 
               audioPortID);
       }
     }
@@ -1025,7 +1354,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::GetMixerPortParm:
   case Command::RetMixerPortParm: {
     if (commandList.contains(Command::GetMixerPortParm)) {
-      addCommand<GetMixerPortParmCommand>();
+      queueCommand<GetMixerPortParmCommand>(target);
     }
     break;
   }
@@ -1034,7 +1363,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
   case Command::RetMixerParm: {
     if (commandList.contains(Command::GetMixerParm)) {
       for (Byte audioConfigurationNumber = 1; audioConfigurationNumber <= audioGlobalParm.numConfigBlocks(); ++audioConfigurationNumber) {
-        addCommand<GetMixerParmCommand>(
+        queueCommand<GetMixerParmCommand>(target, 
               audioConfigurationNumber);
       }
     }
@@ -1056,7 +1385,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetMixerInputParm)) {
         for (Byte audioPortID = 1; audioPortID <= mixerPortParm.audioPortMixerBlockCount(); ++audioPortID) {
           for (Byte mixerInputNumber = 1; mixerInputNumber <= mixerPortParm.audioPortMixerBlocks.at(audioPortID - 1).numInputs(); ++mixerInputNumber) {
-            addCommand<GetMixerInputParmCommand>(
+            queueCommand<GetMixerInputParmCommand>(target, 
                   audioPortID,
                   mixerInputNumber);
           }
@@ -1081,7 +1410,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetMixerOutputParm)) {
         for (Byte audioPortID = 1; audioPortID <= mixerPortParm.audioPortMixerBlockCount(); ++audioPortID) {
           for (Byte mixerOutputNumber = 1; mixerOutputNumber <= mixerPortParm.audioPortMixerBlocks.at(audioPortID - 1).numOutputs(); ++mixerOutputNumber) {
-            addCommand<GetMixerOutputParmCommand>(
+            queueCommand<GetMixerOutputParmCommand>(target, 
                   audioPortID,
                   mixerOutputNumber);
           }
@@ -1095,7 +1424,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
 
     if (commandList.contains(Command::GetMixerInputControl)) {
         for (Byte audioPortID = 1; audioPortID <= mixerPortParm.audioPortMixerBlockCount(); ++audioPortID) {
-          addCommand<GetMixerInputControlCommand>(
+          queueCommand<GetMixerInputControlCommand>(target, 
                 audioPortID);
         }
       };
@@ -1108,7 +1437,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
 
     if (commandList.contains(Command::GetMixerOutputControl)) {
         for (Byte audioPortID = 1; audioPortID <= mixerPortParm.audioPortMixerBlockCount(); ++audioPortID) {
-          addCommand<GetMixerOutputControlCommand>(
+          queueCommand<GetMixerOutputControlCommand>(target, 
                 audioPortID);
         }
       };
@@ -1124,7 +1453,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
       for (Byte audioPortID = 1; audioPortID <= mixerPortParm.audioPortMixerBlockCount(); ++audioPortID) {
         for (Byte mixerOutputNumber = 1; mixerOutputNumber <= mixerPortParm.audioPortMixerBlocks.at(audioPortID - 1).numOutputs(); ++mixerOutputNumber) {
           for (Byte mixerInputNumber = 1; mixerInputNumber <= mixerPortParm.audioPortMixerBlocks.at(audioPortID - 1).numInputs(); ++mixerInputNumber) {
-            addCommand<GetMixerInputControlValueCommand>(
+            queueCommand<GetMixerInputControlValueCommand>(target, 
                 audioPortID, mixerOutputNumber, mixerInputNumber);
           }
         }
@@ -1141,7 +1470,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetMixerInputControlValue)) {
       for (Byte audioPortID = 1; audioPortID <= mixerPortParm.audioPortMixerBlockCount(); ++audioPortID) {
         for (Byte mixerOutputNumber = 1; mixerOutputNumber <= mixerPortParm.audioPortMixerBlocks.at(audioPortID - 1).numOutputs(); ++mixerOutputNumber) {
-          addCommand<GetMixerOutputControlValueCommand>(
+          queueCommand<GetMixerOutputControlValueCommand>(target, 
               audioPortID, mixerOutputNumber);
         }
       }
@@ -1158,7 +1487,7 @@ void DeviceInfo::addQuerySysex(CmdEnum command) {
     if (commandList.contains(Command::GetMixerInputControlValue)) {
       for (Byte audioPortID = 1; audioPortID <= mixerPortParm.audioPortMixerBlockCount(); ++audioPortID) {
         for (Byte mixerOutputNumber = 1; mixerOutputNumber <= mixerPortParm.audioPortMixerBlocks.at(audioPortID - 1).numOutputs(); ++mixerOutputNumber) {
-          addCommand<GetMixerMeterValueCommand>(
+          queueCommand<GetMixerMeterValueCommand>(target, 
               audioPortID, mixerOutputNumber);
         }
       }
@@ -1187,7 +1516,7 @@ Bytes DeviceInfo::serialize() {
   result += 0x01;
 
   for (const auto& cmdPair : storedCommandData) {
-    push_back(result, generate(keyToCommand(cmdPair.first), cmdPair.second));
+    generateInto(result, keyToCommand(cmdPair.first), cmdPair.second);
   }
 
   auto hash = QCryptographicHash::hash(
@@ -1216,15 +1545,16 @@ Bytes DeviceInfo::serialize2(std::set<Command::Enum> commandsToSave, QString des
     result += description.at(x).toAscii();
   }
 
+  // presets are not tied to one unit, the serial number is left at zero
+  const DeviceID anyUnit(deviceID.pid());
   for (const auto& cmdPair : storedCommandData) {
     if (commandsToSave.find(keyToCommand(cmdPair.first)) != commandsToSave.end()) { // if we're supposed to save it
-      Bytes toWrite = generate(keyToCommand(cmdPair.first), cmdPair.second);
-      toWrite[7] = toWrite[8] = toWrite[9] = toWrite[10] = toWrite[11] = 0;
-      toWrite[toWrite.size() - 2] = (~(accumulate(toWrite.begin() + 5, toWrite.end() - 2, 0x00)) + 1) & 0x7F;
+      const auto offset = result.size();
+      GeneSysLib::generateInto(result, anyUnit, transID,
+                               keyToCommand(cmdPair.first), cmdPair.second);
 
-      push_back(result, toWrite);
       std::cout << "writing: ";
-      for( Bytes::const_iterator i = toWrite.begin(); i != toWrite.end(); ++i)
+      for( Bytes::const_iterator i = result.begin() + offset; i != result.end(); ++i)
           std::cout << std::hex << (int)*i << ' ';
       std::cout << '\n';
     }
@@ -1238,6 +1568,34 @@ Bytes DeviceInfo::serialize2(std::set<Command::Enum> commandsToSave, QString des
   return result;
 }
 
+Bytes DeviceInfo::serialize3(const std::set<Command::Enum> &preReboot,
+                             const std::set<Command::Enum> &postReboot,
+                             QString description) {
+  std::vector<PresetFile::Content> contents;
+
+  // presets are not tied to one unit, the serial number is left at zero
+  const DeviceID anyUnit(deviceID.pid());
+  for (const auto& cmdPair : storedCommandData) {
+    const auto family = keyToCommand(cmdPair.first);
+    const bool pre = (preReboot.count(family) > 0);
+    if ((!pre) && (postReboot.count(family) == 0)) {
+      continue;
+    }
+
+    // the store keeps the entries of a family together
+    if ((contents.empty()) || (contents.back().family != family)) {
+      PresetFile::Content content;
+      content.family = family;
+      content.stage = pre ? PresetFile::PreReboot : PresetFile::PostReboot;
+      contents.push_back(content);
+    }
+    GeneSysLib::generateInto(contents.back().frames, anyUnit, transID, family,
+                             cmdPair.second);
+  }
+
+  return PresetFile::build(deviceID.pid(), description, contents);
+}
+
 void DeviceInfo::replaceChecksumByte(unsigned char *arr, size_t size) {
   int acc = 0;
   for (size_t i = 5; i < size - 2; i++) {
@@ -1249,17 +1607,23 @@ void DeviceInfo::replaceChecksumByte(unsigned char *arr, size_t size) {
 Bytes DeviceInfo::serialize2midi(std::set<Command::Enum> commandsToSave, bool reboot) {
   Bytes result;
 
+  // presets are not tied to one unit, the serial number is left at zero
+  const DeviceID anyUnit(deviceID.pid());
+  Bytes sysex;
   for (const auto& cmdPair : storedCommandData) {
     if (commandsToSave.find(keyToCommand(cmdPair.first)) != commandsToSave.end()) { // if we're supposed to save it
-      Bytes toWrite = generate(keyToCommand(cmdPair.first), cmdPair.second);
-      toWrite[7] = toWrite[8] = toWrite[9] = toWrite[10] = toWrite[11] = 0;
-      toWrite[14] = 0x40;
-      toWrite[toWrite.size() - 2] = (~(accumulate(toWrite.begin() + 5, toWrite.end() - 2, 0x00)) + 1) & 0x7F; //redo checksum
-      toWrite.insert(toWrite.begin() + 1, toWrite.size() - 1);
-      result += 1;
-      push_back(result, toWrite);
+      sysex.clear();
+      GeneSysLib::generateInto(
+          sysex, anyUnit, transID,
+          (CmdEnum)(WRITE_BIT | keyToCommandID(cmdPair.first)),
+          cmdPair.second);
+
+      // each message is led by 1, F0 and the length of the rest
+      result += 1, sysex.front(), (Byte)(sysex.size() - 1);
+      result.insert(result.end(), sysex.begin() + 1, sysex.end());
+
       std::cout << "writing midi: ";
-      for( Bytes::const_iterator i = toWrite.begin(); i != toWrite.end(); ++i)
+      for( Bytes::const_iterator i = result.end() - sysex.size() - 1; i != result.end(); ++i)
           std::cout << std::hex << (int)*i << ' ';
       std::cout << '\n';
     }
@@ -1292,7 +1656,8 @@ Bytes DeviceInfo::serialize2midi(std::set<Command::Enum> commandsToSave, bool re
   return result;
 }
 
-bool DeviceInfo::deserialize(Bytes data) {
+bool DeviceInfo::deserialize(Bytes data, RestoreMode mode,
+                             bool hashChecked) {
 
   bool valid = true;
   auto start = data.begin();
@@ -1342,7 +1707,7 @@ bool DeviceInfo::deserialize(Bytes data) {
   }
 
   // Verify the footer
-  if (valid) {
+  if ((valid) && (!hashChecked)) {
     BytesIter md5Iter = finish - 16;
 
     auto hashAlgorithm = boost::shared_ptr<QCryptographicHash>(
@@ -1357,23 +1722,54 @@ bool DeviceInfo::deserialize(Bytes data) {
   }
 
   if (valid) {
-    DeviceID storedDeviceID = deviceID;
-    Word storedTransID = transID;
+    restoreFrames(data, mode);
+  }
 
-    //storedCommandData.clear();
-    //usbHostMIDIDeviceDetails.clear();
+  return valid;
+}
 
-    comm->parseBytes(start, finish, deviceID);
+void DeviceInfo::restoreFrames(Bytes frames, RestoreMode mode) {
+  DeviceID storedDeviceID = deviceID;
+  Word storedTransID = transID;
 
-    deviceID = storedDeviceID;
-    transID = storedTransID;
+  //storedCommandData.clear();
+  //usbHostMIDIDeviceDetails.clear();
 
-    auto ackHandler = bind(&DeviceInfo::handleACKData, this, _1, _2, _3, _4);
-    comm->registerExclusiveHandler(Command::ACK, ackHandler);
-    writeAll();
+  // what the device holds now, parsing replaces the stored entries
+  WriteMap current;
+  if (mode == RestoreChanged) {
+    current = generateWrites();
   }
 
-  return valid;
+  auto start = frames.begin();
+  auto finish = frames.end();
+  comm->parseBytes(start, finish, deviceID);
+
+  deviceID = storedDeviceID;
+  transID = storedTransID;
+
+  // the settings the frames hold, the rest of the store is left alone
+  std::set<commandDataKey_t> restored;
+  auto blockStart = std::find(frames.begin(), frames.end(), (Byte)0xF0);
+  while (blockStart != frames.end()) {
+    auto blockEnd = std::find(blockStart, frames.end(), (Byte)0xF7);
+    if (blockEnd == frames.end()) {
+      break;
+    }
+
+    DeviceID frameDeviceID;
+    Word frameTransID;
+    CmdEnum command;
+    commandData_t commandData;
+    if (SysexParser::decode(blockStart, blockEnd + 1, frameDeviceID,
+                            frameTransID, command, commandData)) {
+      restored.insert(commandData.key());
+    }
+    blockStart = std::find(blockEnd + 1, frames.end(), (Byte)0xF0);
+  }
+
+  restoring = true;
+  writeChanged(current, restored);
 }
 
 long DeviceInfo::registerHandler(CmdEnum commandID, Handler handler) {
@@ -1412,18 +1808,53 @@ void DeviceInfo::unRegisterExclusiveHandler() {
   comm->unRegisterExclusiveHandler();
 }
 
-void DeviceInfo::writeAll() {
-
+DeviceInfo::WriteMap DeviceInfo::generateWrites() const {
+  WriteMap result;
   for (const auto& cmdData : storedCommandData) {
+    result[cmdData.first] =
+        generate((CmdEnum)(WRITE_BIT | keyToCommandID(cmdData.first)),
+                 cmdData.second);
+  }
+  return result;
+}
+
+// Writes the restored entries whose Set command differs from the one in
+// `current`, entries missing from `current` are always written.
+void DeviceInfo::writeChanged(const WriteMap &current,
+                              const std::set<commandDataKey_t> &restored) {
+
+  int total = 0;
+  for (const auto key : restored) {
+    if (!storedCommandData.contains(key)) {
+      continue;
+    }
+    auto sysex = generate((CmdEnum)(WRITE_BIT | keyToCommandID(key)),
+                          storedCommandData.at(key));
+    ++total;
+
+    auto found = current.find(key);
+    if ((found != current.end()) && (found->second == sysex)) {
+      continue;
+    }
+
     sysexMutex.lock();
-    addCommand(generate((CmdEnum)(WRITE_BIT | keyToCommandID(cmdData.first)),
-                        cmdData.second));
+    addCommand(sysex);
     sysexMutex.unlock();
 
   }
 
   maxWriteItems = sysexMessages.size();
   emit writingStarted(maxWriteItems);
+  emit writeDiffReady(maxWriteItems, total);
+
+  if ((maxWriteItems == 0) &&
+      (comm->pendingCount(RequestPriority::Background) == 0)) {
+    // nothing differs, no ACK will finish the write
+    restoring = false;
+    emit writeCompleted();
+    return;
+  }
+
   //printf("1207\n");
   sendNextSysex();
 }
@@ -1432,3 +1863,8 @@ Bytes DeviceInfo::generate(CmdEnum command,
                            const commandData_t& cmdData) const {
   return ::generate(deviceID, transID, command, cmdData);
 }
+
+size_t DeviceInfo::generateInto(Bytes& sysex, CmdEnum command,
+                                const commandData_t& cmdData) const {
+  return ::generateInto(sysex, deviceID, transID, command, cmdData);
+}
@@ -10,14 +10,17 @@
 
 #include "CommandDefines.h"
 #include "CommandDataKey.h"
+#include "CommandDataStore.h"
 #include "CommandQList.h"
 #include "Communicator.h"
 #include "DeviceID.h"
+#include "DeviceStateCache.h"
 #include "EthernetPortInfo.h"
 #include "Info.h"
 #include "MIDIPortDetail.h"
 #include "MIDIPortFilter.h"
 #include "MIDIPortRemap.h"
+#include "QueryPlan.h"
 #include "Screen.h"
 #include "SysexCommand.h"
 #include "USBHostMIDIDeviceDetail.h"
@@ -26,6 +29,7 @@
 #ifndef Q_MOC_RUN
 #include <boost/algorithm/cxx11/any_of.hpp>
 #endif
+#include <atomic>
 
 using GeneSysLib::CommPtr;
 using GeneSysLib::commandDataKey_t;
@@ -37,6 +41,13 @@ using GeneSysLib::MIDIPortFilter;
 
 extern QMutex sysexMutex;
 
+class MeterPoller;
+class QTimer;
+
+namespace GeneSysLib {
+struct WriteCoalescer;
+}
+
 class DeviceInfo : public QObject {
   Q_OBJECT
  public:
@@ -55,15 +66,38 @@ class DeviceInfo : public QObject {
   bool isNewWindowsDriver();
 #endif
 
-  typedef std::map<commandDataKey_t, commandData_t> CommandDataMap;
+  typedef GeneSysLib::CommandDataStore CommandDataMap;
   typedef CommandDataMap::iterator CommandDataIterator;
 
-  inline void send(const Bytes &sysex) { comm->sendSysex(sysex); }
+  // sent as Interactive requests, which the communicator does not refuse.
+  // If too many are queued the oldest is dropped.
+  inline bool send(const Bytes &sysex) { return comm->sendSysex(sysex); }
 
-  template <typename DATA_T, typename... Ts> void send(Ts... vs) {
-    DATA_T(deviceID, transID, vs...).send(comm);
+  template <typename DATA_T, typename... Ts> bool send(Ts... vs) {
+    return DATA_T(deviceID, transID, vs...).send(comm);
   }
 
+  // Like send() but coalesced per setting, for values that change
+  // continuously such as faders and dials. Call flushWrites() on release.
+  // Every change to a setting written this way goes through write() or
+  // writeNow(), a value sent past the coalescer could be overtaken by an
+  // older one still queued.
+  template <typename DATA_T, typename T> void write(const T &data) {
+    write(data.key(), DATA_T(deviceID, transID, data).sysex());
+  }
+  // for switches such as mute, goes out at once in place of any queued value
+  template <typename DATA_T, typename T> void writeNow(const T &data) {
+    writeNow(data.key(), DATA_T(deviceID, transID, data).sysex());
+  }
+  void flushWrites();
+
+  // Writes linked settings as one transaction. Change the stored settings
+  // and pass copies of them as they were: their Set commands go out back to
+  // back and if the device refuses or misses any of them, those not changed
+  // again since are written and stored back as they were and
+  // writeRolledBack() is emitted, from the GUI thread like the writes.
+  void writeTogether(const std::vector<commandData_t> &before);
+
   bool startQuery(Screen screen, const CommandQList &query);
   bool rereadAudioInfo();
   bool rereadStored();
@@ -71,17 +105,31 @@ class DeviceInfo : public QObject {
   bool rereadMixerControls();
   bool rereadMeters();
 
+  // The plan a query would follow from what is known now. The estimate
+  // counts the messages of the families whose fan-out is already known, the
+  // others are counted in unknownFamilies.
+  GeneSysLib::QueryPlan planQuery(const CommandQList &query) const;
+  int estimateMessages(const GeneSysLib::QueryPlan &plan,
+                       int *unknownFamilies = 0);
+
+  // Device state cache, one file per PID, serial number and firmware version
+  bool loadCache();
+  bool saveCache() const;
+
+  // Meter streaming
+  MeterPoller *meterPoller() const;
+  void startMeterPolling();
+  void stopMeterPolling();
+
   // Command Information
-  void addCommandData(commandData_t commandData);
+  void addCommandData(const commandData_t &commandData);
   bool containsCommandDataType(GeneSysLib::CmdEnum command) const;
   bool containsCommandData(GeneSysLib::CmdEnum command) const;
   bool contains(const commandDataKey_t &key) const;
 
   // generic
   template <typename T> size_t typeCount() const {
-    const auto &lower = storedCommandData.lower_bound(T::minKey());
-    const auto &upper = storedCommandData.upper_bound(T::maxKey());
-    return std::distance(lower, upper);
+    return storedCommandData.count(T::retCommand());
   }
 
   template <typename T> bool containsType() const { return typeCount<T>() > 0; }
@@ -96,8 +144,7 @@ class DeviceInfo : public QObject {
           //printf("%.2X ", *i);
       //printf("\n");
     }*/
-    return MyAlgorithms::contains(
-        storedCommandData,
+    return storedCommandData.contains(
         GeneSysLib::generateKey<Ts...>(T::retCommand(), ts...));
   }
 
@@ -139,37 +186,27 @@ class DeviceInfo : public QObject {
 
   template <typename T, typename Action>
   void for_each(Action action) {
-    auto lower = storedCommandData.lower_bound(T::minKey());
-    const auto &upper = storedCommandData.upper_bound(T::maxKey());
-
-    while (lower != upper) {
-      action(lower->second.template get<T>());
-      ++lower;
-    }
+    storedCommandData.for_each(T::retCommand(), [&](commandData_t &data) {
+      action(data.template get<T>());
+    });
   }
 
   template <typename T, typename Action>
   void for_each(Action action) const {
-    auto lower = storedCommandData.lower_bound(T::minKey());
-    const auto &upper = storedCommandData.upper_bound(T::maxKey());
-
-    while (lower != upper) {
-      action(lower->second.template get<T>());
-      ++lower;
-    }
+    storedCommandData.for_each(T::retCommand(),
+                               [&](const commandData_t &data) {
+      action(data.template get<T>());
+    });
   }
 
   template <typename T, typename UnaryPredicate>
   bool any_of(UnaryPredicate pred) {
-    CommandDataIterator lower = storedCommandData.lower_bound(T::minKey());
-    const auto &upper = storedCommandData.upper_bound(T::maxKey());
     bool result = false;
-    for (; lower != upper; ++lower) {
-      if (pred(lower->second.get<T>())) {
+    for_each<T>([&](T &t) {
+      if ((!result) && (pred(t))) {
         result = true;
-        break;
       }
-    }
+    });
     return result;
   }
 
@@ -204,13 +241,29 @@ class DeviceInfo : public QObject {
 
   void replaceChecksumByte(unsigned char *arr, size_t size);
 
+  // RestoreChanged only writes the entries of a preset that differ from the
+  // state read from the device, RestoreAll writes every entry
+  enum RestoreMode { RestoreAll, RestoreChanged };
+
   Bytes serialize();
-  bool deserialize(Bytes data);
+  // hashChecked skips the MD5 check of a file the caller already verified
+  bool deserialize(Bytes data, RestoreMode mode = RestoreChanged,
+                   bool hashChecked = false);
 
   Bytes serialize2(std::set<GeneSysLib::Command::Enum> commandsToSave, QString description = "");
   Bytes serialize2midi(std::set<GeneSysLib::Command::Enum> commandsToSave, bool reboot);
   bool deserialize2(Bytes data);
 
+  // A version 3 preset, see PresetFile. Each family saved gets a section of
+  // its own, restored before or after the reboot.
+  Bytes serialize3(const std::set<GeneSysLib::Command::Enum> &preReboot,
+                   const std::set<GeneSysLib::Command::Enum> &postReboot,
+                   QString description = "");
+
+  // Restores preset frames already checked, such as the sections read from
+  // a PresetFile
+  void restoreFrames(Bytes frames, RestoreMode mode = RestoreChanged);
+
   std::vector<GeneSysLib::USBHostMIDIDeviceDetail> usbHostMIDIDeviceDetails;
 
   long registerHandler(GeneSysLib::CmdEnum commandID, Handler handler);
@@ -226,9 +279,11 @@ signals:
   void queryStarted();
   void queryCompleted(Screen screen, CommandQList foundItems);
 
+  void writeDiffReady(int changed, int total);
   void writingStarted(int max);
   void writingProgress(int value);
   void writeCompleted();
+  void writeRolledBack();
 
   void sendStart(int msec);
   void sendStop();
@@ -236,6 +291,7 @@ signals:
  public slots:
   void timeout();
   bool sendNextSysex();
+  void pollWrites();
 
  private:
   void registerAllHandlers();
@@ -262,22 +318,52 @@ signals:
 //    sysexMutex.unlock();
   }
 
-  void writeAll();
+  // like addCommand() but onto another queue, estimateMessages() counts
+  // into a scratch one
+  template <typename T, typename... Ts>
+  void queueCommand(std::queue<Bytes> &target, Ts... vs) {
+    target.push(T(deviceID, transID, vs...).sysex());
+  }
+
+  typedef std::map<commandDataKey_t, Bytes> WriteMap;
+  // the settings of a transaction as they were, with the Set command written
+  typedef std::vector<std::pair<commandData_t, Bytes> > RollBack;
+
+  WriteMap generateWrites() const;
+
+  QString cacheFileName() const;
+  bool isCacheable(GeneSysLib::CmdEnum command) const;
+  bool isCached(GeneSysLib::CmdEnum command) const;
+  bool answerFromCache(GeneSysLib::CmdEnum command);
+  void writeChanged(const WriteMap &current,
+                    const std::set<commandDataKey_t> &restored);
+  void fillRequestWindow();
+
+  void createWrites();
+  void write(const commandDataKey_t &key, const Bytes &sysex);
+  void writeNow(const commandDataKey_t &key, const Bytes &sysex);
+  void rollBack(const RollBack &changes);
 
   bool commonHandleCode(DeviceID deviceID, Word transID);
 
   void handleCommandData(GeneSysLib::CmdEnum command, DeviceID deviceID,
-                         Word transID, commandData_t commandData);
+                         Word transID, const commandData_t &commandData);
   void handleUSBHostMIDIDeviceDetailData(GeneSysLib::CmdEnum command,
                                          DeviceID deviceID, Word transID,
-                                         commandData_t commandData);
+                                         const commandData_t &commandData);
   void handleACKData(GeneSysLib::CmdEnum command, DeviceID deviceID,
-                     Word transID, commandData_t commandData);
+                     Word transID, const commandData_t &commandData);
+  void handleQueryACKData(GeneSysLib::CmdEnum command, DeviceID deviceID,
+                          Word transID, const commandData_t &commandData);
 
+  bool isAnswered(GeneSysLib::CmdEnum command) const;
   void addQuerySysex(GeneSysLib::CmdEnum command);
+  void addQuerySysex(GeneSysLib::CmdEnum command, std::queue<Bytes> &target);
 
   Bytes generate(GeneSysLib::CmdEnum command,
                  const commandData_t &commandData) const;
+  size_t generateInto(Bytes &sysex, GeneSysLib::CmdEnum command,
+                      const commandData_t &commandData) const;
 
   CommandDataMap storedCommandData;
 
@@ -287,13 +373,21 @@ signals:
   CommandQList queriedItems;
   Screen queryScreen;
   int maxWriteItems;
-  std::list<GeneSysLib::CmdEnum> currentQuery;
+  GeneSysLib::QueryPlan currentQuery;
   std::map<GeneSysLib::CmdEnum, long> registeredHandlerIDs;
   std::queue<boost::tuple<Screen, std::list<GeneSysLib::CmdEnum> > >
       pendingQueries;
   std::queue<Bytes> sysexMessages;
   std::set<GeneSysLib::CmdEnum> attemptedQueries;
+  std::atomic<bool> restoring;  // ACKs with our transID answer the restore
   CommPtr comm;
+  bool cacheLoaded;
+  GeneSysLib::DeviceStateCache cache;  // guarded by cacheMutex
+  boost::shared_ptr<MeterPoller> meters;
+  boost::shared_ptr<GeneSysLib::WriteCoalescer> writes;
+  QTimer *writeTimer;
+  QMutex rollBackMutex;
+  std::vector<RollBack> rollBacks;  // failed transactions, for pollWrites()
 };
 
 typedef boost::shared_ptr<DeviceInfo> DeviceInfoPtr;
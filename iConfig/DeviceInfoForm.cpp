@@ -198,7 +198,7 @@ void DeviceInfoForm::queryCompleted(Screen sc, CommandQList) {
 }
 
 void DeviceInfoForm::ackCallback(CmdEnum, DeviceID, Word,
-                                 commandData_t commandData) {
+                                 const commandData_t &commandData) {
   const auto& ackData = commandData.get<ACK>();
 
   if ((ackData.commandID() == Command::SetInfo) ||
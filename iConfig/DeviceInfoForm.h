@@ -45,7 +45,7 @@ class DeviceInfoForm : public RefreshObject {
   static QString infoStringTitle(Byte infoID);
   void ackCallback(GeneSysLib::CmdEnum command,
                    GeneSysLib::DeviceID deviceID, Word transID,
-                   GeneSysLib::commandData_t commandData);
+                   const GeneSysLib::commandData_t &commandData);
   void refreshWidget();
 
   //////////////////////////////////////////////////////////////////////////////
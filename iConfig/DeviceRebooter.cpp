@@ -191,7 +191,7 @@ void DeviceRebooter::timerTick() {
 }
 
 void DeviceRebooter::ackHandler(CmdEnum, DeviceID, Word,
-                                commandData_t commandData) {
+                                const commandData_t &commandData) {
   const auto &ackData = commandData.get<ACK>();
    qDebug() << "Get ACK msg";
   if (ackData.commandID() == Command::Reset) {
@@ -203,7 +203,7 @@ void DeviceRebooter::ackHandler(CmdEnum, DeviceID, Word,
   }
 }
 
-void DeviceRebooter::getDeviceHandler(CmdEnum, DeviceID, Word transID, commandData_t commandData)
+void DeviceRebooter::getDeviceHandler(CmdEnum, DeviceID, Word transID, const commandData_t &commandData)
 {
   const auto &devInfo = commandData.get<Device>();
   //qDebug() << "DeviceRebooter::getDeviceHandler called: " << desiredBootMode;
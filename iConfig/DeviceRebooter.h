@@ -41,10 +41,10 @@ slots:
  private:
   void ackHandler(GeneSysLib::CmdEnum command,
                   GeneSysLib::DeviceID deviceID, Word transID,
-                  GeneSysLib::commandData_t commandData);
+                  const GeneSysLib::commandData_t &commandData);
   void getDeviceHandler(GeneSysLib::CmdEnum command,
                         GeneSysLib::DeviceID deviceID, Word transID,
-                        GeneSysLib::commandData_t commandData);
+                        const GeneSysLib::commandData_t &commandData);
 
   long getDeviceHandlerID;
 
@@ -44,8 +44,14 @@ using namespace std;
 
 /* NOTE: I am using the transID to determine which output port I sent the data
  * to. */
-const int DeviceSelectionDialog::kMSecDiscoveryTimeout = 70;
-const int DeviceSelectionDialog::kMSecGetInfoTimeout = 60;
+// how long ports get to answer the discovery broadcast
+const int DeviceSelectionDialog::kMSecDiscoveryTimeout = 300;
+// how long a device gets to answer an info request before it is sent again
+const int DeviceSelectionDialog::kMSecGetInfoTimeout = 250;
+// the pacing of the Windows driver probes
+const int DeviceSelectionDialog::kMSecProbeInterval = 70;
+// how often the deadlines above are checked, not a timeout of its own
+const int DeviceSelectionDialog::kMSecTick = 20;
 
 QWaitCondition waitCondition;
 QMutex mutexQ;
@@ -55,6 +61,9 @@ QMutex deviceMutex;
 DeviceSelectionDialog::DeviceSelectionDialog(CommPtr _comm, QWidget *parent)
     : QDialog(parent),
       started(false),
+      discovering(false),
+      finished(true),
+      nextProbe(0),
       retDeviceHandlerID(-1),
       retCmdListHandlerID(-1),
       retInfoListHandlerID(-1),
@@ -66,10 +75,14 @@ DeviceSelectionDialog::DeviceSelectionDialog(CommPtr _comm, QWidget *parent)
   discoveryTimer = QSharedPointer<QTimer>(new QTimer, &QTimer::deleteLater);
   getInfoTimer = QSharedPointer<QTimer>(new QTimer, &QTimer::deleteLater);
 
-  connect(discoveryTimer.data(), SIGNAL(timeout()), this, SLOT(discoveryTick()),
-          Qt::QueuedConnection);
+  discoveryTimer->setSingleShot(true);
+
+  connect(discoveryTimer.data(), SIGNAL(timeout()), this,
+          SLOT(discoveryTimedOut()), Qt::QueuedConnection);
   connect(getInfoTimer.data(), SIGNAL(timeout()), this, SLOT(getInfoTick()),
           Qt::QueuedConnection);
+  connect(this, SIGNAL(searchFinished()), this, SLOT(finishSearch()),
+          Qt::QueuedConnection);
   connect(this, SIGNAL(deviceDiscovered(QString)), this,
           SLOT(addItemToList(QString)), Qt::QueuedConnection);
   connect(this, SIGNAL(enableButton(bool)),
@@ -180,6 +193,7 @@ void DeviceSelectionDialog::startSearch() {
         discoverAll();
         started = true;
         startDiscoveryTimer();
+        startGetInfoTimer();
       }
     }
     catch (...) {
@@ -239,11 +253,14 @@ void DeviceSelectionDialog::startDiscoveryTimer() {
 void DeviceSelectionDialog::stopDiscoveryTimer() { discoveryTimer->stop(); }
 
 void DeviceSelectionDialog::startGetInfoTimer() {
-  getInfoTimer->start(kMSecGetInfoTimeout);
+  getInfoTimer->start(kMSecTick);
 }
 
 void DeviceSelectionDialog::stopGetInfoTimer() { getInfoTimer->stop(); }
 
+// Every output gets the discovery request at once. Each device that answers
+// gets its own pipeline of info requests on the port it answered on, so the
+// devices are queried side by side.
 void DeviceSelectionDialog::discoverAll() {
   mutexQ.lock();
   int nOuputPorts = comm->getOutCount();
@@ -251,42 +268,77 @@ void DeviceSelectionDialog::discoverAll() {
   //zx, 2017-06-20
   qDebug() << "Communicator Ouput count: " << nOuputPorts;
 
-  for (Word i = 0; i < comm->getOutCount(); ++i) {
-    pendingDiscoverySysex.push(
-        make_pair(i, sysex(GetDeviceCommand(DeviceID(), i))));
+  pendingDiscoverySysex = std::queue<std::pair<unsigned int, Bytes> >();
+  getInfoPipelines.clear();
+  undiscoveredPorts.clear();
+  for (Word i = 0; i < nOuputPorts; ++i) {
+    undiscoveredPorts.insert(i);
   }
+  discovering = true;
+  finished = false;
+  clock.start();
+  nextProbe = 0;
   mutexQ.unlock();
-  sendNextDiscovery();
+
+  for (Word i = 0; i < nOuputPorts; ++i) {
+    comm->streamSysex(i, sysex(GetDeviceCommand(DeviceID(), i)));
+  }
 }
 
-void DeviceSelectionDialog::discoveryTick() {
+void DeviceSelectionDialog::discoveryTimedOut() {
+  // the remaining ports have no device that answers
   mutexQ.lock();
-  bool noPendingDiscovery = pendingDiscoverySysex.empty();
+  discovering = false;
+  undiscoveredPorts.clear();
   mutexQ.unlock();
 
-  if (noPendingDiscovery) {
-    stopDiscoveryTimer();
-    startGetInfoTimer();
-    sendNextGetInfo();
-  } else {
-    sendNextDiscovery();
-  }
+  checkFinished();
 }
 
+// Resends or gives up on unanswered info requests and paces the probes.
 void DeviceSelectionDialog::getInfoTick() {
+  std::vector<std::pair<unsigned int, Bytes> > toSend;
+
   mutexQ.lock();
-  bool noPendingInfo = pendingGetInfoSysex.empty();
+  const qint64 now = clock.elapsed();
+  for (auto &item : getInfoPipelines) {
+    auto &pipeline = item.second;
+    if ((pipeline.waiting) && (pipeline.deadline <= now)) {
+      if (!pipeline.retried) {
+        pipeline.retried = true;
+        pipeline.deadline = now + kMSecGetInfoTimeout;
+        toSend.push_back(make_pair(item.first, pipeline.sent));
+      } else {
+        pipeline.waiting = false;
+        if (takeNextGetInfo(pipeline, now)) {
+          toSend.push_back(make_pair(item.first, pipeline.sent));
+        }
+      }
+    }
+  }
+  if ((!pendingDiscoverySysex.empty()) && (nextProbe <= now)) {
+    toSend.push_back(pendingDiscoverySysex.front());
+    pendingDiscoverySysex.pop();
+    nextProbe = now + kMSecProbeInterval;
+  }
   mutexQ.unlock();
 
-  if (noPendingInfo) {
-    stopSearch();
+  for (const auto &nextPair : toSend) {
+    comm->streamSysex(nextPair.first, nextPair.second);
+  }
 
-    for (auto dev : devices) {
-      emitDevice(dev);
-    }
-    deviceMutex.unlock();
-  } else {
-    sendNextGetInfo();
+  checkFinished();
+}
+
+void DeviceSelectionDialog::finishSearch() {
+  stopSearch();
+
+  deviceMutex.lock();
+  auto found = devices;
+  deviceMutex.unlock();
+
+  for (auto dev : found) {
+    emitDevice(dev);
   }
 }
 
@@ -299,7 +351,7 @@ void DeviceSelectionDialog::addItemToList(QString item) {
 }
 
 void DeviceSelectionDialog::discoveredDeviceCallback(
-    CmdEnum, DeviceID deviceID, Word transID, commandData_t commandData) {
+    CmdEnum, DeviceID deviceID, Word transID, const commandData_t &commandData) {
   auto foundDevice = findDevice(deviceID);
 
   if (!foundDevice) {
@@ -325,16 +377,23 @@ void DeviceSelectionDialog::discoveredDeviceCallback(
 #endif  // WIN32
 // For Windows USB issue <<<<<
 
-    mutexQ.lock();
-    pendingGetInfoSysex.push(
-        make_pair(transID, sysex(GetCommandListCommand(deviceID, transID))));
-    mutexQ.unlock();
+    queueGetInfo(transID, sysex(GetCommandListCommand(deviceID, transID)));
+    sendNextGetInfo(transID);
+  }
+
+  mutexQ.lock();
+  undiscoveredPorts.erase(transID);
+  if (undiscoveredPorts.empty()) {
+    discovering = false;
   }
+  mutexQ.unlock();
+
+  checkFinished();
 }
 
 void DeviceSelectionDialog::commandListCallback(CmdEnum, DeviceID deviceID,
                                                 Word transID,
-                                                commandData_t commandData) {
+                                                const commandData_t &commandData) {
   auto foundDevice = findDevice(deviceID);
 
   //printf("1: %2x, %2X\n", deviceID.pid(), transID);
@@ -345,51 +404,40 @@ void DeviceSelectionDialog::commandListCallback(CmdEnum, DeviceID deviceID,
 
     auto &commandListData = commandData.get<CommandList>();
     if (commandListData.contains(Command::GetMIDIInfo)) {
-      mutexQ.lock();
-      pendingGetInfoSysex.push(
-          make_pair(transID, sysex(GetMIDIInfoCommand(deviceID, transID))));
-      mutexQ.unlock();
+      queueGetInfo(transID, sysex(GetMIDIInfoCommand(deviceID, transID)));
     }
     if (commandListData.contains(Command::GetInfoList)) {
-      mutexQ.lock();
-      pendingGetInfoSysex.push(
-          make_pair(transID, sysex(GetInfoListCommand(deviceID, transID))));
-      mutexQ.unlock();
+      queueGetInfo(transID, sysex(GetInfoListCommand(deviceID, transID)));
     }
     if (commandListData.contains(Command::GetResetList)) {
-      mutexQ.lock();
-      pendingGetInfoSysex.push(
-          make_pair(transID, sysex(GetResetListCommand(deviceID, transID))));
-      mutexQ.unlock();
+      queueGetInfo(transID, sysex(GetResetListCommand(deviceID, transID)));
     }
     if (commandListData.contains(Command::GetSaveRestoreList)) {
-      mutexQ.lock();
-      pendingGetInfoSysex.push(make_pair(
-          transID, sysex(GetSaveRestoreListCommand(deviceID, transID))));
-      mutexQ.unlock();
+      queueGetInfo(transID, sysex(GetSaveRestoreListCommand(deviceID, transID)));
     }
     if (commandListData.contains(Command::GetAudioControlDetail)) {
 
     }
   }
 
-  sendNextGetInfo();
+  sendNextGetInfo(transID);
 }
 
-void DeviceSelectionDialog::commonCallback(CmdEnum, DeviceID deviceID, Word,
-                                           commandData_t commandData) {
+void DeviceSelectionDialog::commonCallback(CmdEnum, DeviceID deviceID,
+                                           Word transID,
+                                           const commandData_t &commandData) {
   auto foundDevice = findDevice(deviceID);
 
   if (foundDevice) {
     foundDevice->addCommandData(commandData);
   }
 
-  sendNextGetInfo();
+  sendNextGetInfo(transID);
 }
 
 void DeviceSelectionDialog::midiInfoCallback(CmdEnum, DeviceID deviceID,
                                              Word transID,
-                                             commandData_t commandData) {
+                                             const commandData_t &commandData) {
   auto foundDevice = findDevice(deviceID);
 
   if (foundDevice) {
@@ -398,21 +446,18 @@ void DeviceSelectionDialog::midiInfoCallback(CmdEnum, DeviceID deviceID,
 
   auto &midiInfo = commandData.get<MIDIInfo>();
   if (midiInfo.numEthernetJacks() > 0) {
-    mutexQ.lock();
     for (int jackID = 1; jackID <= midiInfo.numEthernetJacks(); ++jackID) {
-      pendingGetInfoSysex.push(make_pair(
-          transID,
-          sysex(GetEthernetPortInfoCommand(deviceID, transID, jackID))));
+      queueGetInfo(transID,
+                   sysex(GetEthernetPortInfoCommand(deviceID, transID, jackID)));
     }
-    mutexQ.unlock();
   }
 
-  sendNextGetInfo();
+  sendNextGetInfo(transID);
 }
 
 void DeviceSelectionDialog::infoListCallback(CmdEnum, DeviceID deviceID,
                                              Word transID,
-                                             commandData_t commandData) {
+                                             const commandData_t &commandData) {
   auto foundDevice = findDevice(deviceID);
 
   if (foundDevice) {
@@ -425,31 +470,33 @@ void DeviceSelectionDialog::infoListCallback(CmdEnum, DeviceID deviceID,
       infoListData.contains(InfoID::AccessoryName);
 
   if (containsDeviceName) {
-    mutexQ.lock();
-    pendingGetInfoSysex.push(make_pair(
-        transID, sysex(GetInfoCommand(deviceID, transID, InfoID::DeviceName))));
-    mutexQ.unlock();
+    queueGetInfo(transID,
+                 sysex(GetInfoCommand(deviceID, transID, InfoID::DeviceName)));
   }
 
   if (containsAccessoryName) {
-    mutexQ.lock();
-    pendingGetInfoSysex.push(make_pair(
-        transID,
-        sysex(GetInfoCommand(deviceID, transID, InfoID::AccessoryName))));
-    mutexQ.unlock();
+    queueGetInfo(transID,
+                 sysex(GetInfoCommand(deviceID, transID, InfoID::AccessoryName)));
   }
 
-  sendNextGetInfo();
+  // the device state cache is keyed by the firmware version
+  if (infoListData.contains(InfoID::FirmwareVersion)) {
+    queueGetInfo(transID, sysex(GetInfoCommand(deviceID, transID,
+                                               InfoID::FirmwareVersion)));
+  }
+
+  sendNextGetInfo(transID);
 }
 
-void DeviceSelectionDialog::deviceInfoCallback(CmdEnum, DeviceID deviceID, Word,
-                                               commandData_t commandData) {
+void DeviceSelectionDialog::deviceInfoCallback(CmdEnum, DeviceID deviceID,
+                                               Word transID,
+                                               const commandData_t &commandData) {
   auto foundDevice = findDevice(deviceID);
 
   if (foundDevice) {
     foundDevice->addCommandData(commandData);
   }
-  sendNextGetInfo();
+  sendNextGetInfo(transID);
 }
 
 void DeviceSelectionDialog::on_refreshPushButton_clicked() {
@@ -527,34 +574,64 @@ void DeviceSelectionDialog::emitRecoveryDevice(Word pid) {
   emit enableButton(true);
 }
 
-void DeviceSelectionDialog::sendNextDiscovery() {
+void DeviceSelectionDialog::queueGetInfo(Word transID, const Bytes &sysex) {
   mutexQ.lock();
-  bool pendingMessage = (!pendingDiscoverySysex.empty());
+  getInfoPipelines[transID].pending.push(sysex);
   mutexQ.unlock();
+}
 
-  if (pendingMessage) {
-    mutexQ.lock();
-    auto nextPair = pendingDiscoverySysex.front();
-    pendingDiscoverySysex.pop();
-    mutexQ.unlock();
-    comm->setCurrentOutput(nextPair.first);
-    comm->sendSysex(nextPair.second);
+// Called once a device has answered on its port, sends its next request.
+void DeviceSelectionDialog::sendNextGetInfo(Word transID) {
+  bool send = false;
+  Bytes sysex;
+
+  mutexQ.lock();
+  auto found = getInfoPipelines.find(transID);
+  if (found != getInfoPipelines.end()) {
+    auto &pipeline = found->second;
+    pipeline.waiting = false;
+    send = takeNextGetInfo(pipeline, clock.elapsed());
+    sysex = pipeline.sent;
   }
+  mutexQ.unlock();
+
+  if (send) {
+    comm->streamSysex(transID, sysex);
+  }
+
+  checkFinished();
 }
 
-void DeviceSelectionDialog::sendNextGetInfo() {
+// mutexQ is held by the caller
+bool DeviceSelectionDialog::takeNextGetInfo(GetInfoPipeline &pipeline,
+                                            qint64 now) {
+  if ((pipeline.waiting) || (pipeline.pending.empty())) {
+    return false;
+  }
+
+  pipeline.sent = pipeline.pending.front();
+  pipeline.pending.pop();
+  pipeline.waiting = true;
+  pipeline.retried = false;
+  pipeline.deadline = now + kMSecGetInfoTimeout;
+  return true;
+}
+
+// The search is over once no port is left to answer the discovery and every
+// pipeline has run dry.
+void DeviceSelectionDialog::checkFinished() {
   mutexQ.lock();
-  bool pendingMessage = (!pendingGetInfoSysex.empty());
+  bool done = (!finished) && (!discovering) && (pendingDiscoverySysex.empty());
+  for (const auto &item : getInfoPipelines) {
+    done = done && (!item.second.waiting) && (item.second.pending.empty());
+  }
+  if (done) {
+    finished = true;
+  }
   mutexQ.unlock();
 
-  if (pendingMessage) {
-    mutexQ.lock();
-    auto nextPair = pendingGetInfoSysex.front();
-    pendingGetInfoSysex.pop();
-    mutexQ.unlock();
-
-    comm->setCurrentOutput(nextPair.first);
-    comm->sendSysex(nextPair.second);
+  if (done) {
+    emit searchFinished();
   }
 }
 
@@ -13,6 +13,7 @@
 #include "DeviceInfo.h"
 
 #include <QDialog>
+#include <QElapsedTimer>
 #include <QString>
 #include <QTimer>
 #include <QSharedPointer>
@@ -22,6 +23,8 @@ namespace Ui { class DeviceSelectionDialog; }
 class DeviceSelectionDialog : public QDialog {
   static const int kMSecDiscoveryTimeout;
   static const int kMSecGetInfoTimeout;
+  static const int kMSecProbeInterval;
+  static const int kMSecTick;
 
   Q_OBJECT
 
@@ -50,6 +53,8 @@ class DeviceSelectionDialog : public QDialog {
   void enableButton(bool);
   void enableRefresh(bool);
 
+  void searchFinished();
+
  public slots:
   virtual void accept();
   virtual void reject();
@@ -66,8 +71,9 @@ class DeviceSelectionDialog : public QDialog {
 
   void discoverAll();
 
-  void discoveryTick();
+  void discoveryTimedOut();
   void getInfoTick();
+  void finishSearch();
 
   void addItemToList(QString item);
 
@@ -75,34 +81,52 @@ class DeviceSelectionDialog : public QDialog {
 private:
   void discoveredDeviceCallback(GeneSysLib::CmdEnum command,
                                 GeneSysLib::DeviceID deviceID, Word transID,
-                                GeneSysLib::commandData_t commandData);
+                                const GeneSysLib::commandData_t &commandData);
   void commandListCallback(GeneSysLib::CmdEnum command,
                            GeneSysLib::DeviceID deviceID, Word transID,
-                           GeneSysLib::commandData_t commandData);
+                           const GeneSysLib::commandData_t &commandData);
   void commonCallback(GeneSysLib::CmdEnum command,
                       GeneSysLib::DeviceID deviceID, Word transID,
-                      GeneSysLib::commandData_t commandData);
+                      const GeneSysLib::commandData_t &commandData);
   void midiInfoCallback(GeneSysLib::CmdEnum command,
                         GeneSysLib::DeviceID deviceID, Word transID,
-                        GeneSysLib::commandData_t commandData);
+                        const GeneSysLib::commandData_t &commandData);
   void infoListCallback(GeneSysLib::CmdEnum command,
                         GeneSysLib::DeviceID deviceID, Word transID,
-                        GeneSysLib::commandData_t commandData);
+                        const GeneSysLib::commandData_t &commandData);
   void deviceInfoCallback(GeneSysLib::CmdEnum command,
                           GeneSysLib::DeviceID deviceID, Word transID,
-                          GeneSysLib::commandData_t commandData);
+                          const GeneSysLib::commandData_t &commandData);
 
   void emitSerialNumber(GeneSysLib::DeviceID deviceID);
   void emitRecoveryDevice(Word pid);
 
   void emitDevice(DeviceInfoPtr &device);
 
+  // the info requests of one device, sent one at a time on its port
+  struct GetInfoPipeline {
+    GetInfoPipeline() : waiting(false), retried(false), deadline(0) {}
+
+    std::queue<Bytes> pending;
+    Bytes sent;
+    bool waiting;
+    bool retried;
+    qint64 deadline;
+  };
+
   std::list<DeviceInfoPtr> devices;
   std::queue<std::pair<unsigned int, Bytes> > pendingDiscoverySysex;
-  std::queue<std::pair<unsigned int, Bytes> > pendingGetInfoSysex;
-
-  void sendNextDiscovery();
-  void sendNextGetInfo();
+  std::map<Word, GetInfoPipeline> getInfoPipelines;  // keyed by transID
+  std::set<Word> undiscoveredPorts;
+  bool discovering;
+  bool finished;
+  qint64 nextProbe;
+  QElapsedTimer clock;
+
+  void queueGetInfo(Word transID, const Bytes &sysex);
+  void sendNextGetInfo(Word transID);
+  bool takeNextGetInfo(GetInfoPipeline &pipeline, qint64 now);
+  void checkFinished();
 
   DeviceInfoPtr findDevice(GeneSysLib::DeviceID deviceID);
 
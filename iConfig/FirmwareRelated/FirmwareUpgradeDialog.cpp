@@ -12,17 +12,12 @@
 #include "Reset.h"
 #include "DevicePID.h"
 
-#include <ACK.h>
-
 #include <QDir>
 #include <QFileInfo>
 #include <QIcon>
 #include <QTime>
+#include <QTimerEvent>
 #include <QXmlStreamReader>
-#define CHECK_MD5
-#ifdef CHECK_MD5
-#include <QCryptographicHash>
-#endif
 
 #include <QObject>
 #include <QDialog>
@@ -36,10 +31,10 @@
 #ifndef Q_MOC_RUN
 #include <boost/bind.hpp>
 #endif
+#include <algorithm>
 
-//New feature, zx 2017-03-22
-#define FW_UPDATE_TIMEOUT   90000
-#define FW_UPDATE_TIMEOUT_UPDATEPERIOD   3000
+// msec between updates of the upload progress
+#define FW_PROGRESS_PERIOD   250
 
 using namespace boost;
 using namespace MyAlgorithms;
@@ -50,10 +45,9 @@ FirmwareUpgradeDialog::FirmwareUpgradeDialog(CommPtr _comm,
                                              FirmwareMode::Enum _mode,
                                              QWidget *_parent)
     : QDialog(_parent), ui(new Ui::FirmwareUpgradeDialog), firmwareMode(_mode) {
-  ackRegistered = false;
-
   comm = _comm;
   device = _device;
+  transfer = QSharedPointer<FirmwareTransfer>(new FirmwareTransfer(comm));
   ui->setupUi(this);
 
   Q_ASSERT(comm);
@@ -70,9 +64,6 @@ FirmwareUpgradeDialog::FirmwareUpgradeDialog(CommPtr _comm,
   connect(this, SIGNAL(firmwareUpdateRequired(QString, QString)), this,
           SLOT(downloadFirmware(QString, QString)), Qt::QueuedConnection);
 
-  connect(this, SIGNAL(sendNext()), this, SLOT(messagePump()),
-          Qt::QueuedConnection);
-
   connect(deviceRebooter.data(), SIGNAL(rebootComplete(int)), this,
           SLOT(rebootComplete()));
 
@@ -110,8 +101,8 @@ FirmwareUpgradeDialog::FirmwareUpgradeDialog(CommPtr _comm,
   ui->progressBar->setMaximum(0);
   //New feature, zx 2017-03-23
   ui->timeoutBar->setMinimum(0);
-  ui->timeoutBar->setMaximum(FW_UPDATE_TIMEOUT);
-  m_TimerCount = 0;
+  ui->timeoutBar->setMaximum(kFirmwareStallTimeout);
+  m_progressTimer = 0;
   m_bLocalFile = false;
 
 }
@@ -123,10 +114,9 @@ FirmwareUpgradeDialog::FirmwareUpgradeDialog(GeneSysLib::CommPtr _comm,
                                 QWidget* _parent)
     : QDialog(_parent), ui(new Ui::FirmwareUpgradeDialog), firmwareMode(FirmwareMode::UpgradeMode) //zx,2017-06-19
 {
-  ackRegistered = false;
-
   comm = _comm;
   device = _device;
+  transfer = QSharedPointer<FirmwareTransfer>(new FirmwareTransfer(comm));
   ui->setupUi(this);
 
   Q_ASSERT(comm);
@@ -143,9 +133,6 @@ FirmwareUpgradeDialog::FirmwareUpgradeDialog(GeneSysLib::CommPtr _comm,
   connect(this, SIGNAL(firmwareUpdateRequired(QString, QString)), this,
           SLOT(downloadFirmware(QString, QString)), Qt::QueuedConnection);
 */
-  connect(this, SIGNAL(sendNext()), this, SLOT(messagePump()),
-          Qt::QueuedConnection);
-
   connect(deviceRebooter.data(), SIGNAL(rebootComplete(int)), this,
           SLOT(rebootComplete()));
 
@@ -179,8 +166,8 @@ FirmwareUpgradeDialog::FirmwareUpgradeDialog(GeneSysLib::CommPtr _comm,
   //ui->progressBar->setMaximum(0);
   //New feature, zx 2017-03-23
   ui->timeoutBar->setMinimum(0);
-  ui->timeoutBar->setMaximum(FW_UPDATE_TIMEOUT);
-  m_TimerCount = 0;
+  ui->timeoutBar->setMaximum(kFirmwareStallTimeout);
+  m_progressTimer = 0;
 
 }
 
@@ -249,16 +236,63 @@ void FirmwareUpgradeDialog::ShowFWUpdateDialogForLocalFile()
     }
 }
 
-//bugfixing, zx, 2017-03-22
 void FirmwareUpgradeDialog::timerEvent(QTimerEvent *event) {
-  ++m_TimerCount;
-  int nCurrentTime = m_TimerCount*FW_UPDATE_TIMEOUT_UPDATEPERIOD;
-  ui->timeoutBar->setValue(nCurrentTime);
-  if(FW_UPDATE_TIMEOUT <= nCurrentTime) {
-    this->close();
+  if (event->timerId() != m_progressTimer) {
+    QDialog::timerEvent(event);
+    return;
+  }
+
+  const bool sending = transfer->poll();
+  const auto progress = transfer->progress();
+
+  // the timeout restarts with every block the device takes
+  ui->progressBar->setValue((int)progress.bytesAcked);
+  ui->timeoutBar->setValue(
+      (int)std::min<qint64>(progress.sinceAnswer, kFirmwareStallTimeout));
+
+  QString status = tr("Loading firmware, %1 of %2 KB")
+                       .arg((qulonglong)progress.bytesAcked / 1024)
+                       .arg((qulonglong)progress.bytes / 1024);
+  if (progress.bytesPerSecond > 0.0) {
+    status += tr(", %1 KB/s").arg(progress.bytesPerSecond / 1024.0, 0, 'f', 1);
+  }
+  if (progress.remaining >= 0) {
+    status += tr(", %1 s left").arg((progress.remaining + 999) / 1000);
+  }
+  ui->statusLabel->setText(status);
+
+  if (sending) {
+    return;
   }
-}
 
+  killTimer(m_progressTimer);
+  m_progressTimer = 0;
+
+  if (transfer->state() == FirmwareTransfer::Complete) {
+    // DONE
+    QMessageBox::information(this, "Complete", "Upgrade Complete");
+
+    device->send<ResetCommand>(BootMode::AppMode);
+
+    this->accept();
+  } else if (transfer->state() == FirmwareTransfer::Failed) {
+    // the blocks the device took are kept, carry on from the first it did not
+    const int percent =
+        (progress.bytes > 0) ? (int)(progress.bytesAcked * 100 / progress.bytes)
+                             : 0;
+    if (QMessageBox::question(
+            this, tr("Firmware upgrade stalled"),
+            tr("The device stopped answering at %1%.\n\n"
+               "Do you want to continue the upgrade from there?")
+                .arg(percent),
+            QMessageBox::No, QMessageBox::Yes) == QMessageBox::Yes) {
+      transfer->resume();
+      m_progressTimer = startTimer(FW_PROGRESS_PERIOD);
+    } else {
+      this->close();
+    }
+  }
+}
 
 //Bugfixing for new download website, zx 2017-03-03
 void FirmwareUpgradeDialog::reQueryDownloadSite() {
@@ -409,61 +443,16 @@ void FirmwareUpgradeDialog::parseXML(QString xml) {
 }
 
 void FirmwareUpgradeDialog::parseMIDI(QByteArray midi) {
-  sysexMessages.clear();
-
-// Check the MD5
-#ifdef CHECK_MD5
-  // create the MD5 hash container
-  QCryptographicHash md5Hash(QCryptographicHash::Md5);
-  md5Hash.reset();
-
-  // get the stored MD5
-  QByteArray storedMD5;
-  unsigned char startOfMD5[] = { 0xFF, 0x7F, 0x14, 0x00, 0x01, 0x73, 0x00 };
-
-  int md5Index = midi.indexOf((char *)startOfMD5);
-
-  if ((md5Index != -1) && ((md5Index + (int) sizeof(startOfMD5) + 16) < midi.size())) {
-    // 16 hexadecimal digits MD5
-    storedMD5 = midi.mid(md5Index + sizeof(startOfMD5), 16);
-  }
-#endif
-
-  // Look for the header
-  int startIndex = 0;
-  int endIndex = 0;
-
-  while ((startIndex = midi.indexOf(0xF0, startIndex)) != -1) {
-    if (((endIndex = midi.indexOf(0xF7, startIndex)) != -1) &&
-        ((endIndex - startIndex) > 0)) {
-      auto sysex = midi.mid(startIndex, (endIndex - startIndex) + 1);
-
-#ifdef CHECK_MD5
-      md5Hash.addData(sysex);
-#endif
-
-      if (sysex.size() > 2) {
-        // removed length byte (midi file only) before transmission
-        sysex.remove(1, 1);
-        sysexMessages.append(sysex);
-      }
-    }
-
-    // slightly improve the search
-    startIndex = endIndex;
-  }
-
-#ifdef CHECK_MD5
-  auto calculatedMD5 = md5Hash.result();
-  if ((storedMD5.size() == calculatedMD5.size()) &&
-      (calculatedMD5 != storedMD5)) {
+  // the sysex events are read into the transfer's frame table and checked
+  // against the MD5 the file carries
+  if (!transfer->load((const Byte *)midi.constData(), midi.size())) {
     if(m_bLocalFile == false)
     {
         QMessageBox::critical(this, tr("File Corrupt."), tr("The downloaded firmware file is corrupted. Please try again."));
     }
     else
     {
-      QMessageBox::critical(this, tr("File Corrupt."), tr("The local firmware file, ") + m_bLocalFile + tr(", is corrupted. Please try other file."));
+      QMessageBox::critical(this, tr("File Corrupt."), tr("The local firmware file, ") + m_LocalFirmwareFile + tr(", is corrupted. Please try other file."));
     }
     close();
   } else {
@@ -476,15 +465,6 @@ void FirmwareUpgradeDialog::parseMIDI(QByteArray midi) {
       rebootComplete();
     }
   }
-#else
-  if ((firmwareMode == FirmwareMode::UpgradeMode) ||
-      (firmwareMode == FirmwareMode::CheckMode)) {
-    deviceRebooter->reboot(BootMode::BootLoaderMode);
-  } else if (firmwareMode == FirmwareMode::RecoveryMode) {
-    // No reboot required
-    rebootComplete();
-  }
-#endif
 }
 
 void FirmwareUpgradeDialog::checkFirmware() {
@@ -597,45 +577,16 @@ void FirmwareUpgradeDialog::checkFirmware() {
   }
 }
 
-void FirmwareUpgradeDialog::handleACK(CmdEnum, DeviceID, Word,
-                                      commandData_t _commandData) {
-  const auto &ackData = _commandData.get<ACK>();
-  if (ackData.errorCode() == 0) {
-    // wait a bit then try to connect to a new device
-    emit sendNext();
-  }
-}
-
 void FirmwareUpgradeDialog::rebootComplete() {
-  ui->statusLabel->setText(tr("Reboot complete. Loading firmware."));
-  ui->progressBar->setMaximum(sysexMessages.count());
-
-  messagePump();
-}
-
-void FirmwareUpgradeDialog::messagePump() {
-  if (!ackRegistered) {
-    auto ackBind =
-        bind(&FirmwareUpgradeDialog::handleACK, this, _1, _2, _3, _4);
-    comm->registerExclusiveHandler(Command::ACK, ackBind);
-    ackRegistered = true;
+  if (m_progressTimer != 0) {
+    return;
   }
 
-  if (sysexMessages.size() > 0) {
-    const auto &sysex = sysexMessages.first();
-    const auto &message = Bytes(sysex.begin(), sysex.end());
-    sysexMessages.removeFirst();
-    comm->sendSysex(message);
-
-    ui->progressBar->setValue(ui->progressBar->maximum() - sysexMessages.size());
-  } else {
-    // DONE
-    QMessageBox::information(this, "Complete", "Upgrade Complete");
-
-    comm->unRegisterExclusiveHandler();
-
-    device->send<ResetCommand>(BootMode::AppMode);
+  ui->statusLabel->setText(tr("Reboot complete. Loading firmware."));
+  ui->progressBar->setMinimum(0);
+  ui->progressBar->setMaximum((int)transfer->progress().bytes);
+  ui->progressBar->setValue(0);
 
-    this->accept();
-  }
+  transfer->start();
+  m_progressTimer = startTimer(FW_PROGRESS_PERIOD);
 }
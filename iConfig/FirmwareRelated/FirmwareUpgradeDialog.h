@@ -12,6 +12,7 @@
 #include "DeviceID.h"
 #include "DeviceInfo.h"
 #include "DeviceRebooter.h"
+#include "FirmwareTransfer.h"
 
 #include <QList>
 #include <QMap>
@@ -58,7 +59,6 @@ class FirmwareUpgradeDialog : public QDialog {
   void firmwareUpToDate(QString version);
   void firmwareUpdateRequired(QString version, QString url);
   void checkComplete();
-  void sendNext();
   void redirectDownloadURL();//Bugfixing for new download website, zx 2017-03-03
   void firmwareUpdateTimeOut(); //Fixed timeout signal issue, zx, 2017-06-19
 
@@ -67,7 +67,6 @@ class FirmwareUpgradeDialog : public QDialog {
   void downloadFirmware(QString version, QString url);
 
   void rebootComplete();
-  void messagePump();
 
   void reQueryDownloadSite();//Bugfixing for new download website, zx 2017-03-03
 
@@ -76,8 +75,6 @@ class FirmwareUpgradeDialog : public QDialog {
   void parseXML(QString xml);
   void parseMIDI(QByteArray midi);
   void checkFirmware();
-  void handleACK(GeneSysLib::CmdEnum command, GeneSysLib::DeviceID deviceID,
-                 Word transID, GeneSysLib::commandData_t commandData);
 
   QSharedPointer<Ui::FirmwareUpgradeDialog> ui;
   GeneSysLib::CommPtr comm;
@@ -89,12 +86,10 @@ class FirmwareUpgradeDialog : public QDialog {
   std::vector<std::pair<Bytes, Word> > searchList;
 
   QList<QMap<QString, QString> > firmwareList;
-  QList<QByteArray> sysexMessages;
+  QSharedPointer<GeneSysLib::FirmwareTransfer> transfer;
 
   QMessageBox *noUpgradeNeeded;
 
-  bool ackRegistered;
-
   QSharedPointer<DeviceRebooter> deviceRebooter;
 
   QString m_downloadURL;
@@ -102,9 +97,9 @@ class FirmwareUpgradeDialog : public QDialog {
   QString m_LocalFirmwareFile;
   bool    m_bLocalFile;
 protected:
-  //bugfixing, zx, 2017-03-22
+  // polls the transfer and shows its progress
     void timerEvent(QTimerEvent *event);
-    int  m_TimerCount;
+    int  m_progressTimer;
 };
 
 #endif  // FIRMWAREUPGRADEDIALOG_H
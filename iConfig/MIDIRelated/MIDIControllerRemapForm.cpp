@@ -297,7 +297,7 @@ void MIDIControllerRemapForm::dstComboBoxChanged(int row) {
 }
 
 void MIDIControllerRemapForm::ackCallback(CmdEnum, DeviceID, Word,
-                                          commandData_t commandData) {
+                                          const commandData_t &commandData) {
   const auto &ackData = commandData.get<ACK>();
   if (ackData.commandID() == Command::SetMIDIPortRemap) {
     emit requestRefresh();
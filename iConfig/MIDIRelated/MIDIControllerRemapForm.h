@@ -44,7 +44,7 @@ class MIDIControllerRemapForm : public RefreshObject {
 
  private:
   void ackCallback(GeneSysLib::CmdEnum, GeneSysLib::DeviceID, Word,
-                   GeneSysLib::commandData_t);
+                   const GeneSysLib::commandData_t &);
   long ackHandlerID;
 
   BlockState::Enum stateForCell(int row, int col) const;
@@ -594,7 +594,7 @@ void MIDIInfoForm::refreshWidget() {
 /// user message)
 ////////////////////////////////////////////////////////////////////////////////
 void MIDIInfoForm::ackCallback(CmdEnum, DeviceID, Word,
-                               commandData_t _commandData) {
+                               const commandData_t &_commandData) {
   const auto& ackData = _commandData.get<ACK>();
   if (ackData.commandID() == Command::SetInfo) {  // update set info
     emit updateMessage(
@@ -114,7 +114,7 @@ class MIDIInfoForm : public RefreshObject {
   //////////////////////////////////////////////////////////////////////////////
   void refreshWidget();
   void ackCallback(GeneSysLib::CmdEnum command, GeneSysLib::DeviceID deviceID,
-                   Word transID, commandData_t commandData);
+                   Word transID, const commandData_t &commandData);
 
   QTreeWidgetItem *addGeneralMIDIInformation(QTreeWidget *parent,
                                              const MIDIInfo &midiInfo);
@@ -404,7 +404,7 @@ BlockState::Enum MIDIPortFiltersForm::stateForCell(int row, int col) const {
 /// The ACK callback
 ////////////////////////////////////////////////////////////////////////////////
 void MIDIPortFiltersForm::ackCallback(CmdEnum, DeviceID, Word,
-                                      commandData_t commandData) {
+                                      const commandData_t &commandData) {
   const auto &ackData = commandData.get<ACK>();
   if (ackData.commandID() == Command::SetMIDIPortFilter) {
     emit requestRefresh();
@@ -36,7 +36,7 @@ class MIDIPortFiltersForm : public RefreshObject {
 
  private:
   void ackCallback(GeneSysLib::CmdEnum command, GeneSysLib::DeviceID deviceID,
-                   Word transID, GeneSysLib::commandData_t commandData);
+                   Word transID, const GeneSysLib::commandData_t &commandData);
   bool isCellSet(int row, int col, int portID) const;
   BlockState::Enum stateForCell(int row, int col) const;
   GeneSysLib::FilterIDEnum currentFilterID() const;
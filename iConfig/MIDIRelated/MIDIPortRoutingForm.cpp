@@ -466,7 +466,7 @@ void MIDIPortRoutingForm::addLabel(int row, int col, MIDIPortInfo portInfo) {
 /// The method that gets called when the system receives an ACK command.
 ////////////////////////////////////////////////////////////////////////////////
 void MIDIPortRoutingForm::ackCallback(CmdEnum, DeviceID, Word,
-                                      commandData_t commandData) {
+                                      const commandData_t &commandData) {
   // cast the command data to the ACK data type
   const auto &ackData = commandData.get<ACK>();
 
@@ -53,7 +53,7 @@ class MIDIPortRoutingForm : public RefreshObject {
   void addLabel(int row, int col, GeneSysLib::MIDIPortInfo portInfo);
   void ackCallback(GeneSysLib::CmdEnum command,
                    GeneSysLib::DeviceID deviceID, Word transID,
-                   GeneSysLib::commandData_t commandData);
+                   const GeneSysLib::commandData_t &commandData);
   bool portRouted(Word srcPortID, Word destPortID) const;
   BlockState::Enum cellState(int row, int col) const;
 
@@ -37,11 +37,14 @@
 #include "DeviceInfoForm.h"
 #include "DeviceInformationDialog.h"
 #include "DeviceSelectionDialog.h"
+#include "MeterPoller.h"
 #include "MyAlgorithms.h"
 #include "Reset.h"
 #include "ResetList.h"
 #include "SaveRestore.h"
+#include "VirtualDevice.h"
 #include "Presets/ICRestoreDialog.h"
+#include "Presets/PresetFile.h"
 #include "Presets/ICSaveDialog.h"
 #include "FirmwareRelated/FirmwareCheckDialog.h"
 
@@ -83,6 +86,20 @@ MainWindow::MainWindow(QWidget* parent)
     basicMode(false),
     connected(false) {
   ui->setupUi(this);
+
+  // run against a device simulated from a preset or device cache file
+  const QString virtualDevice = qgetenv("ICONFIG_VIRTUAL_DEVICE");
+  if (!virtualDevice.isEmpty()) {
+    QFile file(virtualDevice);
+    if (file.open(QFile::ReadOnly)) {
+      const QByteArray data = file.readAll();
+      VirtualDevicePtr device(new VirtualDevice());
+      if (device->load(Bytes(data.begin(), data.end()))) {
+        comm->setTransport(device);
+      }
+    }
+  }
+
   //Re-factory device selection UI functions, zx, 2017-04-06
   m_FirstSelectedDevice = false;
   continuedOpeningFileName = "";
@@ -114,7 +131,7 @@ MainWindow::MainWindow(QWidget* parent)
   auto handler = boost::bind(&MainWindow::ackCallback, this, _1, _2, _3, _4);
   ackHandler = comm->registerHandler(Command::ACK, handler);
 
-  refreshMetersTimer = refreshAudioControlsTimer = 0;
+  refreshAudioControlsTimer = 0;
   devInfoDialog = 0;
 
   readSettings();
@@ -135,8 +152,8 @@ MainWindow::~MainWindow() {
   if (refreshAudioControlsTimer != 0)
     refreshAudioControlsTimer->stop();
 
-  if (refreshMetersTimer != 0)
-    refreshMetersTimer->stop();
+  if (currentDevice)
+    currentDevice->stopMeterPolling();
 
   comm->unRegisterHandler(Command::ACK, ackHandler);
   comm->m_parser = 0; // fix crash on exit off audio controls screen.
@@ -239,6 +256,8 @@ void MainWindow::ReconnectPreviousOpenDevice(DeviceInfoPtr prevDevice) {
                 Qt::QueuedConnection);
         connect(currentDevice.get(), SIGNAL(writingStarted(int)), this,
                 SLOT(writingStarted(int)));
+        connect(currentDevice.get(), SIGNAL(writeDiffReady(int, int)), this,
+                SLOT(writeDiffReady(int, int)));
         connect(currentDevice.get(), SIGNAL(writingProgress(int)), this,
                 SLOT(writingProgress(int)));
         connect(currentDevice.get(), SIGNAL(writeCompleted()), this,
@@ -262,6 +281,9 @@ void MainWindow::ReconnectPreviousOpenDevice(DeviceInfoPtr prevDevice) {
            showErrorWithTitleAndMsg("Bootloader Mode Device", "Bootloader Moder device needs firmware upgrade either from iConfig or manually.", true);
            QApplication::quit();
         } else {
+          // the static families are answered from the device state cache
+          currentDevice->loadCache();
+
           deviceInfo_triggered();
 
           if (continuedOpeningFileName == "") {
@@ -321,8 +343,10 @@ void MainWindow::on_actionClose_triggered() {
   if (refreshAudioControlsTimer)
     refreshAudioControlsTimer->stop();
 
-  if (refreshMetersTimer)
-    refreshMetersTimer->stop();
+  if (currentDevice) {
+    currentDevice->stopMeterPolling();
+    currentDevice->saveCache();
+  }
 
   // Clear the selection
   currentDevice.reset(new DeviceInfo(comm));
@@ -355,6 +379,8 @@ void MainWindow::on_actionClose_triggered() {
                   Qt::QueuedConnection);
           connect(currentDevice.get(), SIGNAL(writingStarted(int)), this,
                   SLOT(writingStarted(int)));
+          connect(currentDevice.get(), SIGNAL(writeDiffReady(int, int)), this,
+                  SLOT(writeDiffReady(int, int)));
           connect(currentDevice.get(), SIGNAL(writingProgress(int)), this,
                   SLOT(writingProgress(int)));
           connect(currentDevice.get(), SIGNAL(writeCompleted()), this,
@@ -376,6 +402,9 @@ void MainWindow::on_actionClose_triggered() {
                     SLOT(on_actionClose_triggered()));
             firmwareDialog->showNormal();
           } else {
+            // the static families are answered from the device state cache
+            currentDevice->loadCache();
+
             deviceInfo_triggered();
 
             if (continuedOpeningFileName == "") {
@@ -946,15 +975,18 @@ void MainWindow::queryCompleted(Screen screen, CommandQList) {
         ui->centralWidget->layout()->addWidget(devInfoForm);
         devInfoAction->setChecked(true);
 
+        ICRestoreDialog* restore = 0;  // checks the hash once per change
+        bool continuing = false;   // the device is back from the preset's reboot
         if (continuedOpeningFileName != "") {
           fileName = continuedOpeningFileName;
           continuedOpeningFileName = "";
           rebootMe = false;
+          continuing = true;
         }
         else {
           //Bugfixing, zx-03-27
           qDebug() << "Open preset UI to load";
-          ICRestoreDialog* restore = new ICRestoreDialog(currentDevice, this);
+          restore = new ICRestoreDialog(currentDevice, this);
           if (restore->exec() == QDialog::Accepted) {
             fileName = restore->getFileName();
           }
@@ -964,32 +996,69 @@ void MainWindow::queryCompleted(Screen screen, CommandQList) {
         }
 
         if (!fileName.isEmpty()) {
-          QFile file(fileName);
-          QFile file2(fileName + ".aux");
-          if (file2.exists()) {
-            continuedOpeningFileName = fileName + ".aux";
-            rebootMe = true;
-            printf("setting rebootMe to true!\n");
+          bool restored = false;
+          Bytes preData;
+
+          PresetFile preset(fileName);
+          if ((preset.open()) && (preset.version() >= kPresetVersion3)) {
+            // both stages are in the file, the post-reboot sections are
+            // restored once the device is back
+            const bool postReboot =
+                continuing || (!preset.hasStage(PresetFile::PreReboot));
+
+            ui->statusBar->showMessage(tr("Opening file..."), 3000);
+            preData = currentDevice->serialize2(getPreRebootCommands(), "");
+
+            // a preset of another model is not restored
+            Bytes frames;
+            restored = (preset.pid() == (Byte)currentDevice->getPID()) &&
+                       (preset.read(postReboot ? PresetFile::PostReboot
+                                               : PresetFile::PreReboot,
+                                    std::set<GeneSysLib::CmdEnum>(), frames));
+            if (restored) {
+              // the device reboots after the pre-reboot stage even when
+              // nothing is left for after it
+              if (!postReboot) {
+                continuedOpeningFileName = fileName;
+                rebootMe = true;
+              }
+              currentDevice->restoreFrames(frames);
+            }
           }
+          else {
+            preset.close();
+
+            QFile file(fileName);
+            QFile file2(fileName + ".aux");
+            if (file2.exists()) {
+              continuedOpeningFileName = fileName + ".aux";
+              rebootMe = true;
+              printf("setting rebootMe to true!\n");
+            }
 
-          //Bugfixing, zx-03-27
-          qDebug() << "Preset file to open:" << continuedOpeningFileName;
+            //Bugfixing, zx-03-27
+            qDebug() << "Preset file to open:" << continuedOpeningFileName;
 
-          if (!file.open(QFile::ReadWrite)) {
-            QMessageBox::warning(this, tr("Open Failed"),
-                                 tr("Cannot write file %1:\n%2.").arg(fileName)
-                                 .arg(file.errorString()));
-            return;
-          }
+            if (!file.open(QFile::ReadWrite)) {
+              QMessageBox::warning(this, tr("Open Failed"),
+                                   tr("Cannot write file %1:\n%2.").arg(fileName)
+                                   .arg(file.errorString()));
+              return;
+            }
 
-          QByteArray qData = file.readAll();
-          file.close();
+            QByteArray qData = file.readAll();
+            file.close();
 
-          Bytes data = Bytes(qData.begin(), qData.end());
+            Bytes data = Bytes(qData.begin(), qData.end());
+            const bool hashChecked = (restore) && (restore->isVerified(qData));
 
-          ui->statusBar->showMessage(tr("Opening file..."), 3000);
-          Bytes preData = currentDevice->serialize2(getPreRebootCommands(), "");
-          if (!currentDevice->deserialize(data)) {
+            ui->statusBar->showMessage(tr("Opening file..."), 3000);
+            preData = currentDevice->serialize2(getPreRebootCommands(), "");
+            restored = currentDevice->deserialize(data, DeviceInfo::RestoreChanged,
+                                                  hashChecked);
+          }
+
+          if (!restored) {
             ui->statusBar->showMessage(tr("File read error."), 3000);
             QMessageBox msgBox;
             msgBox.setText(tr("Could not read file"));
@@ -1120,12 +1189,10 @@ void MainWindow::queryCompleted(Screen screen, CommandQList) {
       }
       refreshAudioControlsTimer->start(500);
 
-      if (refreshMetersTimer == 0) {
-        refreshMetersTimer = new QTimer(this);
-        refreshMetersTimer->setSingleShot(true);
-        connect(refreshMetersTimer, SIGNAL(timeout()), this, SLOT(rereadMeters()));
-      }
-      refreshMetersTimer->start(150);
+      connect(currentDevice->meterPoller(), SIGNAL(metersUpdated()), this,
+              SIGNAL(refreshMeters()),
+              Qt::ConnectionType(Qt::QueuedConnection | Qt::UniqueConnection));
+      currentDevice->startMeterPolling();
 
       enableAudioMixerAction();
       m_WarningState = WMSG_UNSPECIFIED;//zx, 2017-04-26
@@ -1143,14 +1210,11 @@ void MainWindow::queryCompleted(Screen screen, CommandQList) {
 void MainWindow::doneAudioRefresh() {
   if (refreshAudioControlsTimer)
     refreshAudioControlsTimer->start(500);
-  if (refreshMetersTimer)
-    if (!refreshMetersTimer->isActive())
-      refreshMetersTimer->start(150);
 }
 
 void MainWindow::doneMetersRefresh() {
-  if (refreshMetersTimer)
-    refreshMetersTimer->start(150);
+  if (currentDevice)
+    currentDevice->meterPoller()->acknowledge();
 }
 
 void MainWindow::requestRefresh() { emit refreshAll(); }
@@ -1407,6 +1471,15 @@ void MainWindow::writingStarted(int max) {
   ui->statusBar->showMessage(tr("Writing settings to device"));
 }
 
+void MainWindow::writeDiffReady(int changed, int total) {
+  const QString message =
+      tr("Writing %1 of %2 settings to device").arg(changed).arg(total);
+  if (progressDialog) {
+    progressDialog->setLabelText(message);
+  }
+  ui->statusBar->showMessage(message);
+}
+
 void MainWindow::writingProgress(int value) {
   if (progressDialog) {
     progressDialog->setValue(value);
@@ -1452,8 +1525,8 @@ void MainWindow::showConnectionError() {
   if (refreshAudioControlsTimer != 0)
     refreshAudioControlsTimer->stop();
 
-  if (refreshMetersTimer != 0)
-    refreshMetersTimer->stop();
+  if (currentDevice)
+    currentDevice->stopMeterPolling();
 
   if (currentDevice) {
     QTimer::singleShot(10, currentDevice.get(), SLOT(timeout()));
@@ -1476,8 +1549,8 @@ void MainWindow::showErrorWithTitleAndMsg(QString title, QString msg, bool bShut
   if (refreshAudioControlsTimer != 0)
     refreshAudioControlsTimer->stop();
 
-  if (refreshMetersTimer != 0)
-    refreshMetersTimer->stop();
+  if (currentDevice)
+    currentDevice->stopMeterPolling();
 
   if (currentDevice) {
     QTimer::singleShot(10, currentDevice.get(), SLOT(timeout()));
@@ -1517,7 +1590,7 @@ QString MainWindow::extensionForPID(Word pid) {
 }
 
 void MainWindow::ackCallback(CmdEnum, DeviceID, Word,
-                             commandData_t commandData) {
+                             const commandData_t &commandData) {
   const auto& ackData = commandData.get<ACK>();
   switch (ackData.commandID()) {
   case Command::SaveRestore: {
@@ -1558,13 +1631,6 @@ void MainWindow::rereadAudioControls() {
   }
 }
 
-void MainWindow::rereadMeters() {
-  progressBar->hide();
-  if (currentDevice) {
-    currentDevice->rereadMeters();
-  }
-}
-
 void MainWindow::on_actionReread_Settings_triggered() {
   if ((!connected) || (currentDevice)) {
     currentDevice->rereadStored();
@@ -1583,6 +1649,15 @@ void MainWindow::onTimeout() {
 
 void MainWindow::closeEvent(QCloseEvent* event) {
   writeSettings();
+  if (currentDevice) {
+    currentDevice->saveCache();
+  }
+
+  // per command traffic of the session, for tuning query and polling rates
+  const QString metricsFile = qgetenv("ICONFIG_METRICS");
+  if ((comm) && (!metricsFile.isEmpty())) {
+    comm->saveMetrics(metricsFile.toStdString());
+  }
   event->accept();
 }
 
@@ -1636,8 +1711,8 @@ void MainWindow::closeAllInTime() {
   if (refreshAudioControlsTimer)
     refreshAudioControlsTimer->stop();
 
-  if (refreshMetersTimer)
-    refreshMetersTimer->stop();
+  if (currentDevice)
+    currentDevice->stopMeterPolling();
 
   clearLayout(ui->centralWidget->layout());
   clearToolBar();
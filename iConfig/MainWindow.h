@@ -70,7 +70,6 @@ private slots:
 
   void requestRefresh();
   void rereadAudioControls();
-  void rereadMeters();
 
   void enableDevInfoAction();
   void enableMidiInfoAction();
@@ -88,6 +87,7 @@ private slots:
   void updateDeviceMenu();
 
   void writingStarted(int max);
+  void writeDiffReady(int changed, int total);
   void writingProgress(int value);
   void writingCompleted();
 
@@ -128,7 +128,7 @@ private slots:
   void createActions();
   void startSave(Screen screen);
   void ackCallback(GeneSysLib::CmdEnum, GeneSysLib::DeviceID, Word,
-                   GeneSysLib::commandData_t commandData);
+                   const GeneSysLib::commandData_t &commandData);
 
   void writeSettings();
   void readSettings();
@@ -176,7 +176,6 @@ private slots:
   bool rebootMe;
 
   QTimer *refreshAudioControlsTimer;
-  QTimer *refreshMetersTimer;
   void clearLayout(QLayout *layout);
   bool ensureAudioInfoSave();
 
@@ -0,0 +1,316 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "MeterPoller.h"
+
+#include "AudioPortMeterValue.h"
+#include "MixerMeterValue.h"
+
+#ifndef Q_MOC_RUN
+#include <boost/bind.hpp>
+#endif
+#include <QElapsedTimer>
+#include <algorithm>
+
+using namespace GeneSysLib;
+using namespace std;
+
+namespace {
+
+bool requestLess(const MeterPoller::Request &lhs,
+                 const MeterPoller::Request &rhs) {
+  return lhs.key < rhs.key;
+}
+
+}  // namespace
+
+MeterPoller::MeterPoller(CommPtr _comm, QObject *_parent)
+    : QThread(_parent),
+      comm(_comm),
+      deviceID(),
+      requests(),
+      keys(),
+      front(0),
+      pendingUpdate(false),
+      audioHandlerID(-1),
+      mixerHandlerID(-1),
+      period(1000 / kMeterRate),
+      maxInFlight(kMeterBudget),
+      stopping(false),
+      inFlight(0),
+      answeredCount(0),
+      cycle(0),
+      sentIn(),
+      sentAt() {}
+
+MeterPoller::~MeterPoller() { stopPolling(); }
+
+void MeterPoller::setRate(int hz) { period = 1000 / max(hz, 1); }
+
+int MeterPoller::rate() const { return 1000 / period; }
+
+void MeterPoller::setBudget(int _budget) { maxInFlight = max(_budget, 1); }
+
+int MeterPoller::budget() const { return maxInFlight; }
+
+void MeterPoller::startPolling(DeviceID _deviceID,
+                               std::vector<Request> _requests) {
+  stopPolling();
+
+  deviceID = _deviceID;
+  requests.swap(_requests);
+  sort(requests.begin(), requests.end(), requestLess);
+
+  keys.clear();
+  for (const auto &request : requests) {
+    keys.push_back(request.key);
+  }
+
+  // value initialized so unanswered meters read as silent
+  buffers[0].reset(new MeterSlot[requests.size()]());
+  buffers[1].reset(new MeterSlot[requests.size()]());
+  front.store(0);
+  pendingUpdate.store(false);
+
+  inFlight = 0;
+  cycle = 0;
+  sentIn.assign(requests.size(), 0);
+  sentAt.assign(requests.size(), 0);
+
+  if (requests.empty()) {
+    return;
+  }
+
+  audioHandlerID = comm->registerHandler(
+      Command::RetAudioPortMeterValue,
+      boost::bind(&MeterPoller::handleMeters, this, _1, _2, _3, _4));
+  mixerHandlerID = comm->registerHandler(
+      Command::RetMixerMeterValue,
+      boost::bind(&MeterPoller::handleMeters, this, _1, _2, _3, _4));
+
+  stopping = false;
+  start();
+}
+
+void MeterPoller::stopPolling() {
+  mutex.lock();
+  stopping = true;
+  answered.wakeAll();
+  mutex.unlock();
+
+  wait();
+
+  if (audioHandlerID >= 0) {
+    comm->unRegisterHandler(Command::RetAudioPortMeterValue, audioHandlerID);
+    audioHandlerID = -1;
+  }
+  if (mixerHandlerID >= 0) {
+    comm->unRegisterHandler(Command::RetMixerMeterValue, mixerHandlerID);
+    mixerHandlerID = -1;
+  }
+}
+
+void MeterPoller::acknowledge() { pendingUpdate.store(false); }
+
+Word MeterPoller::audioPortMeter(Word audioPortID, int blockIndex,
+                                 int meterIndex) const {
+  return meter(AudioPortMeterValue::queryKey(audioPortID), blockIndex,
+               meterIndex);
+}
+
+Word MeterPoller::mixerInputMeter(Word audioPortID, Byte mixerOutputNumber,
+                                  Byte mixerInputNumber) const {
+  return meter(MixerMeterValue::queryKey(audioPortID, mixerOutputNumber), 0,
+               mixerInputNumber - 1);
+}
+
+Word MeterPoller::mixerOutputMeter(Word audioPortID,
+                                   Byte mixerOutputNumber) const {
+  return meter(MixerMeterValue::queryKey(audioPortID, mixerOutputNumber), 1,
+               0);
+}
+
+void MeterPoller::run() {
+  QElapsedTimer clock;
+  QElapsedTimer polling;
+  polling.start();
+
+  mutex.lock();
+  while (!stopping) {
+    clock.start();
+    answeredCount = 0;
+    ++cycle;
+
+    // Keep at most maxInFlight requests unanswered until the cycle completes.
+    // A lost poll holds its place until the communicator gives up on it.
+    size_t next = 0;
+    while ((!stopping) && (answeredCount < requests.size())) {
+      expire(polling.elapsed());
+      while ((next < requests.size()) && (inFlight < maxInFlight.load())) {
+        const size_t index = next++;
+
+        // still unanswered from an earlier cycle, not asked twice
+        if (sentIn[index] != 0) {
+          ++answeredCount;
+          continue;
+        }
+
+        ++inFlight;
+        sentIn[index] = cycle;
+        sentAt[index] = polling.elapsed();
+        mutex.unlock();
+        const bool queued =
+            comm->sendSysex(requests[index].sysex, RequestPriority::Meter);
+        mutex.lock();
+
+        // the meter queue is full, skip the meter this cycle
+        if (!queued) {
+          sentIn[index] = 0;
+          --inFlight;
+          ++answeredCount;
+        }
+      }
+
+      const auto remaining = kMeterCycleTimeout - clock.elapsed();
+      if (remaining <= 0) {
+        break;
+      }
+      answered.wait(&mutex, (unsigned long)remaining);
+    }
+
+    if (stopping) {
+      break;
+    }
+
+    publish();
+
+    // announce once per drawn frame so a slow UI is not flooded
+    if (!pendingUpdate.exchange(true)) {
+      emit metersUpdated();
+    }
+
+    // late answers wake the condition too, so wait out the whole period
+    for (auto remaining = period - clock.elapsed();
+         (!stopping) && (remaining > 0); remaining = period - clock.elapsed()) {
+      answered.wait(&mutex, (unsigned long)remaining);
+    }
+  }
+  mutex.unlock();
+}
+
+void MeterPoller::handleMeters(CmdEnum command, DeviceID _deviceID,
+                               Word transID,
+                               const commandData_t &commandData) {
+  if ((transID != kMeterTransID) || (!(deviceID == _deviceID))) {
+    return;
+  }
+
+  const MeterBlocks *blocks;
+  int index;
+  if (command == Command::RetAudioPortMeterValue) {
+    const auto &meters = commandData.get<AudioPortMeterValue>();
+    blocks = &meters.meterBlocks;
+    index = slotIndex(meters.key());
+  } else {
+    const auto &meters = commandData.get<MixerMeterValue>();
+    blocks = &meters.meterBlocks;
+    index = slotIndex(meters.key());
+  }
+  if (index < 0) {
+    return;
+  }
+
+  mutex.lock();
+  // only the first answer to a request frees its place, and only one sent
+  // this cycle counts, answers to a cycle that timed out would otherwise end
+  // the current one early
+  if (sentIn[index] != 0) {
+    if (sentIn[index] == cycle) {
+      store(index, *blocks);
+      ++answeredCount;
+    }
+    sentIn[index] = 0;
+    --inFlight;
+    answered.wakeAll();
+  }
+  mutex.unlock();
+}
+
+// the mutex is held, gives the places of polls the communicator dropped back
+void MeterPoller::expire(qint64 now) {
+  const qint64 timeout = comm->requestTimeout();
+  for (size_t index = 0; index < sentIn.size(); ++index) {
+    if ((sentIn[index] != 0) && (now - sentAt[index] >= timeout)) {
+      if (sentIn[index] == cycle) {
+        ++answeredCount;
+      }
+      sentIn[index] = 0;
+      --inFlight;
+    }
+  }
+}
+
+void MeterPoller::store(int index, const MeterBlocks &blocks) {
+  auto &slot = buffers[1 - front.load()][index];
+  const Byte blockCount = blocks.blockCount();
+  slot.blockCount.store(blockCount, memory_order_relaxed);
+
+  for (int block = 0; block < blockCount; ++block) {
+    const Byte valueCount = blocks.valueCount(block);
+    slot.valueCount[block].store(valueCount, memory_order_relaxed);
+    for (int value = 0; value < valueCount; ++value) {
+      slot.values[block][value].store(blocks.value(block, value),
+                                      memory_order_relaxed);
+    }
+  }
+}
+
+void MeterPoller::publish() {
+  const int published = 1 - front.load();
+  front.store(published, memory_order_release);
+
+  // carry the snapshot over so meters not answered next cycle keep their value
+  const auto *source = buffers[published].get();
+  auto *target = buffers[1 - published].get();
+  for (size_t index = 0; index < requests.size(); ++index) {
+    const Byte blockCount = source[index].blockCount.load(memory_order_relaxed);
+    target[index].blockCount.store(blockCount, memory_order_relaxed);
+    for (int block = 0; block < blockCount; ++block) {
+      const Byte valueCount =
+          source[index].valueCount[block].load(memory_order_relaxed);
+      target[index].valueCount[block].store(valueCount, memory_order_relaxed);
+      for (int value = 0; value < valueCount; ++value) {
+        target[index].values[block][value].store(
+            source[index].values[block][value].load(memory_order_relaxed),
+            memory_order_relaxed);
+      }
+    }
+  }
+}
+
+int MeterPoller::slotIndex(commandDataKey_t key) const {
+  auto position = lower_bound(keys.begin(), keys.end(), key);
+  if ((position == keys.end()) || (*position != key)) {
+    return -1;
+  }
+  return (int)std::distance(keys.begin(), position);
+}
+
+Word MeterPoller::meter(commandDataKey_t key, int blockIndex,
+                        int meterIndex) const {
+  const int index = slotIndex(key);
+  if ((index < 0) || (blockIndex < 0) || (meterIndex < 0)) {
+    return 0;
+  }
+
+  const auto &slot = buffers[front.load(memory_order_acquire)][index];
+  if ((blockIndex >= slot.blockCount.load(memory_order_relaxed)) ||
+      (meterIndex >= slot.valueCount[blockIndex].load(memory_order_relaxed))) {
+    return 0;
+  }
+  return slot.values[blockIndex][meterIndex].load(memory_order_relaxed);
+}
@@ -0,0 +1,124 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef METERPOLLER_H
+#define METERPOLLER_H
+
+#include "CommandDataKey.h"
+#include "Communicator.h"
+#include "DeviceID.h"
+#include "LibTypes.h"
+#include "MeterBlocks.h"
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#ifndef Q_MOC_RUN
+#include <boost/scoped_array.hpp>
+#endif
+#include <atomic>
+#include <vector>
+
+#define kMeterRate 30            // snapshots per second
+#define kMeterBudget 4           // meter requests in flight at once
+#define kMeterCycleTimeout 250   // msec to wait for a cycle's answers
+#define kMeterTransID 0x3FFF     // keeps meter answers out of DeviceInfo
+
+// Streams meter values on its own thread. Every cycle the meter requests are
+// sent with the Communicator's meter priority, behind writes from the
+// controls and ahead of rereads, with at most `budget` of them unanswered.
+// The answers are written into the back half of a double buffered snapshot
+// and the halves are flipped once the cycle is complete.
+// Readers only ever load from the front half so they never wait on MIDI.
+class MeterPoller : public QThread {
+  Q_OBJECT
+ public:
+  struct Request {
+    GeneSysLib::commandDataKey_t key;
+    Bytes sysex;
+  };
+
+  explicit MeterPoller(GeneSysLib::CommPtr comm, QObject *parent = 0);
+  ~MeterPoller();
+
+  void setRate(int hz);
+  int rate() const;
+  void setBudget(int budget);
+  int budget() const;
+
+  void startPolling(GeneSysLib::DeviceID deviceID,
+                    std::vector<Request> requests);
+  void stopPolling();
+
+  // the last published snapshot has been drawn, the next may be announced
+  void acknowledge();
+
+  // snapshot readers, 0 if the meter has not been answered
+  Word audioPortMeter(Word audioPortID, int blockIndex, int meterIndex) const;
+  Word mixerInputMeter(Word audioPortID, Byte mixerOutputNumber,
+                       Byte mixerInputNumber) const;
+  Word mixerOutputMeter(Word audioPortID, Byte mixerOutputNumber) const;
+
+ signals:
+  void metersUpdated();
+
+ protected:
+  void run();
+
+ private:
+  struct MeterSlot {
+    std::atomic<Byte> blockCount;
+    std::atomic<Byte> valueCount[kMeterBlockCapacity];
+    std::atomic<Word> values[kMeterBlockCapacity][kMeterValueCapacity];
+  };
+
+  void handleMeters(GeneSysLib::CmdEnum command,
+                    GeneSysLib::DeviceID deviceID, Word transID,
+                    const GeneSysLib::commandData_t &commandData);
+
+  void store(int index, const GeneSysLib::MeterBlocks &blocks);
+
+  void publish();
+  void expire(qint64 now);
+
+  int slotIndex(GeneSysLib::commandDataKey_t key) const;
+  Word meter(GeneSysLib::commandDataKey_t key, int blockIndex,
+             int meterIndex) const;
+
+  GeneSysLib::CommPtr comm;
+  GeneSysLib::DeviceID deviceID;
+
+  std::vector<Request> requests;  // sorted by key
+  std::vector<GeneSysLib::commandDataKey_t> keys;
+  boost::scoped_array<MeterSlot> buffers[2];
+  std::atomic<int> front;
+  std::atomic<bool> pendingUpdate;
+
+  long audioHandlerID;
+  long mixerHandlerID;
+
+  // set from the GUI thread while polling
+  std::atomic<int> period;
+  std::atomic<int> maxInFlight;
+
+  // guards the back buffer and the cycle counters
+  QMutex mutex;
+  QWaitCondition answered;
+  bool stopping;
+  int inFlight;  // across cycles, until answered or timed out
+  size_t answeredCount;
+
+  // cycles are numbered from 1, sentIn holds the cycle a request was sent in
+  // or 0 once it is answered, refused or timed out. sentAt is when, in msec
+  // since polling started.
+  size_t cycle;
+  std::vector<size_t> sentIn;
+  std::vector<qint64> sentAt;
+};
+
+#endif  // METERPOLLER_H
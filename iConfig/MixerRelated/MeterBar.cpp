@@ -0,0 +1,79 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "MeterBar.h"
+#include "MixerChannelWidget.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// 0 dBFS is a meter word of 8192, levels above are clipping
+std::vector<MeterBar::Level> buildLevels() {
+  std::vector<MeterBar::Level> levels(kMeterWordRange);
+
+  levels[0].pixels = 0;
+  levels[0].zone = MeterBar::Green;
+  levels[0].clipping = false;
+
+  for (int meter = 1; meter < kMeterWordRange; ++meter) {
+    const double dB = 20.0 * log10((double)meter / 8192.0);
+
+    auto &level = levels[meter];
+    level.pixels = std::min<Word>(
+        MixerChannelWidget::toPixelsFromICA((int16_t)(dB * 256.0)),
+        kMeterPixels);
+    level.zone = (dB < 0) ? MeterBar::Green
+                          : ((dB < 5.9) ? MeterBar::Yellow : MeterBar::Red);
+    level.clipping = (dB >= 0.0);
+  }
+
+  return levels;
+}
+
+const QColor zoneColours[] = {QColor(0x11, 0xe0, 0x00),
+                              QColor(0xFF, 0xCC, 0x00),
+                              QColor(0xff, 0x00, 0x33)};
+const QColor backgroundColour(0x54, 0x54, 0x54);
+
+}  // namespace
+
+MeterBar::MeterBar(QWidget *_parent)
+    : QWidget(_parent), pixels(0), zone(Green) {}
+
+const MeterBar::Level &MeterBar::level(Word meter) {
+  static const std::vector<Level> levels = buildLevels();
+  return levels[std::min<Word>(meter, kMeterWordRange - 1)];
+}
+
+bool MeterBar::setMeter(Word meter) {
+  const auto &found = level(meter);
+  if ((found.pixels != pixels) || (found.zone != zone)) {
+    pixels = found.pixels;
+    zone = found.zone;
+    update();
+  }
+  return found.clipping;
+}
+
+void MeterBar::paintEvent(QPaintEvent *) {
+  QPainter p(this);
+
+  // the 2 pixel right margin the stylesheet used to leave
+  const QRect bar(0, 0, std::max(width() - 2, 0), height());
+  p.fillRect(bar, backgroundColour);
+
+  const int filled = (bar.height() * pixels) / kMeterPixels;
+  if (filled > 0) {
+    p.fillRect(QRect(bar.left(), bar.bottom() - filled + 1, bar.width(), filled),
+               zoneColours[zone]);
+  }
+}
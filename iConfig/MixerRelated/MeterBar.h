@@ -0,0 +1,49 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef METERBAR_H
+#define METERBAR_H
+
+#include "LibTypes.h"
+
+#include <QPaintEvent>
+#include <QWidget>
+
+#define kMeterWordRange 0x4000  // meters are 14 bit MIDI words
+#define kMeterPixels 299        // the height of toPixelsFromICA()
+
+// A vertical level meter painted directly instead of through a QProgressBar
+// stylesheet. Raw meter words are mapped to a height and a colour zone with a
+// table built once, and the widget only repaints when either changes.
+class MeterBar : public QWidget {
+  Q_OBJECT
+ public:
+  enum Zone { Green = 0, Yellow, Red };
+
+  struct Level {
+    Word pixels;
+    Byte zone;
+    bool clipping;
+  };
+
+  explicit MeterBar(QWidget *parent = 0);
+
+  // the height and zone of a raw meter word
+  static const Level &level(Word meter);
+
+  // returns true if the meter is at or above 0 dBFS
+  bool setMeter(Word meter);
+
+ protected:
+  void paintEvent(QPaintEvent *event);
+
+ private:
+  Word pixels;
+  Byte zone;
+};
+
+#endif  // METERBAR_H
@@ -228,6 +228,12 @@ void MixerChannelWidget::soloDialChanged(int state)
   }
 }
 
+void MixerChannelWidget::controlReleased()
+{
+  // send the final value now instead of when the device catches up
+  device->flushWrites();
+}
+
 void MixerChannelWidget::muteStateChanged(bool state)
 {
   if (mixerType == in) {
@@ -598,21 +604,6 @@ void MixerChannelWidget::buildChannelNameLabel()
   }
 }
 
-void MixerChannelWidget::setProgressBarColor(QProgressBar* pb, double value) {
-  if (value < 0) {
-    pb->setStyleSheet("QProgressBar{ margin-right: 2px; border: 0px; background-color: #545454; border-radius: 0px; text-align: center} \
-    QProgressBar::chunk { background-color: #11e000; }");
-  }
-  else if (value < 5.9) {
-    pb->setStyleSheet("QProgressBar{ margin-right: 2px; border: 0px; background-color: #545454; border-radius: 0px; text-align: center} \
-    QProgressBar::chunk { background-color: #FFCC00; }");
-  }
-  else{
-    pb->setStyleSheet("QProgressBar{ margin-right: 2px; border: 0px; background-color: #545454; border-radius: 0px; text-align: center} \
-    QProgressBar::chunk { background-color: #ff0033; }");
-  }
-}
-
 void MixerChannelWidget::labelDone(double value)
 {
   int valToSend = value * 256;
@@ -708,20 +699,14 @@ void MixerChannelWidget::buildVolumeSlider()
     volFooter->setMaximumWidth(20);
     volFooter->setMinimumWidth(20);
 
-    meterBar1 = new QProgressBar();
-    setProgressBarColor(meterBar1, -20);
+    meterBar1 = new MeterBar();
 
-    meterBar1->setTextVisible(false);
     meterBar1->setMinimumWidth(8);
     meterBar1->setMaximumWidth(8);
 
-    meterBar1->setOrientation(Qt::Vertical);
     meterBar1->setMaximumHeight(300);
     meterBar1->setMinimumHeight(300);
-    meterBar1->setTextDirection(QProgressBar::BottomToTop);
 
-    meterBar1->setMaximum(299);
-    meterBar1->setMinimum(0);
 
     auto meterBar1spacer1 = new QWidget();
     meterBar1spacer1->setMaximumHeight(10);
@@ -763,19 +748,13 @@ void MixerChannelWidget::buildVolumeSlider()
 
     QWidget* meterBar2Box = 0;
 
-    meterBar2 = new QProgressBar();
-    setProgressBarColor(meterBar2, -20);
-    meterBar2->setTextVisible(false);
+    meterBar2 = new MeterBar();
     meterBar2->setMinimumWidth(8);
     meterBar2->setMaximumWidth(8);
 
-    meterBar2->setOrientation(Qt::Vertical);
     meterBar2->setMaximumHeight(300);
     meterBar2->setMinimumHeight(300);
-    meterBar2->setTextDirection(QProgressBar::BottomToTop);
 
-    meterBar2->setMaximum(299);
-    meterBar2->setMinimum(0);
 
     auto meterBar2spacer1 = new QWidget();
     meterBar2spacer1->setMaximumHeight(10);
@@ -862,6 +841,8 @@ void MixerChannelWidget::buildVolumeSlider()
 
     connect(volumeSlider, SIGNAL(valueChanged(int)), this,
             SLOT(volumeSliderChanged(int)));
+    connect(volumeSlider, SIGNAL(sliderReleased()), this,
+            SLOT(controlReleased()));
   }
 }
 
@@ -947,6 +928,7 @@ void MixerChannelWidget::buildPanDial()
     }
     connect(panDial, SIGNAL(valueChanged(int)), this,
             SLOT(panDialChanged(int)));
+    connect(panDial, SIGNAL(sliderReleased()), this, SLOT(controlReleased()));
 
     updatePanValue();
   }
@@ -1055,6 +1037,7 @@ void MixerChannelWidget::buildSoloDial()
 
     connect(soloDial, SIGNAL(valueChanged(int)), this,
             SLOT(soloDialChanged(int)));
+    connect(soloDial, SIGNAL(sliderReleased()), this, SLOT(controlReleased()));
 
     updateSoloDialValue();
   }
@@ -1350,8 +1333,8 @@ void MixerChannelWidget::updateAll()
 
 void MixerChannelWidget::updateMeters() {
   bool volAvailable = false;
-  int meterCurrent1 = 0;
-  int meterCurrent2 = 0;
+  Word meterCurrent1 = 0;
+  Word meterCurrent2 = 0;
   if (!disabled) {
     if (mixerType == in) {
       volAvailable = mixerInputInterface->isVolumeAvailable(audioPortID);
@@ -1367,35 +1350,13 @@ void MixerChannelWidget::updateMeters() {
       meterCurrent2 = mixerOutputInterface->meterCurrent(audioPortID, mixerOutputNumber + 1);
     }
     if (volAvailable) {
-      int meterPng1 = toPixelsFromICA(((double)20 * log10((double)meterCurrent1 / 8192.0)) * 256.0);
-      int meterPng2 = toPixelsFromICA(((double)20 * log10((double)meterCurrent2 / 8192.0)) * 256.0);
-
-      if ((((double)20 * log10((double)meterCurrent1 / 8192.0)) >= 0.0)) {
+      // the bars only repaint when their height or colour zone changes
+      if (meterBar1->setMeter(meterCurrent1)) {
         turnOnClipping1();
       }
-      if ((((double)20 * log10((double)meterCurrent2 / 8192.0)) >= 0.0)) {
+      if (meterBar2->setMeter(meterCurrent2)) {
         turnOnClipping2();
       }
-
-//      //printf("meter1: %d, %d, %d | meter2: %d, %d, %d\n", meterPng1, meterCurrent1, (int)(((double)20 * log10((double)meterCurrent1 / 8192.0)) * 256.0),
-//             meterPng2, meterCurrent2, (int)(((double)20 * log10((double)meterCurrent2 / 8192.0)) * 256.0));
-
-      if (meterCurrent1 == 0) {
-        meterBar1->setValue(0);
-        setProgressBarColor(meterBar1, -20);
-      }
-      else {
-        meterBar1->setValue(meterPng1);
-        setProgressBarColor(meterBar1, ((double)20 * log10((double)meterCurrent1 / 8192.0)));
-      }
-      if (meterCurrent2 == 0) {
-        meterBar2->setValue(0);
-        setProgressBarColor(meterBar2, -20);
-      }
-      else {
-        meterBar2->setValue(meterPng2);
-        setProgressBarColor(meterBar2, ((double)20 * log10((double)meterCurrent2 / 8192.0)));
-      }
     }
   }
 }
@@ -19,7 +19,6 @@
 #include <QPushButton>
 #include <QDial>
 #include <QPushButton>
-#include <QProgressBar>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QComboBox>
@@ -28,6 +27,7 @@
 #include "MixerInterface.h"
 #include "MixerInputInterface.h"
 #include "MixerOutputInterface.h"
+#include "MeterBar.h"
 
 #include "QClickyDial.h"
 #include "QClickySlider.h"
@@ -82,6 +82,7 @@ private slots:
  void volumeSliderChanged(int state);
  void panDialChanged(int state);
  void soloDialChanged(int state);
+ void controlReleased();
  void muteStateChanged(bool state);
  void stereoLinkStateChanged(bool state);
  void invertStateChanged(bool state);
@@ -120,8 +121,6 @@ private:
   void updateInvertValue();
   void updateRightInvertValue();
 
-  void setProgressBarColor(QProgressBar *pb, double value);
-
   QComboBox *channelDropdown;
   QComboBox *channelDropdownLinked;
   QPushButton *outputConfigPushButton;
@@ -145,8 +144,8 @@ private:
   QTimer *clippingTimer1;
   QTimer *clippingTimer2;
 
-  QProgressBar* meterBar1;
-  QProgressBar* meterBar2;
+  MeterBar* meterBar1;
+  MeterBar* meterBar2;
 
   bool soloLightOn;
 
@@ -14,7 +14,7 @@
 #include "MixerParm.h"
 #include "MixerPortParm.h"
 #include "MixerInputInterface.h"
-#include "MixerMeterValue.h"
+#include "MeterPoller.h"
 
 using namespace std;
 using namespace GeneSysLib;
@@ -48,7 +48,7 @@ void MixerInputInterface::invert(Word audioPortID, Byte outChannelID, Byte inCha
 {
   auto& mixerInputControlValue = device->get<MixerInputControlValue>(audioPortID, outChannelID, inChannelID);
   mixerInputControlValue.invertControl(value);
-  device->send<SetMixerInputControlValueCommand>(mixerInputControlValue);
+  device->writeNow<SetMixerInputControlValueCommand>(mixerInputControlValue);
   //printf("set invert on %d:%d:%d to %d\n", audioPortID, outChannelID, inChannelID, value);
 }
 
@@ -81,7 +81,7 @@ void MixerInputInterface::stereoLink(Word audioPortID, Byte outChannelID, Byte i
 
   auto& mixerInputControlValue = device->get<MixerInputControlValue>(audioPortID, outChannelID, inChannelID);
   mixerInputControlValue.stereoLinkControl(value);
-  device->send<SetMixerInputControlValueCommand>(mixerInputControlValue);
+  device->writeNow<SetMixerInputControlValueCommand>(mixerInputControlValue);
 
   /*int linkedInChannelID = 0;
   if (inChannelID % 2) { // is odd
@@ -129,7 +129,7 @@ void MixerInputInterface::soloPFL(Word audioPortID, Byte outChannelID, Byte inCh
 {
   auto& mixerInputControlValue = device->get<MixerInputControlValue>(audioPortID, outChannelID, inChannelID);
   mixerInputControlValue.soloPFLControl(value);
-  device->send<SetMixerInputControlValueCommand>(mixerInputControlValue);
+  device->writeNow<SetMixerInputControlValueCommand>(mixerInputControlValue);
 
   /*if (mixerInputControlValue.stereoLinkControl() == 1) {
     int linkedInChannelID = inChannelID + 1;
@@ -185,7 +185,7 @@ void MixerInputInterface::solo(Word audioPortID, Byte outChannelID, Byte inChann
 {
   auto& mixerInputControlValue = device->get<MixerInputControlValue>(audioPortID, outChannelID, inChannelID);
   mixerInputControlValue.soloControl(value);
-  device->send<SetMixerInputControlValueCommand>(mixerInputControlValue);
+  device->writeNow<SetMixerInputControlValueCommand>(mixerInputControlValue);
 
   /*if (mixerInputControlValue.stereoLinkControl() == 1) {
     int linkedInChannelID = inChannelID + 1;
@@ -241,7 +241,7 @@ void MixerInputInterface::mute(Word audioPortID, Byte outChannelID, Byte inChann
 {
   auto& mixerInputControlValue = device->get<MixerInputControlValue>(audioPortID, outChannelID, inChannelID);
   mixerInputControlValue.muteControl(value);
-  device->send<SetMixerInputControlValueCommand>(mixerInputControlValue);
+  device->writeNow<SetMixerInputControlValueCommand>(mixerInputControlValue);
 
   /*if (mixerInputControlValue.stereoLinkControl() == 1) {
     int linkedInChannelID = inChannelID + 1;
@@ -318,7 +318,7 @@ void MixerInputInterface::volumeCurrent(Word audioPortID, Byte outChannelID, Byt
 {
   auto& mixerInputControlValue = device->get<MixerInputControlValue>(audioPortID, outChannelID, inChannelID);
   mixerInputControlValue.volumeControl(value);
-  device->send<SetMixerInputControlValueCommand>(mixerInputControlValue);
+  device->write<SetMixerInputControlValueCommand>(mixerInputControlValue);
 
   /*if (mixerInputControlValue.stereoLinkControl() == 1) {
     int linkedInChannelID = inChannelID + 1;
@@ -352,8 +352,8 @@ void MixerInputInterface::volumeCurrent(Word audioPortID, Byte outChannelID, Byt
 
 int16_t MixerInputInterface::meterCurrent(Word audioPortID, Byte outChannelID, Byte inChannelID) const
 {
-  const auto& mixerMeterValue = device->get<MixerMeterValue>(audioPortID, outChannelID);
-  return mixerMeterValue.inputMeter(inChannelID);
+  return device->meterPoller()->mixerInputMeter(audioPortID, outChannelID,
+                                                inChannelID);
 }
 
 bool MixerInputInterface::isPanAvailable(Word audioPortID) const
@@ -395,7 +395,7 @@ void MixerInputInterface::panCurrent(Word audioPortID, Byte outChannelID, Byte i
 {
   auto& mixerInputControlValue = device->get<MixerInputControlValue>(audioPortID, outChannelID, inChannelID);
   mixerInputControlValue.panControl(value);
-  device->send<SetMixerInputControlValueCommand>(mixerInputControlValue);
+  device->write<SetMixerInputControlValueCommand>(mixerInputControlValue);
 
   /*if (mixerInputControlValue.stereoLinkControl() == 1) {
     int linkedInChannelID = inChannelID + 1;
@@ -450,6 +450,6 @@ void MixerInputInterface::panCurveLawCurrent(Word audioPortID, Byte outChannelID
 {
   auto& mixerInputControlValue = device->get<MixerInputControlValue>(audioPortID, outChannelID, inChannelID);
   mixerInputControlValue.panCurveLaw(value);
-  device->send<SetMixerInputControlValueCommand>(mixerInputControlValue);
+  device->writeNow<SetMixerInputControlValueCommand>(mixerInputControlValue);
 
 }
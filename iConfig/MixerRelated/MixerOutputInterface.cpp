@@ -14,7 +14,7 @@
 #include "MixerParm.h"
 #include "MixerPortParm.h"
 #include "MixerOutputInterface.h"
-#include "MixerMeterValue.h"
+#include "MeterPoller.h"
 
 using namespace std;
 using namespace GeneSysLib;
@@ -48,7 +48,7 @@ void MixerOutputInterface::invert(Word audioPortID, Byte outChannelID, bool valu
 {
   auto& mixerOutputControlValue = device->get<MixerOutputControlValue>(audioPortID, outChannelID);
   mixerOutputControlValue.invertControl(value);
-  device->send<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
+  device->writeNow<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
 }
 
 bool MixerOutputInterface::isStereoLinkAvailable(Word audioPortID) const
@@ -79,7 +79,7 @@ void MixerOutputInterface::stereoLink(Word audioPortID, Byte outChannelID, bool
   }
   auto& mixerOutputControlValue = device->get<MixerOutputControlValue>(audioPortID, outChannelID);
   mixerOutputControlValue.stereoLinkControl(value);
-  device->send<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
+  device->writeNow<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
 
   /*int linkedOutChannelID = 0;
   if (outChannelID % 2) { // is odd
@@ -129,7 +129,7 @@ void MixerOutputInterface::soloPFL(Word audioPortID, Byte outChannelID, bool val
   auto& mixerOutputControlValue = device->get<MixerOutputControlValue>(audioPortID, outChannelID);
   mixerOutputControlValue.soloPFLControl(value);
 
-  device->send<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
+  device->writeNow<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
   /*if (mixerOutputControlValue.stereoLinkControl() == 1) {
     auto& mixerOutputControlValue2 = device->get<MixerOutputControlValue>(audioPortID, outChannelID + 1);
     mixerOutputControlValue2.soloPFLControl(value);
@@ -162,7 +162,7 @@ void MixerOutputInterface::solo(Word audioPortID, Byte outChannelID, int16_t val
 {
   auto& mixerOutputControlValue = device->get<MixerOutputControlValue>(audioPortID, outChannelID);
   mixerOutputControlValue.soloControl(value);
-  device->send<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
+  device->write<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
 
   /*if (mixerOutputControlValue.stereoLinkControl() == 1) {
     auto& mixerOutputControlValue2 = device->get<MixerOutputControlValue>(audioPortID, outChannelID + 1);
@@ -196,7 +196,7 @@ void MixerOutputInterface::mute(Word audioPortID, Byte outChannelID, bool value)
 {
   auto& mixerOutputControlValue = device->get<MixerOutputControlValue>(audioPortID, outChannelID);
   mixerOutputControlValue.muteControl(value);
-  device->send<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
+  device->writeNow<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
 
   /*if (mixerOutputControlValue.stereoLinkControl() == 1) {
     auto& mixerOutputControlValue2 = device->get<MixerOutputControlValue>(audioPortID, outChannelID + 1);
@@ -251,7 +251,7 @@ void MixerOutputInterface::volumeCurrent(Word audioPortID, Byte outChannelID, in
 {
   auto& mixerOutputControlValue = device->get<MixerOutputControlValue>(audioPortID, outChannelID);
   mixerOutputControlValue.volumeControl(value);
-  device->send<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
+  device->write<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
 
   /*if (mixerOutputControlValue.stereoLinkControl() == 1) {
     auto& mixerOutputControlValue2 = device->get<MixerOutputControlValue>(audioPortID, outChannelID + 1);
@@ -262,8 +262,7 @@ void MixerOutputInterface::volumeCurrent(Word audioPortID, Byte outChannelID, in
 
 int16_t MixerOutputInterface::meterCurrent(Word audioPortID, Byte outChannelID)
 {
-  const auto& mixerMeterValue = device->get<MixerMeterValue>(audioPortID, outChannelID);
-  return mixerMeterValue.outputMeter();
+  return device->meterPoller()->mixerOutputMeter(audioPortID, outChannelID);
 }
 
 bool MixerOutputInterface::isPanAvailable(Word audioPortID) const
@@ -305,7 +304,7 @@ void MixerOutputInterface::panCurrent(Word audioPortID, Byte outChannelID, int16
 {
   auto& mixerOutputControlValue = device->get<MixerOutputControlValue>(audioPortID, outChannelID);
   mixerOutputControlValue.panControl(value);
-  device->send<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
+  device->write<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
 
   /*if (mixerOutputControlValue.stereoLinkControl() == 1) {
     auto& mixerOutputControlValue2 = device->get<MixerOutputControlValue>(audioPortID, outChannelID + 1);
@@ -339,6 +338,6 @@ void MixerOutputInterface::panCurveLawCurrent(Word audioPortID, Byte outChannelI
 {
   auto& mixerOutputControlValue = device->get<MixerOutputControlValue>(audioPortID, outChannelID);
   mixerOutputControlValue.panCurveLaw(value);
-  device->send<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
+  device->writeNow<SetMixerOutputControlValueCommand>(mixerOutputControlValue);
 
 }
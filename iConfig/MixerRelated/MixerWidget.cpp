@@ -167,6 +167,8 @@ MixerWidget::MixerWidget(DeviceInfoPtr device, QWidget *parent)
 }
 
 MixerWidget::~MixerWidget() {
+  // polling is started by the owner once it listens for updates
+  device->stopMeterPolling();
   remove(tabLayout);
 }
 
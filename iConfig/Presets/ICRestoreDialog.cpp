@@ -9,6 +9,7 @@
 #include "ui_ICRestoreDialog.h"
 #include "DeviceInfo.h"
 #include "MainWindow.h"
+#include "PresetLibrary.h"
 
 #include <QFileDialog>
 #include <QDesktopServices>
@@ -25,6 +26,14 @@ ICRestoreDialog::ICRestoreDialog(DeviceInfoPtr device, QWidget *parent) :
   ui->setupUi(this);
   listModel = new QStandardItemModel();
   fileName = "";
+  library = new PresetLibrary(QDesktopServices::storageLocation(QDesktopServices::DataLocation) + "/presets", this);
+
+  connect(ui->listFiles,SIGNAL(itemSelectionChanged()),
+          this, SLOT(handleSelectionChanged()));
+  connect(ui->lineSearch, SIGNAL(textChanged(QString)),
+          this, SLOT(loadFiles()));
+  connect(library, SIGNAL(changed()), this, SLOT(loadFiles()));
+
   loadFiles();
   setModal(true);
 }
@@ -34,27 +43,30 @@ ICRestoreDialog::~ICRestoreDialog()
   delete ui;
 }
 
+// the presets of the device's model matching the search, from the index
 void ICRestoreDialog::loadFiles() {
-  QDir::root().mkpath(QDesktopServices::storageLocation(QDesktopServices::DataLocation) + "/presets");
-  QDir presetsDir = QDir(QDesktopServices::storageLocation(QDesktopServices::DataLocation) + "/presets");
-
   qDebug() << "Preset Device:" << MainWindow::extensionForPID(currentDevice->getPID());
 
-  presetsDir.setNameFilters(QStringList()<<("*" + MainWindow::extensionForPID(currentDevice->getPID())));
+  const QString selected = ui->listFiles->selectedItems().isEmpty()
+      ? QString() : ui->listFiles->selectedItems().first()->text();
 
-  QStringList fileList = presetsDir.entryList();
-
-  foreach (QString file, fileList) {
-    ui->listFiles->addItem(file);
+  ui->listFiles->blockSignals(true);
+  ui->listFiles->clear();
+  foreach (const PresetEntry &entry, library->find(currentDevice->getPID(), ui->lineSearch->text())) {
+    ui->listFiles->addItem(entry.fileName);
+    if (entry.fileName == selected) {
+      ui->listFiles->item(ui->listFiles->count() - 1)->setSelected(true);
+    }
   }
+  ui->listFiles->blockSignals(false);
 
-  connect(ui->listFiles,SIGNAL(itemSelectionChanged()),
-          this, SLOT(handleSelectionChanged()));
+  handleSelectionChanged();
 }
 
 void ICRestoreDialog::handleSelectionChanged() {
   if(ui->listFiles->selectedItems().isEmpty()) {
     ui->textEditDescription->setText("");
+    fileName = "";
   }
   else {
     loadDescription(ui->listFiles->selectedItems().first()->text());
@@ -62,28 +74,11 @@ void ICRestoreDialog::handleSelectionChanged() {
 }
 
 void ICRestoreDialog::loadDescription(const QString index) {
-  fileName = QDesktopServices::storageLocation(QDesktopServices::DataLocation) + "/presets/" + index;
+  fileName = library->directory() + "/" + index;
 
-  QFile file(fileName);
-  if (!file.open(QFile::ReadOnly)) {
-    QMessageBox::warning(this, tr("Read Failed"),
-                         tr("Cannot read file %1:\n%2.").arg(fileName)
-                         .arg(file.errorString()));
-    return;
-  }
-  else {
-    QByteArray qData = file.readAll();
-    file.close();
-
-    bool valid = (qData.size() > 22);
-
-    if (valid) {
-      int descSize = qData.at(5);
-      QString description = QString(qData.mid(6,descSize));
-
-      ui->textEditDescription->setText(description);
-    }
-  }
+  // the index holds the description, the file is not read
+  const PresetEntry *entry = library->lookup(index);
+  ui->textEditDescription->setText(entry ? entry->description : QString());
 }
 
 void ICRestoreDialog::accept() {
@@ -102,3 +97,7 @@ void ICRestoreDialog::reject() {
 QString ICRestoreDialog::getFileName() {
   return fileName;
 }
+
+bool ICRestoreDialog::isVerified(const QByteArray &contents) {
+  return (!fileName.isEmpty()) && (library->verify(fileName, contents));
+}
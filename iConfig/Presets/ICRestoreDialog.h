@@ -13,6 +13,8 @@
 #include <QListView>
 #include "DeviceInfo.h"
 
+class PresetLibrary;
+
 namespace Ui {
 class ICRestoreDialog;
 }
@@ -26,16 +28,20 @@ public:
   ~ICRestoreDialog();
 
   QString getFileName();
+  // contents read from the chosen preset are known intact, their hash need
+  // not be checked again
+  bool isVerified(const QByteArray &contents);
 protected:
   void accept();
   void reject();
 protected slots:
   void handleSelectionChanged();
+  void loadFiles();
 private:
   Ui::ICRestoreDialog *ui;
-  void loadFiles();
   void loadDescription(const QString index);
   DeviceInfoPtr currentDevice;
+  PresetLibrary* library;
   QStandardItemModel* listModel;
   QString fileName;
 };
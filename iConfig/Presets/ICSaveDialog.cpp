@@ -166,7 +166,7 @@ void ICSaveDialog::checkToggled(bool value) { // handle button pre-reqs
 
 std::set<Command::Enum> ICSaveDialog::getPreRebootCommands() {
   std::set<Command::Enum> toReturn;
-  if (ui->checkAudioInfo) {
+  if (ui->checkAudioInfo->isChecked()) {
     toReturn.insert(Command::RetAudioInfo);
     toReturn.insert(Command::RetAudioCfgInfo);
     toReturn.insert(Command::RetAudioPortInfo);
@@ -187,37 +187,37 @@ std::set<Command::Enum> ICSaveDialog::getPreRebootCommands() {
 std::set<Command::Enum> ICSaveDialog::getPostRebootCommands() {
   std::set<Command::Enum> toReturn;
 
-  if (ui->checkDeviceInfo) {
+  if (ui->checkDeviceInfo->isChecked()) {
     toReturn.insert(Command::RetInfo);
     toReturn.insert(Command::RetEthernetPortInfo);
   }
-  if (ui->checkAudioConnections) {
+  if (ui->checkAudioConnections->isChecked()) {
     toReturn.insert(Command::RetMixerInputParm);
     toReturn.insert(Command::RetMixerOutputParm);
     toReturn.insert(Command::RetAudioPatchbayParm);
   }
-  if (ui->checkAudioMixer) {
+  if (ui->checkAudioMixer->isChecked()) {
     toReturn.insert(Command::RetMixerInputControl);
     toReturn.insert(Command::RetMixerInputControlValue);
     toReturn.insert(Command::RetMixerOutputControl);
     toReturn.insert(Command::RetMixerOutputControlValue);
   }
-  if (ui->checkAnalog) {
+  if (ui->checkAnalog->isChecked()) {
     toReturn.insert(Command::RetAudioControlDetail);
     toReturn.insert(Command::RetAudioControlDetailValue);
   }
-  if (ui->checkMidiRemap) {
+  if (ui->checkMidiRemap->isChecked()) {
     toReturn.insert(Command::RetMIDIPortRemap);
   }
-  if (ui->checkMidiFilters) {
+  if (ui->checkMidiFilters->isChecked()) {
     toReturn.insert(Command::RetMIDIPortFilter);
   }
-  if (ui->checkMidiInfo) {
+  if (ui->checkMidiInfo->isChecked()) {
     toReturn.insert(Command::RetMIDIInfo);
     toReturn.insert(Command::RetMIDIPortInfo);
     toReturn.insert(Command::RetMIDIPortDetail);
   }
-  if (ui->checkMidiPortRouting) {
+  if (ui->checkMidiPortRouting->isChecked()) {
     toReturn.insert(Command::RetMIDIPortRoute);
   }
 
@@ -344,36 +344,18 @@ void ICSaveDialog::accept() {
       return;
     }
 
+    // the post-reboot half of a preset saved by an older version
     QFile file2(fileName + ".aux");
     if (file2.exists()) {
       file2.remove();
     }
 
-    Bytes serialized;
-    if (!preRebootCommands.empty()) {
-      serialized = currentDevice->serialize2(preRebootCommands, ui->textEditDescription->text().toAscii());
-    }
-    else {
-      serialized = currentDevice->serialize2(postRebootCommands, ui->textEditDescription->text().toAscii());
-    }
+    // both stages in one file, a section per family
+    Bytes serialized = currentDevice->serialize3(preRebootCommands, postRebootCommands,
+                                                 ui->textEditDescription->text());
     char* data = (char*)serialized.data();
     file.write(data, serialized.size());
     file.close();
-
-    if (!preRebootCommands.empty()) {
-      QFile file(fileName + ".aux");
-
-      if (!file.open(QFile::WriteOnly)) {
-        QMessageBox::warning(this, tr("Save As"),
-                             tr("An unexpected error occured writing %1:\n%2.").arg(fileName + ".aux")
-                             .arg(file.errorString()));
-        return;
-      }
-      Bytes serialized = currentDevice->serialize2(postRebootCommands);
-      char* data = (char*)serialized.data();
-      file.write(data, serialized.size());
-      file.close();
-    }
   }
   else {
     QMessageBox::warning(this, tr("Save As"),
@@ -0,0 +1,251 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "PresetFile.h"
+
+#include <QCryptographicHash>
+
+#include <algorithm>
+
+using namespace GeneSysLib;
+
+namespace {
+
+const Byte kPresetMagic[] = {0x69, 0x43, 0x4D};
+const int kPresetHeaderSize = 5;
+const int kSectionEntrySize = 28;
+const int kHashSize = 16;
+
+QByteArray md5(const uchar *data, qint64 size) {
+  return QCryptographicHash::hash(
+      QByteArray::fromRawData((const char *)data, (int)size),
+      QCryptographicHash::Md5);
+}
+
+void putWord(Bytes &result, Word value) {
+  result.push_back((value >> 8) & 0xFF);
+  result.push_back(value & 0xFF);
+}
+
+void putLong(Bytes &result, quint32 value) {
+  result.push_back((value >> 24) & 0xFF);
+  result.push_back((value >> 16) & 0xFF);
+  result.push_back((value >> 8) & 0xFF);
+  result.push_back(value & 0xFF);
+}
+
+Word getWord(const uchar *data) { return (Word)((data[0] << 8) | data[1]); }
+
+quint32 getLong(const uchar *data) {
+  return ((quint32)data[0] << 24) | ((quint32)data[1] << 16) |
+         ((quint32)data[2] << 8) | (quint32)data[3];
+}
+
+}  // namespace
+
+Bytes PresetFile::build(Byte pid, const QString &description,
+                        const std::vector<Content> &contents) {
+  const QByteArray text = description.left(239).toAscii();
+
+  size_t total = 0;
+  for (const auto &content : contents) {
+    total += content.frames.size();
+  }
+
+  Bytes result;
+  const size_t tableOffset = kPresetHeaderSize + 1 + text.size();
+  const size_t bodyOffset =
+      tableOffset + 2 + contents.size() * kSectionEntrySize + kHashSize;
+  result.reserve(bodyOffset + total);
+
+  result.insert(result.end(), kPresetMagic, kPresetMagic + 3);
+  result.push_back(pid);
+  result.push_back(kPresetVersion3);
+  result.push_back((Byte)text.size());
+  result.insert(result.end(), text.begin(), text.end());
+
+  putWord(result, (Word)contents.size());
+  quint32 offset = bodyOffset;
+  for (const auto &content : contents) {
+    putWord(result, (Word)content.family);
+    result.push_back((Byte)content.stage);
+    result.push_back(0);
+    putLong(result, offset);
+    putLong(result, content.frames.size());
+
+    const QByteArray hash = md5(content.frames.data(), content.frames.size());
+    result.insert(result.end(), hash.begin(), hash.end());
+    offset += content.frames.size();
+  }
+
+  const QByteArray tableHash = md5(result.data(), result.size());
+  result.insert(result.end(), tableHash.begin(), tableHash.end());
+
+  for (const auto &content : contents) {
+    result.insert(result.end(), content.frames.begin(), content.frames.end());
+  }
+  return result;
+}
+
+PresetFile::PresetFile(const QString &fileName)
+    : m_file(fileName),
+      m_contents(),
+      m_mapped(false),
+      m_data(0),
+      m_size(0),
+      m_pid(0),
+      m_version(0),
+      m_description(),
+      m_hash(),
+      m_sections() {}
+
+PresetFile::~PresetFile() { close(); }
+
+bool PresetFile::open() {
+  close();
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  m_size = m_file.size();
+  m_data = m_file.map(0, m_size);
+  m_mapped = (m_data != 0);
+  if (!m_mapped) {
+    m_contents = m_file.readAll();
+    m_data = (const uchar *)m_contents.constData();
+  }
+
+  if (!parse()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void PresetFile::close() {
+  if (m_mapped) {
+    m_file.unmap((uchar *)m_data);
+    m_mapped = false;
+  }
+  m_file.close();
+  m_contents.clear();
+  m_data = 0;
+  m_size = 0;
+  m_hash.clear();
+  m_sections.clear();
+}
+
+Byte PresetFile::pid() const { return m_pid; }
+
+Byte PresetFile::version() const { return m_version; }
+
+QString PresetFile::description() const { return m_description; }
+
+QByteArray PresetFile::hash() const { return m_hash; }
+
+const std::vector<PresetFile::Section> &PresetFile::sections() const {
+  return m_sections;
+}
+
+std::set<CmdEnum> PresetFile::families() const {
+  std::set<CmdEnum> result;
+  for (const auto &section : m_sections) {
+    result.insert(section.family);
+  }
+  return result;
+}
+
+bool PresetFile::hasStage(Stage stage) const {
+  return std::any_of(m_sections.begin(), m_sections.end(),
+                     [=](const Section &section) {
+    return section.stage == stage;
+  });
+}
+
+bool PresetFile::read(Stage stage, const std::set<CmdEnum> &families,
+                      Bytes &frames) const {
+  for (const auto &section : m_sections) {
+    if ((section.stage != stage) ||
+        ((!families.empty()) && (families.count(section.family) == 0))) {
+      continue;
+    }
+
+    if (!intact(section)) {
+      return false;
+    }
+    frames.insert(frames.end(), m_data + section.offset,
+                  m_data + section.offset + section.size);
+  }
+  return true;
+}
+
+bool PresetFile::verify() const {
+  return std::all_of(m_sections.begin(), m_sections.end(),
+                     [&](const Section &section) {
+    return intact(section);
+  });
+}
+
+bool PresetFile::parse() {
+  if ((m_size < kPresetHeaderSize) ||
+      (!std::equal(kPresetMagic, kPresetMagic + 3, m_data))) {
+    return false;
+  }
+
+  m_pid = m_data[3];
+  m_version = m_data[4];
+  m_description.clear();
+
+  qint64 position = kPresetHeaderSize;
+  if (m_version >= 0x02) {
+    if (m_size < position + 1 + m_data[position]) {
+      return false;
+    }
+    m_description = QString(QByteArray((const char *)m_data + position + 1,
+                                       m_data[position]));
+    position += 1 + m_data[position];
+  }
+
+  if (m_version < kPresetVersion3) {
+    return true;
+  }
+
+  if (m_size < position + 2) {
+    return false;
+  }
+  const int count = getWord(m_data + position);
+  const qint64 tableEnd = position + 2 + count * kSectionEntrySize;
+  if ((m_size < tableEnd + kHashSize) ||
+      (md5(m_data, tableEnd) !=
+       QByteArray::fromRawData((const char *)m_data + tableEnd, kHashSize))) {
+    return false;
+  }
+
+  m_hash = QByteArray((const char *)m_data + tableEnd, kHashSize);
+
+  position += 2;
+  for (int i = 0; i < count; ++i, position += kSectionEntrySize) {
+    Section section;
+    section.family = (CmdEnum)getWord(m_data + position);
+    section.stage = (m_data[position + 2] == PostReboot) ? PostReboot
+                                                         : PreReboot;
+    section.offset = getLong(m_data + position + 4);
+    section.size = getLong(m_data + position + 8);
+    section.hash = QByteArray((const char *)m_data + position + 12, kHashSize);
+
+    if ((qint64)section.offset + section.size > m_size) {
+      m_sections.clear();
+      return false;
+    }
+    m_sections.push_back(section);
+  }
+  return true;
+}
+
+bool PresetFile::intact(const Section &section) const {
+  return md5(m_data + section.offset, section.size) == section.hash;
+}
@@ -0,0 +1,108 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef PRESETFILE_H
+#define PRESETFILE_H
+
+#include "CommandDefines.h"
+#include "LibTypes.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <set>
+#include <vector>
+
+#define kPresetVersion3 0x03
+
+// A version 3 preset. The frames of each command family are kept in a
+// section of their own, listed in a table after the header, so one family
+// can be restored without reading the others:
+//
+//   69 43 4D, model, 03, description size, description
+//   section count (2 bytes), per section:
+//     family (2), stage (1), 0 (1), offset (4), size (4), MD5 (16)
+//   MD5 of everything above
+//   the sections, each the Ret frames of one family as in version 2
+//
+// Numbers are big endian and offsets count from the start of the file.
+// Both stages of a restore live in the same file, the post-reboot sections
+// are sent once the device is back. The file is memory mapped when the
+// platform allows, only the sections asked for are read and checked.
+//
+// Version 1 and 2 files open as well, with no sections; they are restored
+// whole by DeviceInfo::deserialize().
+class PresetFile {
+ public:
+  typedef enum Stage { PreReboot = 0, PostReboot = 1 } Stage;
+
+  struct Section {
+    GeneSysLib::CmdEnum family;
+    Stage stage;
+    quint32 offset;
+    quint32 size;
+    QByteArray hash;
+  };
+
+  // a section to write, the frames of one family
+  struct Content {
+    GeneSysLib::CmdEnum family;
+    Stage stage;
+    Bytes frames;
+  };
+
+  static Bytes build(Byte pid, const QString &description,
+                     const std::vector<Content> &contents);
+
+  explicit PresetFile(const QString &fileName);
+  ~PresetFile();
+
+  // maps the file and reads its header, for version 3 files the section
+  // table is checked against its hash as well
+  bool open();
+  void close();
+
+  Byte pid() const;
+  Byte version() const;
+  QString description() const;
+  QByteArray hash() const;  // of the header and section table
+
+  const std::vector<Section> &sections() const;
+  std::set<GeneSysLib::CmdEnum> families() const;
+  bool hasStage(Stage stage) const;
+
+  // Appends the frames of the stage's sections whose family is in
+  // `families`, or of all of them if it is empty. False if any of those
+  // sections is damaged.
+  bool read(Stage stage, const std::set<GeneSysLib::CmdEnum> &families,
+            Bytes &frames) const;
+
+  // every section is intact
+  bool verify() const;
+
+ private:
+  PresetFile(const PresetFile &);
+  PresetFile &operator=(const PresetFile &);
+
+  bool parse();
+  bool intact(const Section &section) const;
+
+  QFile m_file;
+  QByteArray m_contents;  // when the file could not be mapped
+  bool m_mapped;
+  const uchar *m_data;
+  qint64 m_size;
+
+  Byte m_pid;
+  Byte m_version;
+  QString m_description;
+  QByteArray m_hash;
+  std::vector<Section> m_sections;
+};
+
+#endif  // PRESETFILE_H
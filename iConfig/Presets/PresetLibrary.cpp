@@ -0,0 +1,349 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#include "PresetLibrary.h"
+#include "PresetFile.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#define kPresetIndexMagic 0x69435058  // "iCPX"
+#define kPresetIndexVersion 1
+#define kPresetHashSize 16
+
+using namespace GeneSysLib;
+
+namespace {
+
+// what every preset file starts with: i C M, the model and the version
+const char kPresetMagic[] = {0x69, 0x43, 0x4D};
+const int kPresetHeaderSize = 5;
+
+// where the frames of a preset start, past the header and description
+int bodyOffset(const PresetEntry &entry) {
+  return kPresetHeaderSize +
+         ((entry.version >= 0x02) ? 1 + entry.description.size() : 0);
+}
+
+QDataStream &operator<<(QDataStream &stream, const PresetEntry &entry) {
+  stream << entry.fileName << (quint8)entry.pid << (quint8)entry.version
+         << entry.description << entry.size << entry.modified
+         << entry.scanned << entry.valid << entry.hash
+         << (quint32)entry.families.size();
+  for (auto family : entry.families) {
+    stream << (quint16)family;
+  }
+  return stream;
+}
+
+QDataStream &operator>>(QDataStream &stream, PresetEntry &entry) {
+  quint8 pid = 0;
+  quint8 version = 0;
+  quint32 familyCount = 0;
+  stream >> entry.fileName >> pid >> version >> entry.description >>
+      entry.size >> entry.modified >> entry.scanned >> entry.valid >>
+      entry.hash >> familyCount;
+  entry.pid = pid;
+  entry.version = version;
+
+  entry.families.clear();
+  for (quint32 i = 0; (i < familyCount) && (stream.status() == QDataStream::Ok);
+       ++i) {
+    quint16 family = 0;
+    stream >> family;
+    entry.families.insert((CmdEnum)family);
+  }
+  return stream;
+}
+
+}  // namespace
+
+PresetEntry::PresetEntry()
+    : fileName(),
+      pid(0),
+      version(0),
+      description(),
+      size(0),
+      modified(0),
+      scanned(false),
+      valid(false),
+      hash(),
+      families() {}
+
+PresetLibrary::PresetLibrary(const QString &directory, QObject *parent)
+    : QObject(parent), m_directory(directory), m_entries(), m_watcher() {
+  QDir::root().mkpath(m_directory);
+  loadIndex();
+  if (refresh()) {
+    saveIndex();
+  }
+
+  m_watcher.addPath(m_directory);
+  connect(&m_watcher, SIGNAL(directoryChanged(QString)), this,
+          SLOT(directoryChanged(QString)));
+}
+
+PresetLibrary::~PresetLibrary() {}
+
+QString PresetLibrary::directory() const { return m_directory; }
+
+bool PresetLibrary::refresh() {
+  QDir dir(m_directory);
+  const auto files = dir.entryInfoList(QDir::Files | QDir::Readable);
+
+  bool changed = false;
+  Entries entries;
+  for (const auto &info : files) {
+    // the post-reboot half of a preset belongs to the file it is named after
+    if (info.suffix() == "aux") {
+      continue;
+    }
+
+    const QString fileName = info.fileName();
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+    const auto known = m_entries.find(fileName);
+    if ((known != m_entries.end()) && (known->size == info.size()) &&
+        (known->modified == modified)) {
+      entries.insert(fileName, *known);
+      continue;
+    }
+
+    PresetEntry entry;
+    entry.fileName = fileName;
+    entry.size = info.size();
+    entry.modified = modified;
+    if (readHeader(entry)) {
+      entries.insert(fileName, entry);
+    }
+    changed = true;
+  }
+
+  changed = changed || (entries.size() != m_entries.size());
+  m_entries.swap(entries);
+  return changed;
+}
+
+QList<PresetEntry> PresetLibrary::find(Word pid, const QString &text,
+                                       const std::set<CmdEnum> &families) {
+  bool scanned = false;
+  QList<PresetEntry> result;
+  for (auto &entry : m_entries) {
+    if ((entry.pid != (Byte)pid) ||
+        ((!text.isEmpty()) &&
+         (!entry.fileName.contains(text, Qt::CaseInsensitive)) &&
+         (!entry.description.contains(text, Qt::CaseInsensitive)))) {
+      continue;
+    }
+
+    if (!families.empty()) {
+      if (!entry.scanned) {
+        scanned = scan(entry) || scanned;
+      }
+      if (!std::includes(entry.families.begin(), entry.families.end(),
+                         families.begin(), families.end())) {
+        continue;
+      }
+    }
+
+    result.append(entry);
+  }
+
+  if (scanned) {
+    saveIndex();
+  }
+  return result;
+}
+
+const PresetEntry *PresetLibrary::lookup(const QString &fileName) const {
+  const auto found = m_entries.find(fileName);
+  return (found != m_entries.end()) ? &*found : 0;
+}
+
+const PresetEntry *PresetLibrary::entry(const QString &fileName) {
+  auto found = m_entries.find(fileName);
+  if (found == m_entries.end()) {
+    return 0;
+  }
+
+  if ((!found->scanned) && (scan(*found))) {
+    saveIndex();
+  }
+  return &*found;
+}
+
+bool PresetLibrary::verify(const QString &fileName,
+                           const QByteArray &contents) {
+  const QFileInfo info(fileName);
+  auto found = m_entries.find(info.fileName());
+  if ((found == m_entries.end()) ||
+      (info.absolutePath() != QFileInfo(m_directory).absoluteFilePath()) ||
+      (found->version >= kPresetVersion3) ||
+      (found->size != contents.size()) ||
+      (found->modified != info.lastModified().toMSecsSinceEpoch())) {
+    return false;
+  }
+
+  if (!found->scanned) {
+    scan(*found, contents);
+    saveIndex();
+  }
+  return (found->valid) && (contents.endsWith(found->hash));
+}
+
+void PresetLibrary::directoryChanged(const QString &) {
+  if (refresh()) {
+    saveIndex();
+    emit changed();
+  }
+}
+
+QString PresetLibrary::indexFileName() const {
+  return QDesktopServices::storageLocation(QDesktopServices::DataLocation) +
+         "/cache/presets.idx";
+}
+
+bool PresetLibrary::loadIndex() {
+  m_entries.clear();
+
+  QFile file(indexFileName());
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_4_6);
+
+  quint32 magic = 0;
+  quint32 version = 0;
+  QString directory;
+  quint32 count = 0;
+  stream >> magic >> version >> directory >> count;
+  if ((magic != kPresetIndexMagic) || (version != kPresetIndexVersion) ||
+      (directory != m_directory)) {
+    return false;
+  }
+
+  Entries entries;
+  for (quint32 i = 0; i < count; ++i) {
+    PresetEntry entry;
+    stream >> entry;
+    if (stream.status() != QDataStream::Ok) {
+      return false;
+    }
+    entries.insert(entry.fileName, entry);
+  }
+
+  m_entries.swap(entries);
+  return true;
+}
+
+bool PresetLibrary::saveIndex() const {
+  const QString fileName = indexFileName();
+  QDir::root().mkpath(QFileInfo(fileName).path());
+
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    return false;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_4_6);
+  stream << (quint32)kPresetIndexMagic << (quint32)kPresetIndexVersion
+         << m_directory << (quint32)m_entries.size();
+  for (const auto &entry : m_entries) {
+    stream << entry;
+  }
+  return stream.status() == QDataStream::Ok;
+}
+
+// the magic, model, version and description only
+bool PresetLibrary::readHeader(PresetEntry &entry) const {
+  QFile file(m_directory + "/" + entry.fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  const QByteArray header = file.read(kPresetHeaderSize + 1);
+  if ((header.size() < kPresetHeaderSize) ||
+      (!header.startsWith(QByteArray::fromRawData(kPresetMagic,
+                                                  sizeof(kPresetMagic))))) {
+    return false;
+  }
+
+  entry.pid = (Byte)header.at(3);
+  entry.version = (Byte)header.at(4);
+  entry.description.clear();
+  if ((entry.version >= 0x02) && (header.size() > kPresetHeaderSize)) {
+    const int descriptionSize = (Byte)header.at(kPresetHeaderSize);
+    entry.description = QString(file.read(descriptionSize));
+  }
+
+  entry.scanned = false;
+  entry.valid = false;
+  entry.hash.clear();
+  entry.families.clear();
+  return true;
+}
+
+// the whole file, for its hash and the families of its frames
+bool PresetLibrary::scan(PresetEntry &entry) const {
+  if (entry.version >= kPresetVersion3) {
+    // the section table lists the families, each section has its own hash
+    PresetFile preset(m_directory + "/" + entry.fileName);
+    entry.scanned = true;
+    entry.valid = (preset.open()) && (preset.verify());
+    entry.hash = preset.hash();
+    entry.families = preset.families();
+    return true;
+  }
+
+  QFile file(m_directory + "/" + entry.fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  scan(entry, file.readAll());
+  return true;
+}
+
+// the hash and families of a file before version 3, from all of it
+void PresetLibrary::scan(PresetEntry &entry, const QByteArray &contents) const {
+  entry.scanned = true;
+  entry.families.clear();
+
+  const int finish = contents.size() - kPresetHashSize;
+  if (finish < bodyOffset(entry)) {
+    entry.valid = false;
+    return;
+  }
+
+  entry.hash = contents.mid(finish);
+  entry.valid =
+      (QCryptographicHash::hash(QByteArray::fromRawData(contents.constData(),
+                                                        finish),
+                                QCryptographicHash::Md5) == entry.hash);
+
+  // the command of each frame is the word at bytes 14 and 15
+  const Byte *data = (const Byte *)contents.constData();
+  int start = contents.indexOf((char)0xF0, bodyOffset(entry));
+  while ((start >= 0) && (start + 16 <= finish)) {
+    entry.families.insert((CmdEnum)(((data[start + 14] << 7) & 0x3F80) |
+                                    (data[start + 15] & 0x7F)));
+    const int end = contents.indexOf((char)0xF7, start);
+    if ((end < 0) || (end >= finish)) {
+      break;
+    }
+    start = contents.indexOf((char)0xF0, end);
+  }
+}
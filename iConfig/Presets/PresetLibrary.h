@@ -0,0 +1,100 @@
+/*
+;iConfig source code and documentation is released under a GPLv3 license. 
+;
+; A copy is available from the Open Source Initiative site at:
+;	https://opensource.org/licenses/gpl-3.0.html
+*/
+
+#ifndef PRESETLIBRARY_H
+#define PRESETLIBRARY_H
+
+#include "CommandDefines.h"
+#include "LibTypes.h"
+
+#include <QByteArray>
+#include <QFileSystemWatcher>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QString>
+
+#include <set>
+
+// What the library knows of one preset file. The header fields are read as
+// soon as the file shows up; the families and hash need the whole file and
+// are only read once something asks for them.
+struct PresetEntry {
+  PresetEntry();
+
+  QString fileName;  // within the presets directory
+  Byte pid;          // the low byte, as the file stores it
+  Byte version;
+  QString description;
+  qint64 size;
+  qint64 modified;  // msec since the epoch
+
+  bool scanned;  // families, hash and valid are known
+  bool valid;    // the contents match their MD5 hashes
+  QByteArray hash;
+  std::set<GeneSysLib::CmdEnum> families;
+};
+
+// An index of the presets directory kept on disk next to the device cache,
+// so browsing hundreds of presets reads none of them. A file is only read
+// again when its size or modification time changes, and the directory is
+// watched so the index follows files being added, replaced or removed.
+class PresetLibrary : public QObject {
+  Q_OBJECT
+ public:
+  explicit PresetLibrary(const QString &directory, QObject *parent = 0);
+  ~PresetLibrary();
+
+  QString directory() const;
+
+  // Brings the index up to date with the directory, returns true if any
+  // entry was added, changed or removed
+  bool refresh();
+
+  // The presets of a model whose file name or description contains text and
+  // that hold every one of the families, by file name. Filtering on families
+  // reads the files not scanned yet.
+  QList<PresetEntry> find(
+      Word pid, const QString &text = QString(),
+      const std::set<GeneSysLib::CmdEnum> &families =
+          std::set<GeneSysLib::CmdEnum>());
+
+  // the entry as indexed, without reading the file, 0 if it is not a preset
+  const PresetEntry *lookup(const QString &fileName) const;
+
+  // the entry with its families and hash, 0 if the file is not a preset
+  const PresetEntry *entry(const QString &fileName);
+
+  // True if contents, just read from the file, are what was found intact
+  // and the file has not changed since, a restore need not check their hash
+  // again. A file not scanned yet is scanned from contents, so its hash is
+  // checked once for each change to it and the file is not read twice.
+  bool verify(const QString &fileName, const QByteArray &contents);
+
+ signals:
+  void changed();
+
+ private slots:
+  void directoryChanged(const QString &path);
+
+ private:
+  typedef QMap<QString, PresetEntry> Entries;
+
+  QString indexFileName() const;
+  bool loadIndex();
+  bool saveIndex() const;
+
+  bool readHeader(PresetEntry &entry) const;
+  bool scan(PresetEntry &entry) const;
+  void scan(PresetEntry &entry, const QByteArray &contents) const;
+
+  QString m_directory;
+  Entries m_entries;
+  QFileSystemWatcher m_watcher;
+};
+
+#endif  // PRESETLIBRARY_H
@@ -42,6 +42,7 @@ SOURCES +=                                                        \
     ./DeviceSelectionDialog.cpp                                   \
     ./Main.cpp                                                    \
     ./MainWindow.cpp                                              \
+    ./MeterPoller.cpp                                             \
     ./MySleep.cpp                                                 \
     ./RefreshObject.cpp                                           \
     ./RotatedLabel.cpp                                            \
@@ -74,11 +75,14 @@ SOURCES +=                                                        \
     QClickySlider.cpp \
     QClickyDbLabel.cpp \
     MixerRelated/HorizontalMeterWidget.cpp \
+    MixerRelated/MeterBar.cpp \
     MixerRelated/MixerChannelConfigWidget.cpp \
     AudioRelated/AudioChannelConfigWidget.cpp \
     DeviceInformationDialog.cpp \
     Presets/ICSaveDialog.cpp \
     Presets/ICRestoreDialog.cpp \
+    Presets/PresetFile.cpp \
+    Presets/PresetLibrary.cpp \
     FirmwareRelated/FirmwareCheckDialog.cpp
 
 HEADERS +=                                                        \
@@ -103,6 +107,7 @@ HEADERS +=                                                        \
     ./DeviceRebooter.h                                            \
     ./DeviceSelectionDialog.h                                     \
     ./MainWindow.h                                                \
+    ./MeterPoller.h                                               \
     ./MySleep.h                                                   \
     ./PortIDVector.h                                              \
     ./RefreshObject.h                                             \
@@ -142,11 +147,14 @@ HEADERS +=                                                        \
     QClickyDbLabel.h \
     IQClickyDbLabelAcceptor.h \
     MixerRelated/HorizontalMeterWidget.h \
+    MixerRelated/MeterBar.h \
     MixerRelated/MixerChannelConfigWidget.h \
     AudioRelated/AudioChannelConfigWidget.h \
     DeviceInformationDialog.h \
     Presets/ICSaveDialog.h \
     Presets/ICRestoreDialog.h \
+    Presets/PresetFile.h \
+    Presets/PresetLibrary.h \
     FirmwareRelated/FirmwareCheckDialog.h
 
 FORMS +=                                                          \